@@ -0,0 +1,305 @@
+/****************************************************************************
+*   FILE: BarnesHut.cpp
+*
+*   FUNCTION: This class calculates gravity between all bodies in a body
+*   store using a Barnes-Hut octree. Every calculation rebuilds the tree,
+*   sums up the mass and center of mass of every cell, and then lets every
+*   body be pulled by whole cells that are far enough away instead of by
+*   every single body in them.
+*
+*   PURPOSE: Calculating the pull between every pair of bodies grows with the
+*   square of the amount of bodies. The tree only grows with n*log(n), which
+*   makes spaces with many thousands of bodies possible to simulate at
+*   interactive rates, at the price of a small and tunable error.
+*
+****************************************************************************/
+
+#include "BarnesHut.h"
+#include <math.h>
+
+//  bodies closer together than this many splits share a leaf instead of
+//  splitting the cell forever
+const int MAX_DEPTH = 48;
+
+/****************************************************************************
+ * Constructors
+ *
+ ***************************************************************************/
+
+/**
+    Name: BarnesHut(double)
+    Function: Constructs a solver with the given opening angle. A cell is
+    treated as a single body when its side divided by its distance is less
+    than the opening angle. Zero gives the same result as summing every pair,
+    0.5 is a common trade-off between speed and accuracy.
+**/
+BarnesHut::BarnesHut(double theta)
+{
+    mTheta = theta;
+    mSoftening = 0;
+    mInteractionCount = 0;
+}
+
+/****************************************************************************
+* Member Functions
+*
+****************************************************************************/
+
+/**
+    Name: Split(int)
+    Function: Turns the leaf at the given index into a cell with eight empty
+    children. The children are always added after their parent, which is
+    what lets Build(BodyStore&) sum up the masses in a single backwards pass.
+**/
+void BarnesHut::Split(int index)
+{
+    Node parent = mNodes[index];
+    double quarter = parent.halfSize*0.5;
+    mNodes[index].firstChild = mNodes.size();
+    for(int octant = 0; octant < 8; octant++)
+    {
+        Node child;
+        child.centerX       = parent.centerX +
+                                ((octant & 1) ? quarter : -quarter);
+        child.centerY       = parent.centerY +
+                                ((octant & 2) ? quarter : -quarter);
+        child.centerZ       = parent.centerZ +
+                                ((octant & 4) ? quarter : -quarter);
+        child.halfSize      = quarter;
+        child.mass          = 0;
+        child.massX         = 0;
+        child.massY         = 0;
+        child.massZ         = 0;
+        child.firstChild    = -1;
+        child.firstBody     = -1;
+        mNodes.push_back(child);
+    }
+}
+
+/**
+    Name: Insert(BodyStore&, int)
+    Function: Walks down the tree to the leaf containing the body at the
+    given index and puts the body there. A leaf that already holds a body is
+    split and its body moved down one level, until the two bodies end up in
+    different leaves or the maximum depth is reached.
+**/
+void BarnesHut::Insert(BodyStore& bodies, int body)
+{
+    const double x = bodies.GetX()[body];
+    const double y = bodies.GetY()[body];
+    const double z = bodies.GetZ()[body];
+    int node = 0;
+    int depth = 0;
+    while(true)
+    {
+        Node& current = mNodes[node];
+        //  if the cell has children, continue in the one holding the body
+        if(current.firstChild != -1)
+        {
+            node = current.firstChild +
+                   (x >= current.centerX ? 1 : 0) +
+                   (y >= current.centerY ? 2 : 0) +
+                   (z >= current.centerZ ? 4 : 0);
+            depth++;
+            continue;
+        }
+        //  if the leaf is empty or can not be split any more, add the body
+        if(current.firstBody == -1 || depth >= MAX_DEPTH)
+        {
+            mNextBody[body] = current.firstBody;
+            current.firstBody = body;
+            return;
+        }
+        //  split the leaf and move its body down into one of the children
+        int moved = current.firstBody;
+        current.firstBody = -1;
+        Split(node);
+        Node& parent = mNodes[node];
+        int child = parent.firstChild +
+                    (bodies.GetX()[moved] >= parent.centerX ? 1 : 0) +
+                    (bodies.GetY()[moved] >= parent.centerY ? 2 : 0) +
+                    (bodies.GetZ()[moved] >= parent.centerZ ? 4 : 0);
+        mNodes[child].firstBody = moved;
+        mNextBody[moved] = -1;
+    }
+}
+
+/**
+    Name: Build(BodyStore&)
+    Function: Rebuilds the tree out of all bodies in the store. The root is
+    the smallest cube around all bodies. The node vector keeps its memory
+    between steps so that only the first build has to allocate.
+**/
+void BarnesHut::Build(BodyStore& bodies)
+{
+    const int count = bodies.GetCount();
+    const double* pX = bodies.GetX();
+    const double* pY = bodies.GetY();
+    const double* pZ = bodies.GetZ();
+    const double* pMass = bodies.GetMass();
+    mNodes.clear();
+    mNextBody.resize(count);
+    if(count == 0)
+        return;
+    /*  START: Find the bounds of all bodies    */
+    double minX = pX[0], maxX = pX[0];
+    double minY = pY[0], maxY = pY[0];
+    double minZ = pZ[0], maxZ = pZ[0];
+    for(int i = 1; i < count; i++)
+    {
+        if(pX[i] < minX) minX = pX[i];
+        if(pX[i] > maxX) maxX = pX[i];
+        if(pY[i] < minY) minY = pY[i];
+        if(pY[i] > maxY) maxY = pY[i];
+        if(pZ[i] < minZ) minZ = pZ[i];
+        if(pZ[i] > maxZ) maxZ = pZ[i];
+    }
+    Node root;
+    root.centerX    = (minX + maxX)*0.5;
+    root.centerY    = (minY + maxY)*0.5;
+    root.centerZ    = (minZ + maxZ)*0.5;
+    //  make the root slightly larger so that no body is on its edge
+    root.halfSize   = fmax(fmax(maxX - minX, maxY - minY), maxZ - minZ)*
+                      0.5*1.0001 + 1.0;
+    root.mass       = 0;
+    root.massX      = 0;
+    root.massY      = 0;
+    root.massZ      = 0;
+    root.firstChild = -1;
+    root.firstBody  = -1;
+    mNodes.push_back(root);
+    /*  END: Find the bounds of all bodies  */
+    for(int i = 0; i < count; i++)
+        Insert(bodies, i);
+    /*  START: Sum up the masses    */
+    //  children always come after their parent, so walking backwards sums
+    //  up every child before its parent
+    for(int n = mNodes.size() - 1; n >= 0; n--)
+    {
+        Node& node = mNodes[n];
+        double mass = 0, massX = 0, massY = 0, massZ = 0;
+        if(node.firstChild == -1)
+        {
+            for(int b = node.firstBody; b != -1; b = mNextBody[b])
+            {
+                mass  += pMass[b];
+                massX += pMass[b]*pX[b];
+                massY += pMass[b]*pY[b];
+                massZ += pMass[b]*pZ[b];
+            }
+        }
+        else
+        {
+            for(int c = node.firstChild; c < node.firstChild + 8; c++)
+            {
+                mass  += mNodes[c].mass;
+                massX += mNodes[c].mass*mNodes[c].massX;
+                massY += mNodes[c].mass*mNodes[c].massY;
+                massZ += mNodes[c].mass*mNodes[c].massZ;
+            }
+        }
+        node.mass = mass;
+        //  an empty cell keeps its center of mass at zero
+        node.massX = mass != 0 ? massX/mass : 0;
+        node.massY = mass != 0 ? massY/mass : 0;
+        node.massZ = mass != 0 ? massZ/mass : 0;
+    }
+    /*  END: Sum up the masses  */
+}
+
+/**
+    Name: CalculateGravity(BodyStore&, double*, double*, double*)
+    Function: Rebuilds the tree and adds the gravitational force on every
+    body in the store to the argument x, y and z force arrays. Every body
+    walks the tree from the root, and a cell that looks smaller than the
+    opening angle from the body pulls as a single body at its center of
+    mass. The square of the softening length is added to the square of
+    every distance a pull is calculated over, but not to the distance the
+    opening angle is measured against.
+**/
+void BarnesHut::CalculateGravity(BodyStore& bodies, double* pFx, double* pFy,
+                                 double* pFz)
+{
+    //  the universal gravitational constant
+    const double g = 6.67428e-11;
+    const double theta2 = mTheta*mTheta;
+    const double softening2 = mSoftening*mSoftening;
+    const int count = bodies.GetCount();
+    const double* pX = bodies.GetX();
+    const double* pY = bodies.GetY();
+    const double* pZ = bodies.GetZ();
+    const double* pMass = bodies.GetMass();
+    Build(bodies);
+    mInteractionCount = 0;
+    if(count == 0)
+        return;
+    //  a walk never holds more than seven siblings per level plus one
+    int stack[8*MAX_DEPTH + 8];
+    for(int i = 0; i < count; i++)
+    {
+        const double x = pX[i];
+        const double y = pY[i];
+        const double z = pZ[i];
+        double fx = 0;
+        double fy = 0;
+        double fz = 0;
+        long long interactions = 0;
+        int top = 0;
+        stack[top++] = 0;
+        while(top > 0)
+        {
+            const Node& node = mNodes[stack[--top]];
+            if(node.mass == 0)
+                continue;
+            if(node.firstChild == -1)
+            {
+                //  a leaf pulls with every body in it except this one
+                for(int b = node.firstBody; b != -1; b = mNextBody[b])
+                {
+                    double dx = pX[b] - x;
+                    double dy = pY[b] - y;
+                    double dz = pZ[b] - z;
+                    double length2 = dx*dx + dy*dy + dz*dz;
+                    if(b == i || length2 == 0)
+                        continue;
+                    length2 += softening2;
+                    double force = pMass[b]/(length2*sqrt(length2));
+                    fx += dx*force;
+                    fy += dy*force;
+                    fz += dz*force;
+                    interactions++;
+                }
+                continue;
+            }
+            double dx = node.massX - x;
+            double dy = node.massY - y;
+            double dz = node.massZ - z;
+            double length2 = dx*dx + dy*dy + dz*dz;
+            double size = node.halfSize*2;
+            //  if the cell is far enough away it pulls as a single body
+            if(size*size < theta2*length2)
+            {
+                length2 += softening2;
+                double force = node.mass/(length2*sqrt(length2));
+                fx += dx*force;
+                fy += dy*force;
+                fz += dz*force;
+                interactions++;
+            }
+            //  otherwise open it and visit its children, of which a flat
+            //  space leaves half empty
+            else
+            {
+                for(int c = node.firstChild; c < node.firstChild + 8; c++)
+                {
+                    if(mNodes[c].mass != 0)
+                        stack[top++] = c;
+                }
+            }
+        }
+        pFx[i] += g*pMass[i]*fx;
+        pFy[i] += g*pMass[i]*fy;
+        pFz[i] += g*pMass[i]*fz;
+        mInteractionCount += interactions;
+    }
+}
@@ -0,0 +1,85 @@
+/****************************************************************************
+*   FILE: BarnesHut.h
+*
+*   FUNCTION: This class calculates gravity between all bodies in a body
+*   store using a Barnes-Hut octree. Every calculation rebuilds the tree,
+*   sums up the mass and center of mass of every cell, and then lets every
+*   body be pulled by whole cells that are far enough away instead of by
+*   every single body in them.
+*
+*   PURPOSE: Calculating the pull between every pair of bodies grows with the
+*   square of the amount of bodies. The tree only grows with n*log(n), which
+*   makes spaces with many thousands of bodies possible to simulate at
+*   interactive rates, at the price of a small and tunable error.
+*
+****************************************************************************/
+
+#ifndef _BarnesHut_
+#define _BarnesHut_
+
+#include "BodyStore.h"
+#include <vector>
+
+class BarnesHut{
+    public:
+    /** Constructors    **/
+    //  constructs a solver with the given opening angle double
+    BarnesHut(double);
+    /** Member Functions   **/
+    //  adds the gravitational force on every body in the store to the
+    //  argument force arrays
+    void                CalculateGravity(BodyStore&, double*, double*,
+                                         double*);
+    /** Getters and Setters **/
+    double              GetTheta()
+                            {return mTheta;}
+    void                SetTheta(double theta)
+                            {mTheta = theta;}
+    //  the Plummer softening length in meters, 0 for none
+    double              GetSoftening()
+                            {return mSoftening;}
+    void                SetSoftening(double softening)
+                            {mSoftening = softening;}
+    int                 GetNodeCount()
+                            {return mNodes.size();}
+    //  the amount of bodies and cells that pulled on a body during the last
+    //  calculation, summed over all bodies
+    long long           GetInteractionCount()
+                            {return mInteractionCount;}
+
+    private:
+    //  a cubic cell of the tree
+    struct Node{
+        //  the center and half the side of the cell
+        double          centerX;
+        double          centerY;
+        double          centerZ;
+        double          halfSize;
+        //  the total mass and the center of mass of the cell
+        double          mass;
+        double          massX;
+        double          massY;
+        double          massZ;
+        //  the index of the first of eight children, -1 for a leaf
+        int             firstChild;
+        //  the first body in a leaf, -1 for an empty leaf
+        int             firstBody;
+    };
+
+    //  builds the tree out of all bodies in the store
+    void                Build(BodyStore&);
+    //  inserts the body at the given index into the tree
+    void                Insert(BodyStore&, int);
+    //  splits a leaf into eight children
+    void                Split(int);
+
+    /** Class Members   **/
+    double              mTheta;
+    double              mSoftening;
+    long long           mInteractionCount;
+    std::vector<Node>   mNodes;
+    //  the next body in the same leaf, -1 for the last
+    std::vector<int>    mNextBody;
+};
+
+#endif
@@ -0,0 +1,452 @@
+/****************************************************************************
+*   FILE: Batch.cpp
+*
+*   FUNCTION: The file containing the main function of the batch runner. The
+*   batch runner steps a space without any window or graphics, for a given
+*   amount of steps or simulated seconds, as fast as the machine allows, and
+*   reports how fast it went.
+*
+*   PURPOSE: The window application is tied to GLUT and to the speed of the
+*   screen. The batch runner only needs the simulation core, so it builds
+*   and runs on machines without any display, such as compute nodes.
+*
+*   USAGE: Batch [options]
+*       --steps N       run N steps (default 10000)
+*       --time T        run until T seconds have been simulated instead
+*       --dt S          simulate S seconds per step (default 150)
+*       --solver NAME   direct or barneshut (default direct)
+*       --precision NAME
+*                       double or mixed, the precision of the direct sum
+*                       (default double)
+*       --theta X       the Barnes-Hut opening angle (default 0.5)
+*       --softening L   soften gravity over L meters (default 0)
+*       --collisions S  merge bodies that touch, with a radius of one
+*                       standing for S meters, 0 turns merging off
+*                       (default off)
+*       --threads N     split the direct sum over N threads (default 1)
+*       --kernel NAME   scalar, sse2, avx2 or avx512 (default the widest)
+*       --integrator NAME
+*                       euler, leapfrog, verlet, yoshida, block or
+*                       wisdomholman (default euler)
+*       --accuracy X    the step accuracy of the block integrator
+*                       (default 0.02)
+*       --scenario FILE start from the bodies in a scenario file instead
+*                       of the solar system, with its time unless --dt is
+*                       given as well
+*       --plummer N     start from a Plummer sphere of N solar masses
+*                       with a scale radius of 1000 astronomical units
+*       --disk N        start from a sun with an exponential disk of N
+*                       bodies, of a hundredth of its mass, with a scale
+*                       length of 10 astronomical units
+*       --binaries N    start from N binary stars in a disk of
+*                       100*sqrt(N) astronomical units
+*       --belt NAME,N,INNER,OUTER
+*                       add a belt of N asteroids between INNER and OUTER
+*                       astronomical units around the body called NAME,
+*                       with a billionth of its mass, may be repeated
+*       --seed S        the seed of the generated bodies (default 1)
+*       --load FILE     start from a checkpoint instead of the solar
+*                       system, keeping its step, solver, precision,
+*                       softening, collisions and integrator unless they
+*                       are given as well
+*       --save FILE     write a checkpoint after the run
+*       --trajectory FILE
+*                       write the bodies to a trajectory file
+*       --every K       record every K steps (default 1)
+*       --stride N      record every N bodies (default 1)
+*       --chunk N       gather N frames per chunk (default 64)
+*       --compress      compress the trajectory columns
+*       --print         print the final state of every body
+*       --error         print how far the forces of the solver are from
+*                       the double precision direct sum, before and after
+*                       the run
+*
+****************************************************************************/
+
+#include "Space.h"
+#include "Scenario.h"
+#include "BlockTimestepIntegrator.h"
+#include "Checkpoint.h"
+#include "Generator.h"
+#include "TrajectorySink.h"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+    Name: PrintUsage()
+    Function: Prints the options of the batch runner.
+**/
+static void PrintUsage()
+{
+    printf("usage: Batch [--steps N] [--time T] [--dt S]\n"
+           "             [--solver direct|barneshut] [--theta X]\n"
+           "             [--precision double|mixed]\n"
+           "             [--softening L] [--collisions S]\n"
+           "             [--threads N] [--kernel scalar|sse2|avx2|avx512]\n"
+           "             [--integrator euler|leapfrog|verlet|yoshida|"
+           "block|wisdomholman]\n"
+           "             [--accuracy X] [--scenario FILE]\n"
+           "             [--plummer N] [--disk N] [--binaries N]\n"
+           "             [--belt NAME,N,INNER,OUTER]... [--seed S]\n"
+           "             [--load FILE] [--save FILE]\n"
+           "             [--trajectory FILE] [--every K] [--stride N]\n"
+           "             [--chunk N] [--compress]\n"
+           "             [--print] [--error]\n");
+}
+
+/**
+    Name: main(int, char*)
+    Function: Reads the options, creates the space, runs it and prints the
+    throughput.
+**/
+int main(int argc, char* argv[]){
+    /*  START: Read the options */
+    long long steps = 10000;
+    double simulatedTime = 0;
+    //  the settings below zero are left at their default, or at the value
+    //  in the checkpoint when one is loaded
+    int timeStep = -1;
+    int solver = -1;
+    int precision = -1;
+    double theta = -1;
+    double softening = -1;
+    double collisions = -1;
+    int threads = 1;
+    int kernel = -1;
+    int integrator = -1;
+    double accuracy = 0.02;
+    const char* pScenarioPath = 0;
+    int plummer = 0;
+    int disk = 0;
+    int binaries = 0;
+    std::vector<const char*> belts;
+    unsigned int seed = 1;
+    const char* pLoadPath = 0;
+    const char* pSavePath = 0;
+    const char* pTrajectoryPath = 0;
+    TrajectorySink sink;
+    bool print = false;
+    bool reportError = false;
+    for(int i = 1; i < argc; i++)
+    {
+        //  every option except --print, --error and --compress takes a
+        //  value
+        const char* pValue = i + 1 < argc ? argv[i + 1] : 0;
+        if(strcmp(argv[i], "--print") == 0)
+        {
+            print = true;
+            continue;
+        }
+        if(strcmp(argv[i], "--error") == 0)
+        {
+            reportError = true;
+            continue;
+        }
+        if(strcmp(argv[i], "--compress") == 0)
+        {
+            sink.SetCompress(true);
+            continue;
+        }
+        if(pValue == 0)
+        {
+            PrintUsage();
+            return 1;
+        }
+        if(strcmp(argv[i], "--steps") == 0)
+            steps = atoll(pValue);
+        else if(strcmp(argv[i], "--time") == 0)
+            simulatedTime = atof(pValue);
+        else if(strcmp(argv[i], "--dt") == 0)
+            timeStep = atoi(pValue);
+        else if(strcmp(argv[i], "--solver") == 0)
+            solver = strcmp(pValue, "barneshut") == 0 ?
+                     GRAVITY_BARNES_HUT : GRAVITY_DIRECT;
+        else if(strcmp(argv[i], "--precision") == 0)
+            precision = strcmp(pValue, "mixed") == 0 ?
+                        PRECISION_MIXED : PRECISION_DOUBLE;
+        else if(strcmp(argv[i], "--theta") == 0)
+            theta = atof(pValue);
+        else if(strcmp(argv[i], "--softening") == 0)
+            softening = atof(pValue);
+        else if(strcmp(argv[i], "--collisions") == 0)
+            collisions = atof(pValue);
+        else if(strcmp(argv[i], "--threads") == 0)
+            threads = atoi(pValue);
+        else if(strcmp(argv[i], "--kernel") == 0)
+        {
+            if(strcmp(pValue, "scalar") == 0)
+                kernel = KERNEL_SCALAR;
+            else if(strcmp(pValue, "sse2") == 0)
+                kernel = KERNEL_SSE2;
+            else if(strcmp(pValue, "avx2") == 0)
+                kernel = KERNEL_AVX2;
+            else
+                kernel = KERNEL_AVX512;
+        }
+        else if(strcmp(argv[i], "--integrator") == 0)
+        {
+            if(strcmp(pValue, "leapfrog") == 0)
+                integrator = INTEGRATOR_LEAPFROG;
+            else if(strcmp(pValue, "verlet") == 0)
+                integrator = INTEGRATOR_VELOCITY_VERLET;
+            else if(strcmp(pValue, "yoshida") == 0)
+                integrator = INTEGRATOR_YOSHIDA;
+            else if(strcmp(pValue, "block") == 0)
+                integrator = INTEGRATOR_BLOCK_TIMESTEP;
+            else if(strcmp(pValue, "wisdomholman") == 0)
+                integrator = INTEGRATOR_WISDOM_HOLMAN;
+            else
+                integrator = INTEGRATOR_EULER;
+        }
+        else if(strcmp(argv[i], "--accuracy") == 0)
+            accuracy = atof(pValue);
+        else if(strcmp(argv[i], "--scenario") == 0)
+            pScenarioPath = pValue;
+        else if(strcmp(argv[i], "--plummer") == 0)
+            plummer = atoi(pValue);
+        else if(strcmp(argv[i], "--disk") == 0)
+            disk = atoi(pValue);
+        else if(strcmp(argv[i], "--binaries") == 0)
+            binaries = atoi(pValue);
+        else if(strcmp(argv[i], "--belt") == 0)
+            belts.push_back(pValue);
+        else if(strcmp(argv[i], "--seed") == 0)
+            seed = strtoul(pValue, 0, 10);
+        else if(strcmp(argv[i], "--load") == 0)
+            pLoadPath = pValue;
+        else if(strcmp(argv[i], "--save") == 0)
+            pSavePath = pValue;
+        else if(strcmp(argv[i], "--trajectory") == 0)
+            pTrajectoryPath = pValue;
+        else if(strcmp(argv[i], "--every") == 0)
+            sink.SetInterval(atoi(pValue));
+        else if(strcmp(argv[i], "--stride") == 0)
+            sink.SetStride(atoi(pValue));
+        else if(strcmp(argv[i], "--chunk") == 0)
+            sink.SetChunkFrames(atoi(pValue));
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+        i++;
+    }
+    //  a step given has to be positive
+    if(timeStep == 0 || timeStep < -1)
+    {
+        PrintUsage();
+        return 1;
+    }
+    /*  END: Read the options   */
+
+    /*  START: Create the universe   */
+    Space space(timeStep > 0 ? timeStep : 150);
+    std::string error;
+    if(pLoadPath != 0)
+    {
+        if(!Checkpoint::Load(space, pLoadPath))
+        {
+            printf("could not load %s\n", pLoadPath);
+            return 1;
+        }
+    }
+    else if(pScenarioPath != 0)
+    {
+        if(!Scenario::Load(space, pScenarioPath, error))
+        {
+            printf("%s\n", error.c_str());
+            return 1;
+        }
+    }
+    else if(plummer <= 0 && disk <= 0 && binaries <= 0)
+    {
+        Scenario::CreateSolarSystem(space);
+    }
+    /*  START: Generate bodies    */
+    //  every generator gets a seed of its own
+    const double au = 149598e6;
+    const double solarMass = 1.9891e30;
+    if(plummer > 0)
+        Generator::CreatePlummerSphere(space, plummer, plummer*solarMass,
+                                       1000*au, seed);
+    if(disk > 0)
+        Generator::CreateExponentialDisk(space, disk, solarMass,
+                                         solarMass/100, 10*au, seed + 1);
+    if(binaries > 0)
+        Generator::CreateBinaryStars(space, binaries,
+                                     100*sqrt((double)binaries)*au,
+                                     seed + 2);
+    for(unsigned int i = 0; i < belts.size(); i++)
+    {
+        char name[64];
+        int count = 0;
+        double inner = 0;
+        double outer = 0;
+        if(sscanf(belts[i], "%63[^,],%d,%lf,%lf", name, &count, &inner,
+                  &outer) != 4 || count <= 0 || inner <= 0 ||
+           outer < inner)
+        {
+            PrintUsage();
+            return 1;
+        }
+        //  the belt weighs a billionth of the body it circles
+        BodyStore& bodies = space.GetBodies();
+        const int owner = bodies.Find(name);
+        if(owner == -1)
+        {
+            printf("there is no body called %s\n", name);
+            return 1;
+        }
+        Generator::CreateAsteroidBelt(space, name, count, inner*au,
+                                      outer*au, bodies.GetMass()[owner]*1e-9,
+                                      seed + 3 + i);
+    }
+    /*  END: Generate bodies  */
+    if(timeStep > 0)
+        space.SetTime(timeStep);
+    timeStep = space.GetTime();
+    if(solver >= 0)
+        space.SetGravitySolver((GravitySolver)solver);
+    if(precision >= 0)
+        space.SetGravityPrecision((GravityPrecision)precision);
+    if(theta >= 0)
+        space.SetOpeningAngle(theta);
+    if(softening >= 0)
+        space.SetSoftening(softening);
+    if(collisions >= 0)
+    {
+        space.SetMergeCollisions(collisions > 0);
+        if(collisions > 0)
+            space.SetRadiusScale(collisions);
+    }
+    space.SetThreadCount(threads);
+    if(kernel >= 0)
+        space.SetGravityKernel((KernelLevel)kernel);
+    //  setting the integrator again would throw away a loaded state
+    if(integrator >= 0 && integrator != space.GetIntegratorType())
+        space.SetIntegrator((IntegratorType)integrator);
+    //  a simulated time overrides the amount of steps
+    if(simulatedTime > 0)
+        steps = (long long)(simulatedTime/timeStep + 0.5);
+    if(space.GetIntegratorType() == INTEGRATOR_BLOCK_TIMESTEP)
+        static_cast<BlockTimestepIntegrator*>(
+            space.GetIntegrator())->SetAccuracy(accuracy);
+    if(pTrajectoryPath != 0)
+    {
+        if(!sink.Open(pTrajectoryPath))
+        {
+            printf("could not open %s\n", pTrajectoryPath);
+            return 1;
+        }
+        space.SetTrajectorySink(&sink);
+    }
+    /*  END: Create the universe */
+
+    /*  START: Run the space    */
+    const int startBodies = space.GetBodies().GetCount();
+    double startEnergy = space.CalculateEnergy();
+    GravityError startError = {0, 0, 0};
+    if(reportError)
+        startError = space.CompareGravitySolvers();
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    //  the amount of bodies whose force was calculated
+    long long evaluations = 0;
+    for(long long step = 0; step < steps; step++)
+    {
+        space.Step();
+        if(space.GetIntegratorType() == INTEGRATOR_BLOCK_TIMESTEP)
+            evaluations += static_cast<BlockTimestepIntegrator*>(
+                space.GetIntegrator())->GetForceEvaluations();
+    }
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    //  the wait for the last chunks to be written is not timed
+    if(pTrajectoryPath != 0)
+    {
+        space.SetTrajectorySink(0);
+        if(!sink.Close())
+        {
+            printf("could not write %s\n", pTrajectoryPath);
+            return 1;
+        }
+    }
+    /*  END: Run the space  */
+
+    /*  START: Report   */
+    const int bodies = space.GetBodies().GetCount();
+    if(print)
+    {
+        BodyStore& store = space.GetBodies();
+        for(int i = 0; i < bodies; i++)
+        {
+            printf("%-10s %.9e %.9e %.9e %.9e %.9e %.9e\n",
+                   store.GetInfo(i).name.c_str(),
+                   store.GetX()[i], store.GetY()[i], store.GetZ()[i],
+                   store.GetVx()[i], store.GetVy()[i], store.GetVz()[i]);
+        }
+    }
+    //  avoid dividing by zero on very short runs
+    double rate = seconds > 0 ? 1/seconds : 0;
+    printf("bodies:                  %d\n", bodies);
+    printf("solver:                  %s\n",
+           space.GetGravitySolver() == GRAVITY_DIRECT ?
+           "direct" : "barneshut");
+    if(space.GetGravitySolver() == GRAVITY_DIRECT)
+    {
+        printf("precision:               %s\n",
+               space.GetGravityPrecision() == PRECISION_MIXED ?
+               "mixed" : "double");
+        printf("kernel:                  %s\n",
+               GravityKernel::GetName(space.GetGravityKernel()));
+        printf("threads:                 %d\n", space.GetThreadCount());
+    }
+    if(space.GetSoftening() > 0)
+        printf("softening:               %.6g m\n", space.GetSoftening());
+    if(space.GetMergeCollisions())
+        printf("bodies merged:           %d\n", startBodies - bodies);
+    printf("integrator:              %s\n",
+           space.GetIntegrator()->GetName());
+    printf("steps:                   %lld\n", steps);
+    if(space.GetIntegratorType() == INTEGRATOR_BLOCK_TIMESTEP)
+        printf("body forces per step:    %.6g\n",
+               steps > 0 ? (double)evaluations/steps : 0.0);
+    printf("simulated seconds:       %.6g\n", (double)steps*timeStep);
+    printf("wall seconds:            %.6g\n", seconds);
+    printf("steps per second:        %.6g\n", steps*rate);
+    printf("body steps per second:   %.6g\n", (double)bodies*steps*rate);
+    printf("simulated seconds per wall second: %.6g\n",
+           (double)steps*timeStep*rate);
+    if(pTrajectoryPath != 0)
+    {
+        printf("trajectory frames:       %lld\n", sink.GetFrames());
+        printf("trajectory bytes:        %lld of %lld\n",
+               sink.GetWrittenBytes(), sink.GetRawBytes());
+        printf("trajectory stalls:       %lld\n", sink.GetStalls());
+    }
+    //  the energy is calculated outside the timed loop
+    double endEnergy = space.CalculateEnergy();
+    printf("relative energy drift:   %.6g\n", startEnergy != 0 ?
+           (endEnergy - startEnergy)/fabs(startEnergy) : 0.0);
+    if(reportError)
+    {
+        //  compared with the double precision direct sum
+        GravityError endError = space.CompareGravitySolvers();
+        printf("force error at start:    mean %.3g rms %.3g max %.3g\n",
+               startError.meanRelative, startError.rmsRelative,
+               startError.maxRelative);
+        printf("force error at end:      mean %.3g rms %.3g max %.3g\n",
+               endError.meanRelative, endError.rmsRelative,
+               endError.maxRelative);
+    }
+    /*  END: Report */
+    if(pSavePath != 0 && !Checkpoint::Save(space, pSavePath))
+    {
+        printf("could not save %s\n", pSavePath);
+        return 1;
+    }
+    return 0;
+}
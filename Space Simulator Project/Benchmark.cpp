@@ -0,0 +1,385 @@
+/****************************************************************************
+*   FILE: Benchmark.cpp
+*
+*   FUNCTION: The file containing the main function of the benchmark. The
+*   benchmark builds synthetic spaces of growing size, times the gravity
+*   calculation, the passing of time and a full step separately for every
+*   solver, and writes the results both as a table and as CSV and JSON files.
+*
+*   PURPOSE: To notice when a change makes the physics slower, and to follow
+*   the speed of the simulation from release to release.
+*
+*   USAGE: Benchmark [options]
+*       --min N         the smallest space (default 10)
+*       --max N         the largest space (default 1000000)
+*       --max-direct N  the largest space timed with the direct sum
+*                       (default 100000)
+*       --solvers LIST  any of direct, mixed and barneshut separated by
+*                       commas, mixed being the direct sum in mixed
+*                       precision (default all three)
+*       --theta X       the Barnes-Hut opening angle (default 0.5)
+*       --threads N     split the direct sum over N threads (default 1)
+*       --kernel NAME   scalar, sse2, avx2 or avx512 (default the widest)
+*       --seconds S     time every measurement for at least S seconds
+*                       (default 0.2)
+*       --csv FILE      write the results as CSV (default benchmark.csv)
+*       --json FILE     write the results as JSON (default benchmark.json)
+*
+****************************************************************************/
+
+#include "Space.h"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+//  the result of timing one solver on one space
+struct BenchmarkResult{
+    std::string     solver;
+    int             bodies;
+    //  how many times every part was run
+    long long       gravityRuns;
+    long long       passTimeRuns;
+    long long       stepRuns;
+    //  nanoseconds per run
+    double          gravityTime;
+    double          passTimeTime;
+    double          stepTime;
+    long long       interactions;
+};
+
+/**
+    Name: CreateSyntheticSpace(Space&, int, unsigned int)
+    Function: Fills the space with a star and bodies on circular orbits
+    between 0.3 and 30 astronomical units, at random angles and distances
+    picked from the seed. The same seed always gives the same space.
+**/
+static void CreateSyntheticSpace(Space& space, int count, unsigned int seed)
+{
+    const double g = 6.67428e-11;
+    const double au = 149598e6;
+    const double starMass = 1.9891e30;
+    space.ReserveObjects(count);
+    space.AddObjectToSpace(new Star("Star", starMass, 0.025,
+                                    Vec3d(0, 0), Vec3d(0, 0),
+                                    1.0, 1.0, 0.0));
+    std::vector<Planet*> planets;
+    planets.reserve(count - 1);
+    //  the planets are created from one piece of memory
+    SpaceObject::Reserve<Planet>(count - 1);
+    for(int i = 1; i < count; i++)
+    {
+        //  a simple linear congruential generator keeps the space the same
+        //  on every machine
+        seed = seed*1664525u + 1013904223u;
+        double angle = (seed >> 8)*(2*3.1415926/16777216.0);
+        seed = seed*1664525u + 1013904223u;
+        double distance = au*(0.3 + 29.7*((seed >> 8)/16777216.0));
+        double speed = sqrt(g*starMass/distance);
+        planets.push_back(new Planet("Body", 1e20, 0.003,
+                              Vec3d(distance*cos(angle),
+                                    distance*sin(angle)),
+                              Vec3d(-speed*sin(angle),
+                                    speed*cos(angle)),
+                              0.6, 0.6, 0.6));
+    }
+    space.AddObjectsToSpace(planets);
+}
+
+/**
+    Name: Seconds(std::chrono::steady_clock::time_point)
+    Function: Returns the seconds passed since the argument time.
+**/
+static double Seconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+    Name: SetUpSpace(Space&, int, int, double, int, int)
+    Function: Fills the space with the synthetic bodies of the given amount
+    and sets the solver of the given number (direct, mixed or Barnes-Hut),
+    the opening angle, the threads and the kernel, unless it is below zero.
+**/
+static void SetUpSpace(Space& space, int bodies, int solver, double theta,
+                       int threads, int kernel)
+{
+    CreateSyntheticSpace(space, bodies, 12345);
+    space.SetGravitySolver(solver == 2 ? GRAVITY_BARNES_HUT
+                                       : GRAVITY_DIRECT);
+    if(solver == 1)
+        space.SetGravityPrecision(PRECISION_MIXED);
+    space.SetOpeningAngle(theta);
+    space.SetThreadCount(threads);
+    if(kernel >= 0)
+        space.SetGravityKernel((KernelLevel)kernel);
+}
+
+/**
+    Name: TimeGravity(Space&, double, long long&)
+    Function: Runs the gravity calculation until at least the given amount
+    of seconds have passed and returns the nanoseconds per run. The forces
+    are cleared before every run, as a step does, so that they do not add
+    up over the runs.
+**/
+static double TimeGravity(Space& space, double minimum, long long& runs)
+{
+    runs = 0;
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    do
+    {
+        space.ClearForces();
+        space.CalculateGravity();
+        runs++;
+    }while(Seconds(start) < minimum);
+    return Seconds(start)*1e9/runs;
+}
+
+/**
+    Name: TimePassTime(Space&, double, long long&)
+    Function: Runs the passing of time until at least the given amount of
+    seconds have passed and returns the nanoseconds per run.
+**/
+static double TimePassTime(Space& space, double minimum, long long& runs)
+{
+    runs = 0;
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    do
+    {
+        space.PassTime();
+        runs++;
+    }while(Seconds(start) < minimum);
+    return Seconds(start)*1e9/runs;
+}
+
+/**
+    Name: TimeStep(Space&, double, long long&)
+    Function: Runs full steps until at least the given amount of seconds
+    have passed and returns the nanoseconds per step.
+**/
+static double TimeStep(Space& space, double minimum, long long& runs)
+{
+    runs = 0;
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    do
+    {
+        space.Step();
+        runs++;
+    }while(Seconds(start) < minimum);
+    return Seconds(start)*1e9/runs;
+}
+
+/**
+    Name: WriteCsv(const char*, std::vector<BenchmarkResult>&)
+    Function: Writes one line per result to the CSV file.
+**/
+static bool WriteCsv(const char* pPath, std::vector<BenchmarkResult>& results)
+{
+    FILE* pFile = fopen(pPath, "w");
+    if(pFile == 0)
+        return false;
+    fprintf(pFile, "solver,bodies,gravity_ns,pass_time_ns,step_ns,"
+                   "interactions,ns_per_interaction,"
+                   "body_steps_per_second\n");
+    for(unsigned int i = 0; i < results.size(); i++)
+    {
+        BenchmarkResult& r = results[i];
+        fprintf(pFile, "%s,%d,%.6g,%.6g,%.6g,%lld,%.6g,%.6g\n",
+                r.solver.c_str(), r.bodies, r.gravityTime, r.passTimeTime,
+                r.stepTime, r.interactions,
+                r.interactions > 0 ? r.gravityTime/r.interactions : 0.0,
+                r.bodies*1e9/r.stepTime);
+    }
+    fclose(pFile);
+    return true;
+}
+
+/**
+    Name: WriteJson(const char*, std::vector<BenchmarkResult>&,
+                    const char*, int, double)
+    Function: Writes the settings and all results to the JSON file.
+**/
+static bool WriteJson(const char* pPath,
+                      std::vector<BenchmarkResult>& results,
+                      const char* pKernel, int threads, double theta)
+{
+    FILE* pFile = fopen(pPath, "w");
+    if(pFile == 0)
+        return false;
+    fprintf(pFile, "{\n  \"format\": 1,\n  \"kernel\": \"%s\",\n"
+                   "  \"threads\": %d,\n  \"theta\": %g,\n"
+                   "  \"results\": [\n", pKernel, threads, theta);
+    for(unsigned int i = 0; i < results.size(); i++)
+    {
+        BenchmarkResult& r = results[i];
+        fprintf(pFile, "    {\"solver\": \"%s\", \"bodies\": %d, "
+                       "\"gravity_ns\": %.6g, \"gravity_runs\": %lld, "
+                       "\"pass_time_ns\": %.6g, \"pass_time_runs\": %lld, "
+                       "\"step_ns\": %.6g, \"step_runs\": %lld, "
+                       "\"interactions\": %lld, "
+                       "\"ns_per_interaction\": %.6g, "
+                       "\"body_steps_per_second\": %.6g}%s\n",
+                r.solver.c_str(), r.bodies, r.gravityTime, r.gravityRuns,
+                r.passTimeTime, r.passTimeRuns, r.stepTime, r.stepRuns,
+                r.interactions,
+                r.interactions > 0 ? r.gravityTime/r.interactions : 0.0,
+                r.bodies*1e9/r.stepTime,
+                i + 1 < results.size() ? "," : "");
+    }
+    fprintf(pFile, "  ]\n}\n");
+    fclose(pFile);
+    return true;
+}
+
+/**
+    Name: PrintUsage()
+    Function: Prints the options of the benchmark.
+**/
+static void PrintUsage()
+{
+    printf("usage: Benchmark [--min N] [--max N] [--max-direct N]\n"
+           "                 [--solvers direct,mixed,barneshut]\n"
+           "                 [--theta X] [--threads N]\n"
+           "                 [--kernel scalar|sse2|avx2|avx512]\n"
+           "                 [--seconds S] [--csv FILE] [--json FILE]\n");
+}
+
+/**
+    Name: main(int, char*)
+    Function: Reads the options, times every solver on every space size and
+    writes the results.
+**/
+int main(int argc, char* argv[]){
+    /*  START: Read the options */
+    int minimum = 10;
+    int maximum = 1000000;
+    int maximumDirect = 100000;
+    bool runDirect = true;
+    bool runMixed = true;
+    bool runBarnesHut = true;
+    double theta = 0.5;
+    int threads = 1;
+    int kernel = -1;
+    double seconds = 0.2;
+    const char* pCsv = "benchmark.csv";
+    const char* pJson = "benchmark.json";
+    for(int i = 1; i < argc; i += 2)
+    {
+        //  every option takes a value
+        const char* pValue = i + 1 < argc ? argv[i + 1] : 0;
+        if(pValue == 0)
+        {
+            PrintUsage();
+            return 1;
+        }
+        if(strcmp(argv[i], "--min") == 0)
+            minimum = atoi(pValue);
+        else if(strcmp(argv[i], "--max") == 0)
+            maximum = atoi(pValue);
+        else if(strcmp(argv[i], "--max-direct") == 0)
+            maximumDirect = atoi(pValue);
+        else if(strcmp(argv[i], "--solvers") == 0)
+        {
+            runDirect = strstr(pValue, "direct") != 0;
+            runMixed = strstr(pValue, "mixed") != 0;
+            runBarnesHut = strstr(pValue, "barneshut") != 0;
+        }
+        else if(strcmp(argv[i], "--theta") == 0)
+            theta = atof(pValue);
+        else if(strcmp(argv[i], "--threads") == 0)
+            threads = atoi(pValue);
+        else if(strcmp(argv[i], "--kernel") == 0)
+        {
+            if(strcmp(pValue, "scalar") == 0)
+                kernel = KERNEL_SCALAR;
+            else if(strcmp(pValue, "sse2") == 0)
+                kernel = KERNEL_SSE2;
+            else if(strcmp(pValue, "avx2") == 0)
+                kernel = KERNEL_AVX2;
+            else
+                kernel = KERNEL_AVX512;
+        }
+        else if(strcmp(argv[i], "--seconds") == 0)
+            seconds = atof(pValue);
+        else if(strcmp(argv[i], "--csv") == 0)
+            pCsv = pValue;
+        else if(strcmp(argv[i], "--json") == 0)
+            pJson = pValue;
+        else
+        {
+            printf("unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if(minimum < 2)
+        minimum = 2;
+    /*  END: Read the options   */
+
+    /*  START: Time every solver on every size  */
+    std::vector<BenchmarkResult> results;
+    const char* pKernel = "";
+    printf("%-10s %9s %14s %14s %14s %10s %14s\n", "solver", "bodies",
+           "gravity ns", "pass time ns", "step ns", "ns/inter",
+           "body steps/s");
+    for(double size = minimum; size <= maximum*1.0001; size *= 10)
+    {
+        const int bodies = (int)(size + 0.5);
+        for(int solver = 0; solver < 3; solver++)
+        {
+            if(solver == 0 && (!runDirect || bodies > maximumDirect))
+                continue;
+            if(solver == 1 && (!runMixed || bodies > maximumDirect))
+                continue;
+            if(solver == 2 && !runBarnesHut)
+                continue;
+            BenchmarkResult result;
+            const char* pNames[] = {"direct", "mixed", "barneshut"};
+            result.solver = pNames[solver];
+            result.bodies = bodies;
+            //  every measurement starts from the same space, built again
+            //  since the ones before have moved the bodies
+            {
+                Space space(150);
+                SetUpSpace(space, bodies, solver, theta, threads, kernel);
+                pKernel = GravityKernel::GetName(space.GetGravityKernel());
+                result.gravityTime = TimeGravity(space, seconds,
+                                                 result.gravityRuns);
+                result.interactions = space.GetInteractionCount();
+            }
+            {
+                Space space(150);
+                SetUpSpace(space, bodies, solver, theta, threads, kernel);
+                result.passTimeTime = TimePassTime(space, seconds,
+                                                   result.passTimeRuns);
+            }
+            {
+                Space space(150);
+                SetUpSpace(space, bodies, solver, theta, threads, kernel);
+                result.stepTime = TimeStep(space, seconds, result.stepRuns);
+            }
+            results.push_back(result);
+            printf("%-10s %9d %14.6g %14.6g %14.6g %10.4g %14.6g\n",
+                   result.solver.c_str(), bodies, result.gravityTime,
+                   result.passTimeTime, result.stepTime,
+                   result.gravityTime/result.interactions,
+                   bodies*1e9/result.stepTime);
+            fflush(stdout);
+        }
+    }
+    /*  END: Time every solver on every size    */
+
+    if(!WriteCsv(pCsv, results) ||
+       !WriteJson(pJson, results, pKernel, threads, theta))
+    {
+        printf("could not write the results\n");
+        return 1;
+    }
+    return 0;
+}
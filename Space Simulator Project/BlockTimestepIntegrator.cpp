@@ -0,0 +1,356 @@
+/****************************************************************************
+*   FILE: BlockTimestepIntegrator.cpp
+*
+*   FUNCTION: This class inherits Integrator and gives every body its own
+*   step. The step of the space is split into power-of-two levels, and every
+*   body is put on the level that suits how fast its acceleration changes,
+*   from its acceleration and jerk. Bodies are moved with a fourth order
+*   Hermite predictor and corrector, and only the bodies whose step ends at
+*   the current time have their acceleration and jerk calculated again.
+*
+*   PURPOSE: With one step for all bodies, the fastest orbit in the space
+*   sets the step of every body. A moon circling a planet every month then
+*   forces the outermost planets, which take a century to go around, to be
+*   calculated just as often. With block steps, slow bodies are calculated
+*   a few times per orbit and most of the pulls are never summed up.
+*
+****************************************************************************/
+
+#include "BlockTimestepIntegrator.h"
+#include "Space.h"
+#include <math.h>
+
+//  the deepest level, a body on it takes 2^MAX_LEVEL steps per space step
+const int MAX_LEVEL = 20;
+
+/****************************************************************************
+ * Constructors
+ *
+ ***************************************************************************/
+
+/**
+    Name: BlockTimestepIntegrator()
+    Function: Constructs an integrator with an accuracy of 0.02, which
+    calculates the accelerations of all bodies at the start of its first
+    step.
+**/
+BlockTimestepIntegrator::BlockTimestepIntegrator()
+{
+    mAccuracy = 0.02;
+    mValid = false;
+    mForceEvaluations = 0;
+    mSubsteps = 0;
+}
+
+/****************************************************************************
+* Member Functions
+*
+****************************************************************************/
+
+/**
+    Name: Step(Space&, double)
+    Function: Moves all bodies forward by the given amount of seconds. Every
+    substep ends where the next body's own step ends. All bodies are
+    predicted to that time, the active ones get a new acceleration and jerk
+    and are corrected, and are then given a new level. A body may only move
+    up one level, to a longer step, when the current time is a whole amount
+    of the longer step, so that all steps stay in line. When the step of the
+    space is over every body has arrived at its end.
+**/
+void BlockTimestepIntegrator::Step(Space& space, double time)
+{
+    BodyStore& bodies = space.GetBodies();
+    const int count = bodies.GetCount();
+    double* pX = bodies.GetX();
+    double* pY = bodies.GetY();
+    double* pZ = bodies.GetZ();
+    double* pVx = bodies.GetVx();
+    double* pVy = bodies.GetVy();
+    double* pVz = bodies.GetVz();
+    const double* pMass = bodies.GetMass();
+    const double softening2 = space.GetSoftening()*space.GetSoftening();
+    mForceEvaluations = 0;
+    mSubsteps = 0;
+    if(count == 0)
+        return;
+    mTimes.assign(count, 0);
+    mPx.assign(pX, pX + count);
+    mPy.assign(pY, pY + count);
+    mPz.assign(pZ, pZ + count);
+    mPvx.assign(pVx, pVx + count);
+    mPvy.assign(pVy, pVy + count);
+    mPvz.assign(pVz, pVz + count);
+    mNewAx.resize(count);
+    mNewAy.resize(count);
+    mNewAz.resize(count);
+    mNewJx.resize(count);
+    mNewJy.resize(count);
+    mNewJz.resize(count);
+    /*  START: Start all bodies off  */
+    if(!mValid || (int)mLevels.size() != count)
+    {
+        mActive.resize(count);
+        for(int i = 0; i < count; i++)
+            mActive[i] = i;
+        CalculateActive(pMass, count, softening2);
+        mAx = mNewAx;
+        mAy = mNewAy;
+        mAz = mNewAz;
+        mJx = mNewJx;
+        mJy = mNewJy;
+        mJz = mNewJz;
+        mLevels.resize(count);
+        for(int i = 0; i < count; i++)
+            mLevels[i] = ChooseLevel(i, time, -1, 0);
+        mValid = true;
+    }
+    /*  END: Start all bodies off    */
+    double now = 0;
+    while(now < time)
+    {
+        /*  START: Find the active bodies   */
+        now = time;
+        for(int i = 0; i < count; i++)
+        {
+            double end = mTimes[i] + ldexp(time, -mLevels[i]);
+            if(end < now)
+                now = end;
+        }
+        mActive.clear();
+        for(int i = 0; i < count; i++)
+        {
+            if(mTimes[i] + ldexp(time, -mLevels[i]) == now)
+                mActive.push_back(i);
+        }
+        /*  END: Find the active bodies */
+        /*  START: Predict all bodies to the current time   */
+        for(int i = 0; i < count; i++)
+        {
+            double s = now - mTimes[i];
+            double s2 = s*s*0.5;
+            double s3 = s2*s*(1.0/3.0);
+            mPx[i] = pX[i] + pVx[i]*s + mAx[i]*s2 + mJx[i]*s3;
+            mPy[i] = pY[i] + pVy[i]*s + mAy[i]*s2 + mJy[i]*s3;
+            mPz[i] = pZ[i] + pVz[i]*s + mAz[i]*s2 + mJz[i]*s3;
+            mPvx[i] = pVx[i] + mAx[i]*s + mJx[i]*s2;
+            mPvy[i] = pVy[i] + mAy[i]*s + mJy[i]*s2;
+            mPvz[i] = pVz[i] + mAz[i]*s + mJz[i]*s2;
+        }
+        /*  END: Predict all bodies to the current time */
+        CalculateActive(pMass, count, softening2);
+        /*  START: Correct the active bodies    */
+        for(unsigned int k = 0; k < mActive.size(); k++)
+        {
+            int i = mActive[k];
+            double h = now - mTimes[i];
+            double h2 = h*h*(1.0/12.0);
+            //  the snap and crackle at the end of the step, from the fit
+            //  through the old and new acceleration and jerk
+            double dax = mAx[i] - mNewAx[i];
+            double day = mAy[i] - mNewAy[i];
+            double daz = mAz[i] - mNewAz[i];
+            double sx = (-6*dax - h*(4*mJx[i] + 2*mNewJx[i]))/(h*h);
+            double sy = (-6*day - h*(4*mJy[i] + 2*mNewJy[i]))/(h*h);
+            double sz = (-6*daz - h*(4*mJz[i] + 2*mNewJz[i]))/(h*h);
+            double cx = (12*dax + 6*h*(mJx[i] + mNewJx[i]))/(h*h*h);
+            double cy = (12*day + 6*h*(mJy[i] + mNewJy[i]))/(h*h*h);
+            double cz = (12*daz + 6*h*(mJz[i] + mNewJz[i]))/(h*h*h);
+            sx += cx*h;
+            sy += cy*h;
+            sz += cz*h;
+            double vx = pVx[i] + (mAx[i] + mNewAx[i])*h*0.5 +
+                        (mJx[i] - mNewJx[i])*h2;
+            double vy = pVy[i] + (mAy[i] + mNewAy[i])*h*0.5 +
+                        (mJy[i] - mNewJy[i])*h2;
+            double vz = pVz[i] + (mAz[i] + mNewAz[i])*h*0.5 +
+                        (mJz[i] - mNewJz[i])*h2;
+            pX[i] += (pVx[i] + vx)*h*0.5 + (mAx[i] - mNewAx[i])*h2;
+            pY[i] += (pVy[i] + vy)*h*0.5 + (mAy[i] - mNewAy[i])*h2;
+            pZ[i] += (pVz[i] + vz)*h*0.5 + (mAz[i] - mNewAz[i])*h2;
+            pVx[i] = vx;
+            pVy[i] = vy;
+            pVz[i] = vz;
+            mAx[i] = mNewAx[i];
+            mAy[i] = mNewAy[i];
+            mAz[i] = mNewAz[i];
+            mJx[i] = mNewJx[i];
+            mJy[i] = mNewJy[i];
+            mJz[i] = mNewJz[i];
+            mTimes[i] = now;
+            //  shorter steps are always allowed, a longer step only when
+            //  the body is in line with it
+            int level = ChooseLevel(i, time, sx*sx + sy*sy + sz*sz,
+                                    cx*cx + cy*cy + cz*cz);
+            if(level >= mLevels[i])
+                mLevels[i] = level;
+            else if(fmod(now, ldexp(time, 1 - mLevels[i])) == 0)
+                mLevels[i]--;
+        }
+        /*  END: Correct the active bodies  */
+        mSubsteps++;
+    }
+    /*  START: Leave the forces of the new positions in the store   */
+    double* pFx = bodies.GetFx();
+    double* pFy = bodies.GetFy();
+    double* pFz = bodies.GetFz();
+    for(int i = 0; i < count; i++)
+    {
+        pFx[i] = mAx[i]*pMass[i];
+        pFy[i] = mAy[i]*pMass[i];
+        pFz[i] = mAz[i]*pMass[i];
+    }
+    /*  END: Leave the forces of the new positions in the store */
+}
+
+/**
+    Name: SaveState(std::vector<double>&)
+    Function: Appends the amount of bodies followed by the level,
+    acceleration and jerk of every body. The levels depend on how the steps
+    so far went and cannot be found again from the bodies alone, so a space
+    that is saved and loaded only continues exactly when they are kept.
+    Nothing is appended before the first step.
+**/
+void BlockTimestepIntegrator::SaveState(std::vector<double>& state)
+{
+    if(!mValid)
+        return;
+    const int count = mLevels.size();
+    state.push_back(count);
+    for(int i = 0; i < count; i++)
+        state.push_back(mLevels[i]);
+    state.insert(state.end(), mAx.begin(), mAx.end());
+    state.insert(state.end(), mAy.begin(), mAy.end());
+    state.insert(state.end(), mAz.begin(), mAz.end());
+    state.insert(state.end(), mJx.begin(), mJx.end());
+    state.insert(state.end(), mJy.begin(), mJy.end());
+    state.insert(state.end(), mJz.begin(), mJz.end());
+}
+
+/**
+    Name: LoadState(Space&, const double*, int)
+    Function: Takes back a state appended by SaveState(). The amount of
+    bodies in the state has to match the bodies of the space and the length
+    of the state, every value has to be finite and every level within
+    [0, MAX_LEVEL], otherwise the integrator starts over at the next step.
+    The state may come from any file, so it is checked before any value is
+    turned into an integer.
+**/
+bool BlockTimestepIntegrator::LoadState(Space& space, const double* pState,
+                                        int length)
+{
+    mValid = false;
+    const int count = space.GetBodies().GetCount();
+    if(length < 1 || pState[0] != count || length - 1 != 7.0*count)
+        return false;
+    for(int i = 1; i < length; i++)
+    {
+        if(!isfinite(pState[i]))
+            return false;
+    }
+    const double* pLevels = pState + 1;
+    for(int i = 0; i < count; i++)
+    {
+        if(pLevels[i] < 0 || pLevels[i] > MAX_LEVEL)
+            return false;
+    }
+    mLevels.resize(count);
+    for(int i = 0; i < count; i++)
+        mLevels[i] = (int)pLevels[i];
+    mAx.assign(pLevels + count, pLevels + count*2);
+    mAy.assign(pLevels + count*2, pLevels + count*3);
+    mAz.assign(pLevels + count*3, pLevels + count*4);
+    mJx.assign(pLevels + count*4, pLevels + count*5);
+    mJy.assign(pLevels + count*5, pLevels + count*6);
+    mJz.assign(pLevels + count*6, pLevels + count*7);
+    mValid = true;
+    return true;
+}
+
+/**
+    Name: CalculateActive(const double*, int, double)
+    Function: Sums up the acceleration and jerk of every active body from
+    the predicted positions and velocities of all other bodies with mass.
+    The jerk is the change of the acceleration per second:
+    G*m*(dv/r^3 - 3*(dr.dv)*dr/r^5). With softening, r^2 is the square of
+    the distance plus the given square of the softening length.
+**/
+void BlockTimestepIntegrator::CalculateActive(const double* pMass,
+                                              int count, double softening2)
+{
+    const double g = 6.67428e-11;
+    for(unsigned int k = 0; k < mActive.size(); k++)
+    {
+        const int i = mActive[k];
+        double ax = 0;
+        double ay = 0;
+        double az = 0;
+        double jx = 0;
+        double jy = 0;
+        double jz = 0;
+        for(int other = 0; other < count; other++)
+        {
+            if(other == i || pMass[other] == 0)
+                continue;
+            double dx = mPx[other] - mPx[i];
+            double dy = mPy[other] - mPy[i];
+            double dz = mPz[other] - mPz[i];
+            double distance2 = dx*dx + dy*dy + dz*dz;
+            if(distance2 == 0)
+                continue;
+            distance2 += softening2;
+            double dvx = mPvx[other] - mPvx[i];
+            double dvy = mPvy[other] - mPvy[i];
+            double dvz = mPvz[other] - mPvz[i];
+            double inverse = 1/sqrt(distance2);
+            double pull = g*pMass[other]*inverse*inverse*inverse;
+            double rate = 3*(dx*dvx + dy*dvy + dz*dvz)/distance2;
+            ax += dx*pull;
+            ay += dy*pull;
+            az += dz*pull;
+            jx += (dvx - rate*dx)*pull;
+            jy += (dvy - rate*dy)*pull;
+            jz += (dvz - rate*dz)*pull;
+        }
+        mNewAx[i] = ax;
+        mNewAy[i] = ay;
+        mNewAz[i] = az;
+        mNewJx[i] = jx;
+        mNewJy[i] = jy;
+        mNewJz[i] = jz;
+    }
+    mForceEvaluations += mActive.size();
+}
+
+/**
+    Name: ChooseLevel(int, double, double, double)
+    Function: Returns the lowest level whose step is no longer than the step
+    the body at the given index asks for, with the given squared snap and
+    crackle. This is Aarseth's criterion:
+    sqrt(accuracy*(|a|*|s| + |j|^2)/(|j|*|c| + |s|^2)). Before a body has
+    taken a step its snap is not known, given as -1, and the much more
+    careful accuracy/2*|a|/|j| is used instead. A body without jerk, or
+    without any pull at all, stays on the step of the space.
+**/
+int BlockTimestepIntegrator::ChooseLevel(int index, double time,
+                                         double snap2, double crackle2)
+{
+    double acceleration2 = mAx[index]*mAx[index] + mAy[index]*mAy[index] +
+                           mAz[index]*mAz[index];
+    double jerk2 = mJx[index]*mJx[index] + mJy[index]*mJy[index] +
+                   mJz[index]*mJz[index];
+    if(jerk2 == 0)
+        return 0;
+    double wanted;
+    if(snap2 < 0)
+        wanted = mAccuracy*0.5*sqrt(acceleration2/jerk2);
+    else
+    {
+        double top = sqrt(acceleration2*snap2) + jerk2;
+        double bottom = sqrt(jerk2*crackle2) + snap2;
+        wanted = bottom > 0 ? sqrt(mAccuracy*top/bottom) : time;
+    }
+    int level = 0;
+    while(ldexp(time, -level) > wanted && level < MAX_LEVEL)
+        level++;
+    return level;
+}
@@ -0,0 +1,100 @@
+/****************************************************************************
+*   FILE: BlockTimestepIntegrator.h
+*
+*   FUNCTION: This class inherits Integrator and gives every body its own
+*   step. The step of the space is split into power-of-two levels, and every
+*   body is put on the level that suits how fast its acceleration changes,
+*   from its acceleration and jerk. Bodies are moved with a fourth order
+*   Hermite predictor and corrector, and only the bodies whose step ends at
+*   the current time have their acceleration and jerk calculated again.
+*
+*   PURPOSE: With one step for all bodies, the fastest orbit in the space
+*   sets the step of every body. A moon circling a planet every month then
+*   forces the outermost planets, which take a century to go around, to be
+*   calculated just as often. With block steps, slow bodies are calculated
+*   a few times per orbit and most of the pulls are never summed up.
+*
+****************************************************************************/
+
+#ifndef _BlockTimestepIntegrator_
+#define _BlockTimestepIntegrator_
+
+#include "Integrator.h"
+#include <vector>
+
+class BlockTimestepIntegrator : public Integrator{
+    public:
+    /** Constructors    **/
+    //  constructs an integrator with the default accuracy
+    BlockTimestepIntegrator();
+    /** Member Functions   **/
+    //  moves all bodies in the space forward by the given amount of seconds
+    void                Step(Space&, double);
+    //  forgets the accelerations and levels kept from the previous step
+    void                Reset()
+                            {mValid = false;}
+    //  appends the level, acceleration and jerk of every body
+    void                SaveState(std::vector<double>&);
+    //  takes back the levels, accelerations and jerks
+    bool                LoadState(Space&, const double*, int);
+    /** Getters and Setters **/
+    const char*         GetName()
+                            {return "block";}
+    //  the accuracy of Aarseth's step criterion, smaller is more accurate
+    double              GetAccuracy()
+                            {return mAccuracy;}
+    void                SetAccuracy(double accuracy)
+                            {mAccuracy = accuracy;}
+    //  the amount of bodies whose acceleration was calculated during the
+    //  last step, summed over all substeps
+    long long           GetForceEvaluations()
+                            {return mForceEvaluations;}
+    //  the amount of substeps the last step was split into
+    int                 GetSubsteps()
+                            {return mSubsteps;}
+    int                 GetLevel(int index)
+                            {return mLevels[index];}
+
+    private:
+    //  calculates the acceleration and jerk of the active bodies from the
+    //  predicted positions and velocities of all bodies, softened by the
+    //  given square of the softening length
+    void                CalculateActive(const double*, int, double);
+    //  returns the level a body asks for, with the given step of the space
+    //  and the squared snap and crackle of the body
+    int                 ChooseLevel(int, double, double, double);
+
+    /** Class Members   **/
+    double              mAccuracy;
+    bool                mValid;
+    long long           mForceEvaluations;
+    int                 mSubsteps;
+    //  per body: the step level, the time within the step it was last
+    //  moved to, and its acceleration and jerk at that time
+    std::vector<int>    mLevels;
+    std::vector<double> mTimes;
+    std::vector<double> mAx;
+    std::vector<double> mAy;
+    std::vector<double> mAz;
+    std::vector<double> mJx;
+    std::vector<double> mJy;
+    std::vector<double> mJz;
+    //  per body: the predicted position and velocity at the current time
+    std::vector<double> mPx;
+    std::vector<double> mPy;
+    std::vector<double> mPz;
+    std::vector<double> mPvx;
+    std::vector<double> mPvy;
+    std::vector<double> mPvz;
+    //  the new acceleration and jerk of the active bodies
+    std::vector<double> mNewAx;
+    std::vector<double> mNewAy;
+    std::vector<double> mNewAz;
+    std::vector<double> mNewJx;
+    std::vector<double> mNewJy;
+    std::vector<double> mNewJz;
+    //  the bodies whose step ends at the current time
+    std::vector<int>    mActive;
+};
+
+#endif
@@ -0,0 +1,571 @@
+/****************************************************************************
+*   FILE: BodyStore.cpp
+*
+*   FUNCTION: This class stores the state of every body in a space as a
+*   structure of arrays. The data used by the physics every step (position,
+*   velocity, force and mass) is kept in separate contiguous and aligned
+*   arrays, while the data that is only read when drawing (name, radius,
+*   colour, type) is kept in a separate table.
+*
+*   PURPOSE: Walking a list of pointers to objects spread out over the heap
+*   makes the gravity calculation spend most of its time waiting for memory.
+*   Keeping the hot data packed together lets the calculation stream through
+*   it instead.
+*
+*   NOTES: The index of a body changes when another body is removed, since
+*   the last body is moved into the gap to keep the arrays packed. Every
+*   body therefore also gets a handle, which finds its current index through
+*   a table of slots in constant time and stops finding anything once the
+*   body is removed. The bodies of every type are listed as well, so that
+*   the bodies of one type can be walked without copying or skipping over
+*   all the others.
+*
+****************************************************************************/
+
+#include "BodyStore.h"
+#include <stdlib.h>
+#include <string.h>
+#include <utility>
+
+//  the arrays start on a cache line
+const size_t ALIGNMENT = 64;
+//  the capacity is kept at a multiple of this many bodies, so that the end of
+//  the arrays can always be read a whole cache line at a time
+const int CAPACITY_STEP = 8;
+//  the amount of arrays kept for every body
+const int ARRAY_COUNT = 10;
+
+/**
+    Name: AllocateAligned(int)
+    Function: Allocates an array of the given amount of doubles starting at
+    an aligned address. The address of the block returned by malloc is kept
+    right in front of the array so that it can be freed later on.
+**/
+static double* AllocateAligned(int count)
+{
+    char* pBlock = (char*)malloc(count*sizeof(double) +
+                                 ALIGNMENT + sizeof(void*));
+    if(pBlock == 0)
+        return 0;
+    size_t address = (size_t)(pBlock + sizeof(void*));
+    address = (address + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    ((void**)address)[-1] = pBlock;
+    return (double*)address;
+}
+
+/**
+    Name: FreeAligned(double*)
+    Function: Frees an array allocated with AllocateAligned(int).
+**/
+static void FreeAligned(double* pArray)
+{
+    if(pArray != 0)
+        free(((void**)pArray)[-1]);
+}
+
+/**
+    Name: GrowArray(const double*, int, int)
+    Function: Returns a new aligned block of the given capacity holding the
+    first count elements of the array, with the rest zeroed.
+**/
+static double* GrowArray(const double* pArray, int count, int capacity)
+{
+    double* pNew = AllocateAligned(capacity);
+    if(count > 0)
+        memcpy(pNew, pArray, count*sizeof(double));
+    memset(pNew + count, 0, (capacity - count)*sizeof(double));
+    return pNew;
+}
+
+/****************************************************************************
+ * Constructors
+ *
+ ***************************************************************************/
+
+/**
+    Name: BodyStore()
+    Function: Constructs an empty store. No memory is allocated until the
+    first body is added or room is reserved.
+**/
+BodyStore::BodyStore()
+{
+    mCount      = 0;
+    mCapacity   = 0;
+    mpX         = 0;
+    mpY         = 0;
+    mpZ         = 0;
+    mpVx        = 0;
+    mpVy        = 0;
+    mpVz        = 0;
+    mpFx        = 0;
+    mpFy        = 0;
+    mpFz        = 0;
+    mpMass      = 0;
+    mpMemory    = 0;
+    mMemorySize = 0;
+    mpRelease   = 0;
+    mFreeSlot   = -1;
+    mNamesIndexed = false;
+}
+
+/**
+    Name: ~BodyStore()
+    Function: Frees all the arrays of the store, or lets go of the attached
+    memory.
+**/
+BodyStore::~BodyStore()
+{
+    ReleaseArrays();
+}
+
+/****************************************************************************
+* Member Functions
+*
+****************************************************************************/
+
+/**
+    Name: Reserve(int)
+    Function: Makes sure the store can hold at least the given amount of
+    bodies without having to move its arrays again. Unused elements are kept
+    at zero, a body with zero mass does not pull on any other body.
+**/
+void BodyStore::Reserve(int capacity)
+{
+    if(capacity <= mCapacity)
+        return;
+    //  round up to a whole step
+    capacity = (capacity + CAPACITY_STEP - 1) / CAPACITY_STEP * CAPACITY_STEP;
+    double* pX      = GrowArray(mpX,    mCount, capacity);
+    double* pY      = GrowArray(mpY,    mCount, capacity);
+    double* pZ      = GrowArray(mpZ,    mCount, capacity);
+    double* pVx     = GrowArray(mpVx,   mCount, capacity);
+    double* pVy     = GrowArray(mpVy,   mCount, capacity);
+    double* pVz     = GrowArray(mpVz,   mCount, capacity);
+    double* pFx     = GrowArray(mpFx,   mCount, capacity);
+    double* pFy     = GrowArray(mpFy,   mCount, capacity);
+    double* pFz     = GrowArray(mpFz,   mCount, capacity);
+    double* pMass   = GrowArray(mpMass, mCount, capacity);
+    //  attached arrays are left behind here and the store owns its own
+    ReleaseArrays();
+    mpX     = pX;
+    mpY     = pY;
+    mpZ     = pZ;
+    mpVx    = pVx;
+    mpVy    = pVy;
+    mpVz    = pVz;
+    mpFx    = pFx;
+    mpFy    = pFy;
+    mpFz    = pFz;
+    mpMass  = pMass;
+    mInfo.reserve(capacity);
+    mSlotOf.reserve(capacity);
+    mTypePosition.reserve(capacity);
+    mCapacity = capacity;
+}
+
+/**
+    Name: Add(const BodyInfo&, Vec3d, Vec3d, double)
+    Function: Adds a body at the end of the store and returns its index. The
+    force on the new body starts at neutral.
+**/
+int BodyStore::Add(const BodyInfo& info, Vec3d position,
+                   Vec3d velocity, double mass)
+{
+    //  double the capacity when the store is full
+    if(mCount == mCapacity)
+        Reserve(mCapacity == 0 ? CAPACITY_STEP : mCapacity*2);
+    int index = mCount;
+    mpX[index]      = position.GetX();
+    mpY[index]      = position.GetY();
+    mpZ[index]      = position.GetZ();
+    mpVx[index]     = velocity.GetX();
+    mpVy[index]     = velocity.GetY();
+    mpVz[index]     = velocity.GetZ();
+    mpFx[index]     = 0;
+    mpFy[index]     = 0;
+    mpFz[index]     = 0;
+    mpMass[index]   = mass;
+    mInfo.push_back(info);
+    mSlotOf.push_back(TakeSlot(index));
+    if(mNamesIndexed)
+        IndexName(mSlotOf[index]);
+    ListType(index);
+    mCount++;
+    return index;
+}
+
+/**
+    Name: PopBack()
+    Function: Removes the last body in the store. Its elements are zeroed so
+    that the end of the arrays stays neutral.
+**/
+void BodyStore::PopBack()
+{
+    if(mCount == 0)
+        return;
+    FreeSlot(mCount - 1);
+    UnlistType(mCount - 1);
+    mCount--;
+    mpX[mCount]     = 0;
+    mpY[mCount]     = 0;
+    mpZ[mCount]     = 0;
+    mpVx[mCount]    = 0;
+    mpVy[mCount]    = 0;
+    mpVz[mCount]    = 0;
+    mpFx[mCount]    = 0;
+    mpFy[mCount]    = 0;
+    mpFz[mCount]    = 0;
+    mpMass[mCount]  = 0;
+    mInfo.pop_back();
+    mSlotOf.pop_back();
+    mTypePosition.pop_back();
+}
+
+/**
+    Name: RemoveAt(int)
+    Function: Removes the body at the given index in constant time by moving
+    the last body into its place and zeroing the elements of the last one,
+    so that the arrays stay packed and their end neutral. The moved body
+    keeps its handle, but an object bound to it has to be bound to its new
+    index by the caller.
+**/
+void BodyStore::RemoveAt(int index)
+{
+    const int last = mCount - 1;
+    if(index < 0 || index > last)
+        return;
+    FreeSlot(index);
+    UnlistType(index);
+    double* pArrays[] = {mpX, mpY, mpZ, mpVx, mpVy, mpVz,
+                         mpFx, mpFy, mpFz, mpMass};
+    for(int a = 0; a < ARRAY_COUNT; a++)
+    {
+        pArrays[a][index] = pArrays[a][last];
+        pArrays[a][last] = 0;
+    }
+    if(index != last)
+    {
+        mInfo[index] = std::move(mInfo[last]);
+        mSlotOf[index] = mSlotOf[last];
+        mSlots[mSlotOf[index]].index = index;
+        mTypePosition[index] = mTypePosition[last];
+        mOfType[mInfo[index].type][mTypePosition[index]] = index;
+    }
+    mInfo.pop_back();
+    mSlotOf.pop_back();
+    mTypePosition.pop_back();
+    mCount--;
+}
+
+/**
+    Name: Clear()
+    Function: Removes all bodies but keeps the allocated arrays.
+**/
+void BodyStore::Clear()
+{
+    while(mCount > 0)
+        PopBack();
+}
+
+/**
+    Name: Append(BodyStore&)
+    Function: Moves all bodies of the argument store to the end of this one,
+    growing this store only once and copying every array in one go. The
+    info of the bodies is moved rather than copied. The elements left
+    behind in the argument store are zeroed, so that it is empty and
+    neutral but keeps its arrays.
+**/
+void BodyStore::Append(BodyStore& other)
+{
+    const int count = other.mCount;
+    if(count == 0)
+        return;
+    Reserve(mCount + count);
+    double* pArrays[] = {mpX, mpY, mpZ, mpVx, mpVy, mpVz,
+                         mpFx, mpFy, mpFz, mpMass};
+    double* pOther[]  = {other.mpX, other.mpY, other.mpZ,
+                         other.mpVx, other.mpVy, other.mpVz,
+                         other.mpFx, other.mpFy, other.mpFz, other.mpMass};
+    for(int i = 0; i < ARRAY_COUNT; i++)
+    {
+        memcpy(pArrays[i] + mCount, pOther[i], count*sizeof(double));
+        memset(pOther[i], 0, count*sizeof(double));
+    }
+    for(int i = 0; i < count; i++)
+    {
+        mInfo.push_back(std::move(other.mInfo[i]));
+        mSlotOf.push_back(TakeSlot(mCount + i));
+        ListType(mCount + i);
+    }
+    //  the names are only read once the slots of both stores are set
+    if(mNamesIndexed)
+    {
+        for(int i = 0; i < count; i++)
+            IndexName(mSlotOf[mCount + i]);
+    }
+    other.FreeSlots();
+    for(int t = 0; t < BODY_TYPE_COUNT; t++)
+        other.mOfType[t].clear();
+    other.mTypePosition.clear();
+    other.mInfo.clear();
+    other.mCount = 0;
+    mCount += count;
+}
+
+/**
+    Name: Attach(double*, int, int, std::vector<BodyInfo>&, void*, size_t,
+                 void (*)(void*, size_t))
+    Function: Replaces the bodies of the store with the given count of
+    bodies in arrays the store does not own. The ten arrays of the given
+    capacity follow each other from the given address in the order x, y, z,
+    vx, vy, vz, fx, fy, fz and mass. The capacity has to be a multiple of the
+    capacity step, the address aligned and the end of the arrays zeroed,
+    just like arrays of the store's own. The info vector is taken over. The
+    store writes to the arrays in place until it has to grow, then moves to
+    arrays of its own and calls the release function with the memory.
+**/
+void BodyStore::Attach(double* pArrays, int count, int capacity,
+                       std::vector<BodyInfo>& info, void* pMemory,
+                       size_t memorySize, void (*pRelease)(void*, size_t))
+{
+    FreeSlots();
+    ReleaseArrays();
+    mpX         = pArrays;
+    mpY         = pArrays + capacity;
+    mpZ         = pArrays + capacity*2;
+    mpVx        = pArrays + capacity*3;
+    mpVy        = pArrays + capacity*4;
+    mpVz        = pArrays + capacity*5;
+    mpFx        = pArrays + capacity*6;
+    mpFy        = pArrays + capacity*7;
+    mpFz        = pArrays + capacity*8;
+    mpMass      = pArrays + capacity*9;
+    mCount      = count;
+    mCapacity   = capacity;
+    mInfo.swap(info);
+    mpMemory    = pMemory;
+    mMemorySize = memorySize;
+    mpRelease   = pRelease;
+    for(int t = 0; t < BODY_TYPE_COUNT; t++)
+        mOfType[t].clear();
+    mTypePosition.clear();
+    for(int i = 0; i < count; i++)
+    {
+        mSlotOf.push_back(TakeSlot(i));
+        ListType(i);
+    }
+}
+
+/**
+    Name: Find(BodyHandle)
+    Function: Returns the current index of the body the handle stands for,
+    or -1 if the body was removed or the handle never stood for a body of
+    this store.
+**/
+int BodyStore::Find(BodyHandle handle)
+{
+    if(handle.slot >= mSlots.size())
+        return -1;
+    const Slot& slot = mSlots[handle.slot];
+    //  a free slot has a different generation than any handle to it
+    if(slot.generation != handle.generation)
+        return -1;
+    return slot.index;
+}
+
+/**
+    Name: Find(const std::string&)
+    Function: Returns the index of the body with the given name that was
+    added earliest of those still in the store, or -1 if there is none. The
+    first lookup indexes all names, which costs one pass over the bodies,
+    and every lookup after it takes constant time.
+**/
+int BodyStore::Find(const std::string& name)
+{
+    if(!mNamesIndexed)
+    {
+        mNamesIndexed = true;
+        for(int i = 0; i < mCount; i++)
+            IndexName(mSlotOf[i]);
+    }
+    std::unordered_map<std::string, unsigned int>::iterator found =
+        mNames.find(name);
+    if(found == mNames.end())
+        return -1;
+    return mSlots[found->second].index;
+}
+
+/**
+    Name: SetName(int, const std::string&)
+    Function: Renames the body at the given index, moving it in the name
+    index if the names are indexed.
+**/
+void BodyStore::SetName(int index, const std::string& name)
+{
+    if(mNamesIndexed)
+        UnindexName(mSlotOf[index]);
+    mInfo[index].name = name;
+    if(mNamesIndexed)
+        IndexName(mSlotOf[index]);
+}
+
+/**
+    Name: ReleaseArrays()
+    Function: Frees the arrays of the store, or calls the release function
+    of the attached memory. The array pointers are left as they are, to be
+    replaced by the caller.
+**/
+void BodyStore::ReleaseArrays()
+{
+    if(mpMemory != 0)
+    {
+        if(mpRelease != 0)
+            mpRelease(mpMemory, mMemorySize);
+        mpMemory = 0;
+        mMemorySize = 0;
+        mpRelease = 0;
+        return;
+    }
+    FreeAligned(mpX);
+    FreeAligned(mpY);
+    FreeAligned(mpZ);
+    FreeAligned(mpVx);
+    FreeAligned(mpVy);
+    FreeAligned(mpVz);
+    FreeAligned(mpFx);
+    FreeAligned(mpFy);
+    FreeAligned(mpFz);
+    FreeAligned(mpMass);
+}
+
+/**
+    Name: TakeSlot(int)
+    Function: Takes the first free slot of the handle table, or a new one if
+    none is free, points it at the given index and returns it. A new slot
+    starts at generation one, so that no handle of generation zero ever
+    matches.
+**/
+unsigned int BodyStore::TakeSlot(int index)
+{
+    unsigned int slot;
+    if(mFreeSlot != -1)
+    {
+        slot = mFreeSlot;
+        mFreeSlot = mSlots[slot].index;
+    }
+    else
+    {
+        slot = mSlots.size();
+        Slot fresh = {0, 1, slot, slot};
+        mSlots.push_back(fresh);
+    }
+    mSlots[slot].index = index;
+    return slot;
+}
+
+/**
+    Name: FreeSlot(int)
+    Function: Puts the slot of the body at the given index on the free list
+    and bumps its generation, so that the handles to the body stop matching.
+    The body has to still be in the store to be taken out of the name index.
+**/
+void BodyStore::FreeSlot(int index)
+{
+    const unsigned int slot = mSlotOf[index];
+    if(mNamesIndexed)
+        UnindexName(slot);
+    //  generation zero is left to handles that never match
+    if(++mSlots[slot].generation == 0)
+        mSlots[slot].generation = 1;
+    mSlots[slot].index = mFreeSlot;
+    mFreeSlot = slot;
+}
+
+/**
+    Name: FreeSlots()
+    Function: Frees the slots of all bodies at once, dropping the name index
+    instead of taking every body out of it.
+**/
+void BodyStore::FreeSlots()
+{
+    mNamesIndexed = false;
+    mNames.clear();
+    for(int i = 0; i < (int)mSlotOf.size(); i++)
+        FreeSlot(i);
+    mSlotOf.clear();
+}
+
+/**
+    Name: ListType(int)
+    Function: Adds the body at the given index, which is the last one in
+    the list of body positions, at the end of the list of its type.
+**/
+void BodyStore::ListType(int index)
+{
+    std::vector<int>& bodies = mOfType[mInfo[index].type];
+    mTypePosition.push_back(bodies.size());
+    bodies.push_back(index);
+}
+
+/**
+    Name: UnlistType(int)
+    Function: Takes the body at the given index out of the list of its type
+    by moving the last body of the list into its place. Its own position is
+    left for the caller to drop.
+**/
+void BodyStore::UnlistType(int index)
+{
+    std::vector<int>& bodies = mOfType[mInfo[index].type];
+    const int position = mTypePosition[index];
+    bodies[position] = bodies.back();
+    mTypePosition[bodies[position]] = position;
+    bodies.pop_back();
+}
+
+/**
+    Name: IndexName(unsigned int)
+    Function: Adds the body in the slot to the name index. The bodies with
+    the same name are linked in a ring in the order they were added, and
+    the index points at the earliest of them.
+**/
+void BodyStore::IndexName(unsigned int slot)
+{
+    std::pair<std::unordered_map<std::string, unsigned int>::iterator,
+              bool> inserted = mNames.insert(
+        std::make_pair(mInfo[mSlots[slot].index].name, slot));
+    if(inserted.second)
+    {
+        mSlots[slot].nextName = slot;
+        mSlots[slot].prevName = slot;
+        return;
+    }
+    //  the new body goes in front of the earliest, which ends the ring
+    const unsigned int first = inserted.first->second;
+    const unsigned int last = mSlots[first].prevName;
+    mSlots[slot].nextName = first;
+    mSlots[slot].prevName = last;
+    mSlots[last].nextName = slot;
+    mSlots[first].prevName = slot;
+}
+
+/**
+    Name: UnindexName(unsigned int)
+    Function: Takes the body in the slot out of the name index, handing the
+    name on to the next body with it if the body was the earliest.
+**/
+void BodyStore::UnindexName(unsigned int slot)
+{
+    std::unordered_map<std::string, unsigned int>::iterator found =
+        mNames.find(mInfo[mSlots[slot].index].name);
+    const unsigned int next = mSlots[slot].nextName;
+    const unsigned int prev = mSlots[slot].prevName;
+    if(next == slot)
+    {
+        mNames.erase(found);
+        return;
+    }
+    mSlots[prev].nextName = next;
+    mSlots[next].prevName = prev;
+    if(found->second == slot)
+        found->second = next;
+}
@@ -0,0 +1,258 @@
+/****************************************************************************
+*   FILE: BodyStore.h
+*
+*   FUNCTION: This class stores the state of every body in a space as a
+*   structure of arrays. The data used by the physics every step (position,
+*   velocity, force and mass) is kept in separate contiguous and aligned
+*   arrays, while the data that is only read when drawing (name, radius,
+*   colour, type) is kept in a separate table.
+*
+*   PURPOSE: Walking a list of pointers to objects spread out over the heap
+*   makes the gravity calculation spend most of its time waiting for memory.
+*   Keeping the hot data packed together lets the calculation stream through
+*   it instead.
+*
+*   NOTES: The index of a body changes when another body is removed, since
+*   the last body is moved into the gap to keep the arrays packed. Every
+*   body therefore also gets a handle, which finds its current index through
+*   a table of slots in constant time and stops finding anything once the
+*   body is removed. The bodies of every type are listed as well, so that
+*   the bodies of one type can be walked without copying or skipping over
+*   all the others.
+*
+****************************************************************************/
+
+#ifndef _BodyStore_
+#define _BodyStore_
+
+#include "Vec.h"
+#include <stddef.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class SpaceObject;
+
+//  the different types of bodies a space can contain
+enum BodyType{
+    BODY_STAR,
+    BODY_PLANET,
+    BODY_MOON
+};
+
+//  the amount of body types
+const int BODY_TYPE_COUNT = 3;
+
+//  the indices of some bodies, read where they are kept instead of copied,
+//  valid until a body is added or removed
+struct BodySpan{
+    const int*          pBegin;
+    const int*          pEnd;
+    const int*          begin() const
+                            {return pBegin;}
+    const int*          end() const
+                            {return pEnd;}
+    int                 size() const
+                            {return pEnd - pBegin;}
+};
+
+//  the data of a body that is not needed to calculate its movement
+struct BodyInfo{
+    std::string         name;
+    double              radius;
+    float               red;
+    float               green;
+    float               blue;
+    BodyType            type;
+    //  the light source of a star, 0 if it does not emit light
+    unsigned int        lightSource;
+    //  the object the body was added from, 0 if there is none
+    SpaceObject*        pObject;
+};
+
+//  stands for the same body while other bodies are added and removed, unlike
+//  its index, by naming a slot of the store's handle table and how often the
+//  slot had been freed when the body got it
+struct BodyHandle{
+    unsigned int        slot;
+    unsigned int        generation;
+};
+
+inline bool operator==(BodyHandle a, BodyHandle b)
+    {return a.slot == b.slot && a.generation == b.generation;}
+inline bool operator!=(BodyHandle a, BodyHandle b)
+    {return !(a == b);}
+
+//  a handle that never stands for any body
+const BodyHandle NO_BODY = {0, 0};
+
+class BodyStore{
+    public:
+    /** Constructors    **/
+    //  constructs an empty store
+    BodyStore();
+    //  frees the arrays of the store
+    ~BodyStore();
+    /** Member Functions   **/
+    //  makes room for at least the given amount of bodies
+    void                Reserve(int);
+    //  adds a body with the given info, position and velocity coordinates
+    //  and mass double and returns its index
+    int                 Add(const BodyInfo&, Vec3d, Vec3d, double);
+    //  removes the last body
+    void                PopBack();
+    //  removes the body at the given index by moving the last body into its
+    //  place
+    void                RemoveAt(int);
+    //  removes all bodies
+    void                Clear();
+    //  moves all bodies of the argument store to the end of this one,
+    //  leaving the argument store empty
+    void                Append(BodyStore&);
+    //  returns the index of the body the handle stands for, -1 if it was
+    //  removed
+    int                 Find(BodyHandle);
+    //  returns the index of the earliest added body with the given name, -1
+    //  if there is none
+    int                 Find(const std::string&);
+    //  uses the given arrays in memory the store does not own, such as a
+    //  mapped file, with the given count, capacity and info, and calls the
+    //  release function with the memory and its size once done with it
+    void                Attach(double*, int, int, std::vector<BodyInfo>&,
+                               void*, size_t, void (*)(void*, size_t));
+    /** Getters and Setters **/
+    //  true while the arrays are in memory the store does not own
+    bool                IsAttached()
+                            {return mpMemory != 0;}
+    int                 GetCount()
+                            {return mCount;}
+    int                 GetCapacity()
+                            {return mCapacity;}
+    double*             GetX()
+                            {return mpX;}
+    double*             GetY()
+                            {return mpY;}
+    double*             GetZ()
+                            {return mpZ;}
+    double*             GetVx()
+                            {return mpVx;}
+    double*             GetVy()
+                            {return mpVy;}
+    double*             GetVz()
+                            {return mpVz;}
+    double*             GetFx()
+                            {return mpFx;}
+    double*             GetFy()
+                            {return mpFy;}
+    double*             GetFz()
+                            {return mpFz;}
+    double*             GetMass()
+                            {return mpMass;}
+    BodyInfo&           GetInfo(int index)
+                            {return mInfo[index];}
+    //  the name is only changed through the store, which may have it
+    //  indexed
+    void                SetName(int, const std::string&);
+    BodyHandle          GetHandle(int index)
+                            {BodyHandle handle = {mSlotOf[index],
+                                mSlots[mSlotOf[index]].generation};
+                             return handle;}
+    //  the indices of all bodies of the type, in no particular order
+    BodySpan            GetBodiesOfType(BodyType type)
+                            {const std::vector<int>& bodies = mOfType[type];
+                             BodySpan span = {bodies.data(),
+                                              bodies.data() + bodies.size()};
+                             return span;}
+    //  the amount of slots in the handle table, every slot of a handle is
+    //  below it
+    int                 GetSlotCount()
+                            {return mSlots.size();}
+    Vec3d               GetPosition(int index)
+                            {return Vec3d(mpX[index], mpY[index],
+                                          mpZ[index]);}
+    void                SetPosition(int index, Vec3d position)
+                            {mpX[index] = position.GetX();
+                             mpY[index] = position.GetY();
+                             mpZ[index] = position.GetZ();}
+    Vec3d               GetVelocity(int index)
+                            {return Vec3d(mpVx[index], mpVy[index],
+                                          mpVz[index]);}
+    void                SetVelocity(int index, Vec3d velocity)
+                            {mpVx[index] = velocity.GetX();
+                             mpVy[index] = velocity.GetY();
+                             mpVz[index] = velocity.GetZ();}
+    Vec3d               GetForce(int index)
+                            {return Vec3d(mpFx[index], mpFy[index],
+                                          mpFz[index]);}
+    void                SetForce(int index, Vec3d force)
+                            {mpFx[index] = force.GetX();
+                             mpFy[index] = force.GetY();
+                             mpFz[index] = force.GetZ();}
+
+    private:
+    //  the store owns raw arrays and can therefore not be copied
+    BodyStore(const BodyStore&);
+    BodyStore&          operator=(const BodyStore&);
+    //  a slot of the handle table, pointing at a body or, while free, at
+    //  the next free slot
+    struct Slot{
+        //  the index of the body, or of the next free slot, -1 for none
+        int             index;
+        //  bumped every time the slot is freed, so that the handles given
+        //  out before stop matching
+        unsigned int    generation;
+        //  the next and previous slot of the bodies with the same name,
+        //  while the names are indexed
+        unsigned int    nextName;
+        unsigned int    prevName;
+    };
+
+    //  frees the arrays, or lets go of the attached memory
+    void                ReleaseArrays();
+    //  gives the body at the given index a slot and returns it
+    unsigned int        TakeSlot(int);
+    //  frees the slot of the body at the given index, which is still there
+    void                FreeSlot(int);
+    //  frees the slots of all bodies and forgets the name index
+    void                FreeSlots();
+    //  adds the body at the given index to the list of its type, or takes
+    //  it out
+    void                ListType(int);
+    void                UnlistType(int);
+    //  adds the body in the slot to the name index, or removes it
+    void                IndexName(unsigned int);
+    void                UnindexName(unsigned int);
+
+    /** Class Members   **/
+    int                 mCount;
+    int                 mCapacity;
+    double*             mpX;
+    double*             mpY;
+    double*             mpZ;
+    double*             mpVx;
+    double*             mpVy;
+    double*             mpVz;
+    double*             mpFx;
+    double*             mpFy;
+    double*             mpFz;
+    double*             mpMass;
+    std::vector<BodyInfo> mInfo;
+    //  the slot of every body, the handle table and its first free slot
+    std::vector<unsigned int> mSlotOf;
+    std::vector<Slot>   mSlots;
+    int                 mFreeSlot;
+    //  the bodies of every type, and where every body is in the list of its
+    //  type, which is why the type of a body is never changed
+    std::vector<int>    mOfType[BODY_TYPE_COUNT];
+    std::vector<int>    mTypePosition;
+    //  the earliest added body of every name, as a slot, built on the first
+    //  lookup by name and kept up to date from then on
+    bool                mNamesIndexed;
+    std::unordered_map<std::string, unsigned int> mNames;
+    //  the attached memory, its size and the function that releases it
+    void*               mpMemory;
+    size_t              mMemorySize;
+    void                (*mpRelease)(void*, size_t);
+};
+
+#endif
@@ -0,0 +1,470 @@
+/****************************************************************************
+*   FILE: Checkpoint.cpp
+*
+*   FUNCTION: This class saves a space to a binary checkpoint file and loads
+*   it back. The file holds the state of every body, the time of a step,
+*   the gravity solver, the softening, the collision settings and the
+*   integrator with whatever it keeps between steps. The body arrays are
+*   stored exactly as the body store keeps them in memory, aligned and
+*   padded, so loading maps the file and lets the store use the arrays in
+*   place. Saving can be done on a background thread, after a quick copy of
+*   the space.
+*
+*   PURPOSE: Without checkpoints every run starts from the objects created
+*   in code, and a long run that is stopped is lost. Mapping the file makes
+*   restarting a space of a million bodies a matter of milliseconds, since
+*   nothing has to be parsed or copied, and saving in the background does
+*   not hold up the stepping for longer than the copy.
+*
+*   FORMAT: All numbers are in the byte order of the machine that wrote the
+*   file, which is checked on loading. A 128 byte header is followed by the
+*   x, y, z, vx, vy, vz, fx, fy, fz and mass arrays, each as long as the
+*   padded capacity and starting 64 bytes aligned. After them come one 32 byte
+*   record per body (radius, colour, type, light source and name length),
+*   the names one after the other, and the state of the integrator.
+*
+****************************************************************************/
+
+#include "Checkpoint.h"
+#include <stdint.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//  the first bytes of every checkpoint file
+const char MAGIC[8] = {'S', 'P', 'A', 'C', 'E', 'C', 'K', 'P'};
+//  the version of the format, increased whenever the layout changes
+const uint32_t VERSION = 2;
+//  written as a number, read back in another byte order it differs
+const uint32_t ORDER_MARK = 0x01020304;
+//  the sections of the file start on a cache line
+const uint64_t SECTION_ALIGNMENT = 64;
+//  the amount of body arrays
+const int ARRAY_COUNT = 10;
+
+//  the start of every checkpoint file
+struct CheckpointHeader{
+    char                magic[8];
+    uint32_t            version;
+    uint32_t            byteOrder;
+    uint64_t            fileSize;
+    uint64_t            count;
+    uint64_t            capacity;
+    //  the offsets of the sections from the start of the file
+    uint64_t            arraysOffset;
+    uint64_t            infoOffset;
+    uint64_t            namesOffset;
+    uint64_t            namesSize;
+    uint64_t            stateOffset;
+    //  the amount of doubles in the integrator state
+    uint64_t            stateLength;
+    //  the seconds per step
+    int32_t             time;
+    int32_t             integrator;
+    int32_t             solver;
+    //  the precision of the direct sum, zero for double precision
+    int32_t             precision;
+    double              theta;
+    //  the Plummer softening length in meters
+    double              softening;
+    //  the meters a radius of one stands for, zero when touching bodies
+    //  are not merged
+    double              radiusScale;
+};
+
+//  the info of one body
+struct CheckpointInfo{
+    double              radius;
+    float               red;
+    float               green;
+    float               blue;
+    uint32_t            type;
+    uint32_t            lightSource;
+    uint32_t            nameLength;
+};
+
+/**
+    Name: AlignUp(uint64_t)
+    Function: Rounds the argument offset up to the start of a section.
+**/
+static uint64_t AlignUp(uint64_t offset)
+{
+    return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+}
+
+/**
+    Name: FitsIn(uint64_t, uint64_t, uint64_t)
+    Function: Returns true if a section starting at the first offset with
+    the length in the second argument ends at or before the third offset.
+    The sum is never worked out, so that it cannot overflow.
+**/
+static bool FitsIn(uint64_t offset, uint64_t length, uint64_t end)
+{
+    return offset <= end && length <= end - offset;
+}
+
+/**
+    Name: MapFile(const std::string&, size_t&)
+    Function: Maps the whole file named by the argument into memory and
+    returns its address, with its size in the second argument, or 0 if it
+    could not be mapped. The mapping is private: the memory can be written
+    to, but the writes never reach the file.
+**/
+static void* MapFile(const std::string& path, size_t& size)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if(file == INVALID_HANDLE_VALUE)
+        return 0;
+    LARGE_INTEGER fileSize;
+    void* pMemory = 0;
+    if(GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+    {
+        HANDLE mapping = CreateFileMappingA(file, 0, PAGE_WRITECOPY,
+                                            0, 0, 0);
+        if(mapping != 0)
+        {
+            pMemory = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+        size = (size_t)fileSize.QuadPart;
+    }
+    CloseHandle(file);
+    return pMemory;
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if(file < 0)
+        return 0;
+    struct stat status;
+    void* pMemory = 0;
+    if(fstat(file, &status) == 0 && status.st_size > 0)
+    {
+        size = (size_t)status.st_size;
+        pMemory = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                       file, 0);
+        if(pMemory == MAP_FAILED)
+            pMemory = 0;
+    }
+    close(file);
+    return pMemory;
+#endif
+}
+
+/**
+    Name: UnmapFile(void*, size_t)
+    Function: Unmaps memory mapped by MapFile(const std::string&, size_t&).
+**/
+static void UnmapFile(void* pMemory, size_t size)
+{
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(pMemory);
+#else
+    munmap(pMemory, size);
+#endif
+}
+
+/****************************************************************************
+ * Constructors
+ *
+ ***************************************************************************/
+
+/**
+    Name: Checkpoint()
+    Function: Constructs a checkpoint writer that is not writing.
+**/
+Checkpoint::Checkpoint()
+{
+    mWriting = false;
+    mSucceeded = true;
+}
+
+/**
+    Name: ~Checkpoint()
+    Function: Waits for a background write to finish, so that it is never
+    cut off halfway.
+**/
+Checkpoint::~Checkpoint()
+{
+    Wait();
+}
+
+/****************************************************************************
+* Member Functions
+*
+****************************************************************************/
+
+/**
+    Name: SaveAsync(Space&, const std::string&)
+    Function: Lays out the file for the space in memory, which is the only
+    part that has to be done while the space stands still, and writes it on
+    a background thread. Returns false without doing anything if the last
+    write is still going on. The memory of the last file is reused.
+**/
+bool Checkpoint::SaveAsync(Space& space, const std::string& path)
+{
+    if(mWriting)
+        return false;
+    if(mThread.joinable())
+        mThread.join();
+    Capture(space, mImage);
+    mPath = path;
+    mWriting = true;
+    mThread = std::thread([this](){
+        mSucceeded = WriteFile(mImage, mPath);
+        mWriting = false;
+    });
+    return true;
+}
+
+/**
+    Name: Wait()
+    Function: Waits for the background write to finish and returns whether
+    the last write succeeded.
+**/
+bool Checkpoint::Wait()
+{
+    if(mThread.joinable())
+        mThread.join();
+    return mSucceeded;
+}
+
+/**
+    Name: Save(Space&, const std::string&)
+    Function: Writes the space to the file right away.
+**/
+bool Checkpoint::Save(Space& space, const std::string& path)
+{
+    std::vector<char> image;
+    Capture(space, image);
+    return WriteFile(image, path);
+}
+
+/**
+    Name: Load(Space&, const std::string&)
+    Function: Maps the file and checks its header and size. All objects in
+    the space are then removed, the settings of the file are taken over and
+    the body store is attached to the arrays in the mapping, so that none of
+    the body state is copied. Only the names and colours are copied into
+    the info table. The loaded bodies have no objects of their own. Returns
+    false, leaving the space as it was, if the file is missing or is not a
+    checkpoint of this version and byte order.
+**/
+bool Checkpoint::Load(Space& space, const std::string& path)
+{
+    size_t size = 0;
+    char* pFile = (char*)MapFile(path, size);
+    if(pFile == 0)
+        return false;
+    /*  START: Check the file   */
+    CheckpointHeader header;
+    bool valid = size >= sizeof(header);
+    if(valid)
+    {
+        memcpy(&header, pFile, sizeof(header));
+        //  the capacity is checked before the size of the arrays is worked
+        //  out from it, so that it cannot overflow
+        valid = memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 &&
+                header.version == VERSION &&
+                header.byteOrder == ORDER_MARK &&
+                header.fileSize == size &&
+                header.count <= header.capacity &&
+                header.capacity % 8 == 0 &&
+                header.capacity < 0x7fffffff &&
+                header.arraysOffset % SECTION_ALIGNMENT == 0 &&
+                FitsIn(header.arraysOffset,
+                       ARRAY_COUNT*header.capacity*sizeof(double),
+                       header.infoOffset) &&
+                FitsIn(header.infoOffset,
+                       header.count*sizeof(CheckpointInfo),
+                       header.namesOffset) &&
+                FitsIn(header.namesOffset, header.namesSize,
+                       header.stateOffset) &&
+                header.stateOffset <= size &&
+                header.stateLength <=
+                    (size - header.stateOffset)/sizeof(double) &&
+                header.stateLength < 0x7fffffff &&
+                header.solver >= GRAVITY_DIRECT &&
+                header.solver <= GRAVITY_BARNES_HUT &&
+                header.precision >= PRECISION_DOUBLE &&
+                header.precision <= PRECISION_MIXED &&
+                header.integrator >= INTEGRATOR_EULER &&
+                header.integrator <= INTEGRATOR_WISDOM_HOLMAN &&
+                isfinite(header.theta) && header.theta >= 0 &&
+                isfinite(header.softening) && header.softening >= 0 &&
+                isfinite(header.radiusScale);
+    }
+    if(!valid)
+    {
+        UnmapFile(pFile, size);
+        return false;
+    }
+    /*  END: Check the file */
+    /*  START: Read the info of every body   */
+    const int count = (int)header.count;
+    std::vector<BodyInfo> info(count);
+    const CheckpointInfo* pInfo =
+        (const CheckpointInfo*)(pFile + header.infoOffset);
+    const char* pNames = pFile + header.namesOffset;
+    uint64_t nameOffset = 0;
+    for(int i = 0; i < count; i++)
+    {
+        const CheckpointInfo& record = pInfo[i];
+        if(record.nameLength > header.namesSize - nameOffset ||
+           record.type >= BODY_TYPE_COUNT)
+        {
+            UnmapFile(pFile, size);
+            return false;
+        }
+        info[i].name.assign(pNames + nameOffset, record.nameLength);
+        nameOffset += record.nameLength;
+        info[i].radius      = record.radius;
+        info[i].red         = record.red;
+        info[i].green       = record.green;
+        info[i].blue        = record.blue;
+        info[i].type        = (BodyType)record.type;
+        info[i].lightSource = record.lightSource;
+        info[i].pObject     = 0;
+    }
+    /*  END: Read the info of every body */
+    space.ClearObjects();
+    space.SetTime(header.time);
+    space.SetGravitySolver((GravitySolver)header.solver);
+    space.SetGravityPrecision((GravityPrecision)header.precision);
+    space.SetOpeningAngle(header.theta);
+    space.SetSoftening(header.softening);
+    space.SetMergeCollisions(header.radiusScale > 0);
+    if(header.radiusScale > 0)
+        space.SetRadiusScale(header.radiusScale);
+    space.SetIntegrator((IntegratorType)header.integrator);
+    //  the state is read before the mapping can be let go of
+    const double* pState = (const double*)(pFile + header.stateOffset);
+    std::vector<double> state(pState, pState + header.stateLength);
+    //  the kernels read the padding after the last body as bodies without
+    //  mass, so it is cleared in case the file has anything else there, as
+    //  the mapping is private this does not change the file
+    double* pArrays = (double*)(pFile + header.arraysOffset);
+    for(int a = 0; a < ARRAY_COUNT; a++)
+        memset(pArrays + a*header.capacity + count, 0,
+               (header.capacity - count)*sizeof(double));
+    space.GetBodies().Attach(pArrays, count, (int)header.capacity, info,
+                             pFile, size, UnmapFile);
+    space.BodiesChanged();
+    if(!state.empty())
+        space.GetIntegrator()->LoadState(space, &state[0], state.size());
+    return true;
+}
+
+/**
+    Name: Capture(Space&, std::vector<char>&)
+    Function: Lays out the whole file for the space in the vector. The body
+    arrays are copied with their padding, which is kept at zero by the body
+    store, so that they can be used in place when loaded.
+**/
+void Checkpoint::Capture(Space& space, std::vector<char>& image)
+{
+    BodyStore& bodies = space.GetBodies();
+    const int count = bodies.GetCount();
+    //  an empty store has no arrays yet
+    const uint64_t capacity = bodies.GetCapacity();
+    std::vector<double> state;
+    space.GetIntegrator()->SaveState(state);
+    /*  START: Lay out the sections    */
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version      = VERSION;
+    header.byteOrder    = ORDER_MARK;
+    header.count        = count;
+    header.capacity     = capacity;
+    header.arraysOffset = AlignUp(sizeof(header));
+    header.infoOffset   = AlignUp(header.arraysOffset +
+                                  ARRAY_COUNT*capacity*sizeof(double));
+    header.namesOffset  = AlignUp(header.infoOffset +
+                                  count*sizeof(CheckpointInfo));
+    header.namesSize    = 0;
+    for(int i = 0; i < count; i++)
+        header.namesSize += bodies.GetInfo(i).name.size();
+    header.stateOffset  = AlignUp(header.namesOffset + header.namesSize);
+    header.stateLength  = state.size();
+    header.fileSize     = header.stateOffset + state.size()*sizeof(double);
+    header.time         = space.GetTime();
+    header.integrator   = space.GetIntegratorType();
+    header.solver       = space.GetGravitySolver();
+    header.precision    = space.GetGravityPrecision();
+    header.theta        = space.GetOpeningAngle();
+    header.softening    = space.GetSoftening();
+    header.radiusScale  = space.GetMergeCollisions() ?
+                          space.GetRadiusScale() : 0;
+    /*  END: Lay out the sections  */
+    /*  START: Fill in the sections  */
+    image.assign(header.fileSize, 0);
+    char* pImage = &image[0];
+    memcpy(pImage, &header, sizeof(header));
+    double* pArrays[ARRAY_COUNT] = {bodies.GetX(), bodies.GetY(),
+                                    bodies.GetZ(), bodies.GetVx(),
+                                    bodies.GetVy(), bodies.GetVz(),
+                                    bodies.GetFx(), bodies.GetFy(),
+                                    bodies.GetFz(), bodies.GetMass()};
+    for(int i = 0; i < ARRAY_COUNT && capacity > 0; i++)
+    {
+        memcpy(pImage + header.arraysOffset + i*capacity*sizeof(double),
+               pArrays[i], capacity*sizeof(double));
+    }
+    CheckpointInfo* pInfo = (CheckpointInfo*)(pImage + header.infoOffset);
+    char* pNames = pImage + header.namesOffset;
+    for(int i = 0; i < count; i++)
+    {
+        BodyInfo& info = bodies.GetInfo(i);
+        pInfo[i].radius         = info.radius;
+        pInfo[i].red            = info.red;
+        pInfo[i].green          = info.green;
+        pInfo[i].blue           = info.blue;
+        pInfo[i].type           = info.type;
+        pInfo[i].lightSource    = info.lightSource;
+        pInfo[i].nameLength     = info.name.size();
+        memcpy(pNames, info.name.data(), info.name.size());
+        pNames += info.name.size();
+    }
+    if(!state.empty())
+    {
+        memcpy(pImage + header.stateOffset, &state[0],
+               state.size()*sizeof(double));
+    }
+    /*  END: Fill in the sections    */
+}
+
+/**
+    Name: WriteFile(const std::vector<char>&, const std::string&)
+    Function: Writes the vector to a temporary file next to the named file
+    and renames it over the named file once it is complete.
+**/
+bool Checkpoint::WriteFile(const std::vector<char>& image,
+                           const std::string& path)
+{
+    std::string temporary = path + ".tmp";
+    FILE* pFile = fopen(temporary.c_str(), "wb");
+    if(pFile == 0)
+        return false;
+    bool written = fwrite(&image[0], 1, image.size(), pFile) == image.size();
+    written = fclose(pFile) == 0 && written;
+    if(!written)
+    {
+        remove(temporary.c_str());
+        return false;
+    }
+#ifdef _WIN32
+    //  rename does not replace an existing file on Windows
+    remove(path.c_str());
+#endif
+    return rename(temporary.c_str(), path.c_str()) == 0;
+}
@@ -0,0 +1,78 @@
+/****************************************************************************
+*   FILE: Checkpoint.h
+*
+*   FUNCTION: This class saves a space to a binary checkpoint file and loads
+*   it back. The file holds the state of every body, the time of a step,
+*   the gravity solver, the softening, the collision settings and the
+*   integrator with whatever it keeps between steps. The body arrays are
+*   stored exactly as the body store keeps them in memory, aligned and
+*   padded, so loading maps the file and lets the store use the arrays in
+*   place. Saving can be done on a background thread, after a quick copy of
+*   the space.
+*
+*   PURPOSE: Without checkpoints every run starts from the objects created
+*   in code, and a long run that is stopped is lost. Mapping the file makes
+*   restarting a space of a million bodies a matter of milliseconds, since
+*   nothing has to be parsed or copied, and saving in the background does
+*   not hold up the stepping for longer than the copy.
+*
+*   FORMAT: All numbers are in the byte order of the machine that wrote the
+*   file, which is checked on loading. A 128 byte header is followed by the
+*   x, y, z, vx, vy, vz, fx, fy, fz and mass arrays, each as long as the
+*   padded capacity and starting 64 bytes aligned. After them come one 32 byte
+*   record per body (radius, colour, type, light source and name length),
+*   the names one after the other, and the state of the integrator.
+*
+****************************************************************************/
+
+#ifndef _Checkpoint_
+#define _Checkpoint_
+
+#include "Space.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Checkpoint{
+    public:
+    /** Constructors    **/
+    //  constructs a checkpoint writer that is not writing
+    Checkpoint();
+    //  waits for the background write to finish
+    ~Checkpoint();
+    /** Member Functions   **/
+    //  copies the space and writes it to the file named by the string on
+    //  a background thread, returns false if a write is still going on
+    bool                SaveAsync(Space&, const std::string&);
+    //  waits for the background write and returns whether it succeeded
+    bool                Wait();
+    //  writes the space to the file named by the string right away
+    static bool         Save(Space&, const std::string&);
+    //  replaces all objects in the space with the ones in the file named
+    //  by the string, returns false if the file could not be loaded
+    static bool         Load(Space&, const std::string&);
+    /** Getters and Setters **/
+    bool                IsWriting()
+                            {return mWriting;}
+
+    private:
+    //  a checkpoint writer owns a thread and can therefore not be copied
+    Checkpoint(const Checkpoint&);
+    Checkpoint&         operator=(const Checkpoint&);
+    //  lays out the whole file for the space in the vector
+    static void         Capture(Space&, std::vector<char>&);
+    //  writes the vector to the file named by the string, through a
+    //  temporary file so that a failed write never leaves half a file
+    static bool         WriteFile(const std::vector<char>&,
+                                  const std::string&);
+
+    /** Class Members   **/
+    std::thread         mThread;
+    std::vector<char>   mImage;
+    std::string         mPath;
+    std::atomic<bool>   mWriting;
+    bool                mSucceeded;
+};
+
+#endif
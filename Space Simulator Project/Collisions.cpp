@@ -0,0 +1,337 @@
+/****************************************************************************
+*   FILE: Collisions.cpp
+*
+*   FUNCTION: This class finds the bodies in a body store that touch each
+*   other and merges every group of touching bodies into its heaviest body.
+*   The bodies are hashed into a uniform grid of cells a few radii wide, so
+*   that a body only has to be tested against the bodies in its own and the
+*   neighbouring cells. A merged body keeps the total mass, momentum and
+*   volume of its group and sits at the group's center of mass.
+*
+*   PURPOSE: Gravity grows without bound as two bodies get closer, so two
+*   bodies that meet fling each other away at absurd speeds instead of
+*   hitting each other. Merging them keeps the step sane, and the grid keeps
+*   the cost of finding them close to linear in the amount of bodies.
+*
+*   NOTES: The radius of a body is kept as drawn, not in meters, so it is
+*   multiplied by the radius scale first. A body far wider than the cells,
+*   such as a star among asteroids, is not put into the grid but tested
+*   against the cells its reach covers, or against every body if that is
+*   fewer. Bodies that pass through each other within a single step are
+*   not caught.
+*
+*   The grid is a hash table with a bucket per body or more, filled by a
+*   counting sort, so it costs two passes over the bodies and no memory
+*   besides a few arrays that are kept between merges.
+*
+****************************************************************************/
+
+#include "Collisions.h"
+#include <math.h>
+
+/**
+    Name: HashCell(long long, long long, long long)
+    Function: Mixes the coordinates of a grid cell into a hash, of which the
+    lower bits pick the bucket.
+**/
+static inline unsigned long long HashCell(long long x, long long y,
+                                          long long z)
+{
+    unsigned long long hash = (unsigned long long)x*0x9e3779b97f4a7c15ULL ^
+                              (unsigned long long)y*0xc2b2ae3d27d4eb4fULL ^
+                              (unsigned long long)z*0x165667b19e3779f9ULL;
+    return hash ^ hash >> 29;
+}
+
+/****************************************************************************
+* Constructors
+*
+****************************************************************************/
+
+/**
+    Name: Collisions()
+    Function: Constructs a collision finder where a radius of one is a
+    million kilometers, which makes a planet drawn at 0.0125 about twice as
+    wide as the earth.
+**/
+Collisions::Collisions()
+{
+    mRadiusScale = 1e9;
+    mBucketMask = 0;
+}
+
+/****************************************************************************
+* Member Functions
+*
+****************************************************************************/
+
+/**
+    Name: Merge(BodyStore&)
+    Function: Finds every pair of bodies closer than the sum of their radii
+    and merges every group of bodies connected by such pairs into the
+    heaviest body of the group. That body gets the total mass and volume of
+    the group and moves to its center of mass with the velocity that keeps
+    its momentum. The other bodies are left in the store with their indices
+    listed in order, to be removed by the caller, and their amount is
+    returned.
+**/
+int Collisions::Merge(BodyStore& bodies)
+{
+    mAbsorbed.clear();
+    mPairs.clear();
+    const int count = bodies.GetCount();
+    if(count < 2 || mRadiusScale <= 0)
+        return 0;
+    const double* pX = bodies.GetX();
+    const double* pY = bodies.GetY();
+    const double* pZ = bodies.GetZ();
+    /*  START: Find the touching pairs  */
+    mRadius.resize(count);
+    double totalRadius = 0;
+    for(int i = 0; i < count; i++)
+    {
+        mRadius[i] = bodies.GetInfo(i).radius*mRadiusScale;
+        totalRadius += mRadius[i];
+    }
+    if(totalRadius <= 0)
+        return 0;
+    //  bodies up to twice the mean radius fit the grid, and two of them can
+    //  only touch from neighbouring cells
+    const double cellSize = 4*totalRadius/count;
+    mParent.resize(count);
+    for(int i = 0; i < count; i++)
+        mParent[i] = i;
+    BuildGrid(bodies, cellSize);
+    for(int i = 0; i < count; i++)
+    {
+        if(2*mRadius[i] > cellSize)
+            continue;
+        for(int dx = -1; dx <= 1; dx++)
+            for(int dy = -1; dy <= 1; dy++)
+                for(int dz = -1; dz <= 1; dz++)
+                    TestCell(bodies, i, mCellX[i] + dx, mCellY[i] + dy,
+                             mCellZ[i] + dz, true);
+    }
+    const double gridCount = mBucketBodies.size();
+    for(unsigned int k = 0; k < mWide.size(); k++)
+    {
+        const int i = mWide[k];
+        //  the widest body in the grid is half a cell wide
+        const double reach = mRadius[i] + 0.5*cellSize;
+        const long long lowX = (long long)floor((pX[i] - reach)/cellSize);
+        const long long lowY = (long long)floor((pY[i] - reach)/cellSize);
+        const long long lowZ = (long long)floor((pZ[i] - reach)/cellSize);
+        const long long highX = (long long)floor((pX[i] + reach)/cellSize);
+        const long long highY = (long long)floor((pY[i] + reach)/cellSize);
+        const long long highZ = (long long)floor((pZ[i] + reach)/cellSize);
+        const double cells = (highX - lowX + 1.0)*(highY - lowY + 1.0)*
+                             (highZ - lowZ + 1.0);
+        if(cells < gridCount)
+        {
+            for(long long x = lowX; x <= highX; x++)
+                for(long long y = lowY; y <= highY; y++)
+                    for(long long z = lowZ; z <= highZ; z++)
+                        TestCell(bodies, i, x, y, z, false);
+        }
+        else
+        {
+            for(int j = 0; j < count; j++)
+            {
+                if(2*mRadius[j] <= cellSize)
+                    Test(bodies, i, j);
+            }
+        }
+        //  the wide bodies are few and tested against each other directly
+        for(unsigned int l = k + 1; l < mWide.size(); l++)
+            Test(bodies, i, mWide[l]);
+    }
+    /*  END: Find the touching pairs    */
+    if(mPairs.empty())
+        return 0;
+    /*  START: Sum up every group   */
+    mGroupOf.assign(count, -1);
+    mGroups.clear();
+    for(unsigned int p = 0; p < mPairs.size(); p++)
+    {
+        const int root = Find(mPairs[p]);
+        if(mGroupOf[root] != -1)
+            continue;
+        mGroupOf[root] = mGroups.size();
+        Group group = {root, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+        mGroups.push_back(group);
+    }
+    const double* pVx = bodies.GetVx();
+    const double* pVy = bodies.GetVy();
+    const double* pVz = bodies.GetVz();
+    const double* pFx = bodies.GetFx();
+    const double* pFy = bodies.GetFy();
+    const double* pFz = bodies.GetFz();
+    const double* pMass = bodies.GetMass();
+    for(int i = 0; i < count; i++)
+    {
+        const int g = mGroupOf[Find(i)];
+        if(g == -1)
+            continue;
+        Group& group = mGroups[g];
+        const double mass = pMass[i];
+        group.mass += mass;
+        group.x += mass*pX[i];
+        group.y += mass*pY[i];
+        group.z += mass*pZ[i];
+        group.vx += mass*pVx[i];
+        group.vy += mass*pVy[i];
+        group.vz += mass*pVz[i];
+        group.fx += pFx[i];
+        group.fy += pFy[i];
+        group.fz += pFz[i];
+        const double radius = bodies.GetInfo(i).radius;
+        group.volume += radius*radius*radius;
+        //  of equally heavy bodies the first one stays
+        const double heaviest = pMass[group.heaviest];
+        if(mass > heaviest || (mass == heaviest && i < group.heaviest))
+            group.heaviest = i;
+    }
+    /*  END: Sum up every group */
+    /*  START: Merge every group into its heaviest body */
+    for(unsigned int g = 0; g < mGroups.size(); g++)
+    {
+        const Group& group = mGroups[g];
+        const int i = group.heaviest;
+        //  bodies without mass have no center of mass, the heaviest of
+        //  them just takes the others in
+        if(group.mass > 0)
+        {
+            bodies.SetPosition(i, Vec3d(group.x, group.y, group.z)/
+                                  group.mass);
+            bodies.SetVelocity(i, Vec3d(group.vx, group.vy, group.vz)/
+                                  group.mass);
+        }
+        bodies.GetMass()[i] = group.mass;
+        bodies.SetForce(i, Vec3d(group.fx, group.fy, group.fz));
+        bodies.GetInfo(i).radius = cbrt(group.volume);
+    }
+    for(int i = 0; i < count; i++)
+    {
+        const int g = mGroupOf[Find(i)];
+        if(g != -1 && mGroups[g].heaviest != i)
+            mAbsorbed.push_back(i);
+    }
+    /*  END: Merge every group into its heaviest body   */
+    return mAbsorbed.size();
+}
+
+/**
+    Name: BuildGrid(BodyStore&, double)
+    Function: Finds the grid cell of every body at most as wide as half the
+    given cell size and sorts those bodies into the buckets of the hash
+    table by counting them first. The wider bodies are listed apart.
+**/
+void Collisions::BuildGrid(BodyStore& bodies, double cellSize)
+{
+    const int count = bodies.GetCount();
+    const double* pX = bodies.GetX();
+    const double* pY = bodies.GetY();
+    const double* pZ = bodies.GetZ();
+    mCellX.resize(count);
+    mCellY.resize(count);
+    mCellZ.resize(count);
+    mWide.clear();
+    int gridCount = 0;
+    for(int i = 0; i < count; i++)
+    {
+        if(2*mRadius[i] > cellSize)
+        {
+            mWide.push_back(i);
+            continue;
+        }
+        mCellX[i] = (long long)floor(pX[i]/cellSize);
+        mCellY[i] = (long long)floor(pY[i]/cellSize);
+        mCellZ[i] = (long long)floor(pZ[i]/cellSize);
+        gridCount++;
+    }
+    //  at least two buckets per body keeps them short
+    unsigned long long buckets = 1;
+    while(buckets < 2ULL*gridCount)
+        buckets *= 2;
+    mBucketMask = buckets - 1;
+    /*  START: Sort the bodies into the buckets */
+    mBucketStart.assign(buckets + 1, 0);
+    for(int i = 0; i < count; i++)
+    {
+        if(2*mRadius[i] <= cellSize)
+            mBucketStart[(HashCell(mCellX[i], mCellY[i], mCellZ[i]) &
+                          mBucketMask) + 1]++;
+    }
+    for(unsigned long long b = 0; b < buckets; b++)
+        mBucketStart[b + 1] += mBucketStart[b];
+    mBucketBodies.resize(gridCount);
+    for(int i = 0; i < count; i++)
+    {
+        if(2*mRadius[i] <= cellSize)
+            mBucketBodies[mBucketStart[HashCell(mCellX[i], mCellY[i],
+                                                mCellZ[i]) &
+                                       mBucketMask]++] = i;
+    }
+    //  every start was moved up to the next one while filling
+    for(unsigned long long b = buckets; b > 0; b--)
+        mBucketStart[b] = mBucketStart[b - 1];
+    mBucketStart[0] = 0;
+    /*  END: Sort the bodies into the buckets   */
+}
+
+/**
+    Name: TestCell(BodyStore&, int, long long, long long, long long, bool)
+    Function: Tests the body against every body in the grid cell at the
+    given coordinates. Other cells sharing the bucket are skipped. When the
+    flag is set only bodies after this one are tested, so that two bodies
+    in the grid are tested once.
+**/
+void Collisions::TestCell(BodyStore& bodies, int i, long long x,
+                          long long y, long long z, bool after)
+{
+    const unsigned long long bucket = HashCell(x, y, z) & mBucketMask;
+    for(int k = mBucketStart[bucket]; k < mBucketStart[bucket + 1]; k++)
+    {
+        const int j = mBucketBodies[k];
+        if(after && j <= i)
+            continue;
+        if(mCellX[j] != x || mCellY[j] != y || mCellZ[j] != z)
+            continue;
+        Test(bodies, i, j);
+    }
+}
+
+/**
+    Name: Test(BodyStore&, int, int)
+    Function: Joins the groups of the two bodies if they are closer than the
+    sum of their radii, and remembers one of them.
+**/
+void Collisions::Test(BodyStore& bodies, int i, int j)
+{
+    const double dx = bodies.GetX()[j] - bodies.GetX()[i];
+    const double dy = bodies.GetY()[j] - bodies.GetY()[i];
+    const double dz = bodies.GetZ()[j] - bodies.GetZ()[i];
+    const double reach = mRadius[i] + mRadius[j];
+    if(dx*dx + dy*dy + dz*dz >= reach*reach)
+        return;
+    const int rootI = Find(i);
+    const int rootJ = Find(j);
+    if(rootI != rootJ)
+        mParent[rootJ] = rootI;
+    mPairs.push_back(i);
+}
+
+/**
+    Name: Find(int)
+    Function: Returns the root of the group of the body, pointing every body
+    on the way at its grandparent so that later searches are shorter.
+**/
+int Collisions::Find(int i)
+{
+    while(mParent[i] != i)
+    {
+        mParent[i] = mParent[mParent[i]];
+        i = mParent[i];
+    }
+    return i;
+}
@@ -0,0 +1,107 @@
+/****************************************************************************
+*   FILE: Collisions.h
+*
+*   FUNCTION: This class finds the bodies in a body store that touch each
+*   other and merges every group of touching bodies into its heaviest body.
+*   The bodies are hashed into a uniform grid of cells a few radii wide, so
+*   that a body only has to be tested against the bodies in its own and the
+*   neighbouring cells. A merged body keeps the total mass, momentum and
+*   volume of its group and sits at the group's center of mass.
+*
+*   PURPOSE: Gravity grows without bound as two bodies get closer, so two
+*   bodies that meet fling each other away at absurd speeds instead of
+*   hitting each other. Merging them keeps the step sane, and the grid keeps
+*   the cost of finding them close to linear in the amount of bodies.
+*
+*   NOTES: The radius of a body is kept as drawn, not in meters, so it is
+*   multiplied by the radius scale first. A body far wider than the cells,
+*   such as a star among asteroids, is not put into the grid but tested
+*   against the cells its reach covers, or against every body if that is
+*   fewer. Bodies that pass through each other within a single step are
+*   not caught.
+*
+****************************************************************************/
+
+#ifndef _Collisions_
+#define _Collisions_
+
+#include "BodyStore.h"
+#include <vector>
+
+class Collisions{
+    public:
+    /** Constructors    **/
+    //  constructs a collision finder with a radius scale of a million
+    //  kilometers
+    Collisions();
+    /** Member Functions   **/
+    //  merges every group of touching bodies in the store into its heaviest
+    //  body and returns the amount of bodies merged away, which are left in
+    //  the store for the caller to remove
+    int                 Merge(BodyStore&);
+    /** Getters and Setters **/
+    //  the indices of the bodies merged away by the last merge, sorted
+    const std::vector<int>& GetAbsorbed()
+                            {return mAbsorbed;}
+    //  the meters a radius of one stands for
+    double              GetRadiusScale()
+                            {return mRadiusScale;}
+    void                SetRadiusScale(double scale)
+                            {mRadiusScale = scale;}
+
+    private:
+    //  the sums over a group of touching bodies
+    struct Group{
+        int             heaviest;
+        double          mass;
+        //  the position and velocity weighted by mass
+        double          x;
+        double          y;
+        double          z;
+        double          vx;
+        double          vy;
+        double          vz;
+        double          fx;
+        double          fy;
+        double          fz;
+        //  the sum of the cubed radii, as drawn
+        double          volume;
+    };
+
+    //  hashes the bodies small enough for the given cell size into the grid
+    void                BuildGrid(BodyStore&, double);
+    //  tests the body against the bodies in the grid cell at the given
+    //  coordinates, only those after it in the store if the flag is set
+    void                TestCell(BodyStore&, int, long long, long long,
+                                 long long, bool);
+    //  tests the two bodies and joins their groups if they touch
+    void                Test(BodyStore&, int, int);
+    //  returns the body at the root of the body's group
+    int                 Find(int);
+
+    /** Class Members   **/
+    double              mRadiusScale;
+    //  the radius of every body in meters
+    std::vector<double> mRadius;
+    //  the grid cell of every body in the grid
+    std::vector<long long> mCellX;
+    std::vector<long long> mCellY;
+    std::vector<long long> mCellZ;
+    //  the bodies of every bucket of the hash table, and where every bucket
+    //  starts in them, followed by their amount
+    std::vector<int>    mBucketBodies;
+    std::vector<int>    mBucketStart;
+    unsigned long long  mBucketMask;
+    //  the bodies too wide for the grid
+    std::vector<int>    mWide;
+    //  the parent of every body in its group, a root is its own parent
+    std::vector<int>    mParent;
+    //  every pair of touching bodies found
+    std::vector<int>    mPairs;
+    //  the group of every root, -1 for none yet
+    std::vector<int>    mGroupOf;
+    std::vector<Group>  mGroups;
+    std::vector<int>    mAbsorbed;
+};
+
+#endif
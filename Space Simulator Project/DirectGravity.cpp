@@ -0,0 +1,221 @@
+/****************************************************************************
+*   FILE: DirectGravity.cpp
+*
+*   FUNCTION: This class calculates gravity between every pair of bodies in a
+*   body store. The pairs are split evenly over the threads of a thread pool,
+*   every thread adds its forces to a private set of force arrays, and the
+*   arrays are summed up into the result once all threads are done.
+*
+*   When the processor has vector instructions, every thread instead runs a
+*   vectorized kernel over its own rows, summing the pull of all bodies on
+*   each row. That calculates every pair twice, but the kernel handles
+*   several pairs per instruction and every thread only writes its own rows.
+*
+*   PURPOSE: Every pair writes to both of its bodies, so letting several
+*   threads write to the same force arrays would make them overwrite each
+*   other's results. Private arrays avoid that without any locking.
+*
+****************************************************************************/
+
+#include "DirectGravity.h"
+#include <math.h>
+
+/****************************************************************************
+ * Constructors
+ *
+ ***************************************************************************/
+
+/**
+    Name: DirectGravity()
+    Function: Constructs a solver that runs on the calling thread only until
+    a higher thread count is set, using the widest kernel the processor
+    supports. With only two doubles per vector, calculating every pair twice
+    is no faster than the pair loop, so SSE2 processors use the pair loop
+    unless the SSE2 kernel is asked for.
+**/
+DirectGravity::DirectGravity() : mThreads(1)
+{
+    mSoftening = 0;
+    KernelLevel level = GravityKernel::Detect();
+    SetKernel(level == KERNEL_SSE2 ? KERNEL_SCALAR : level);
+}
+
+/****************************************************************************
+* Member Functions
+*
+****************************************************************************/
+
+/**
+    Name: CalculatePairs(BodyStore&, int, int, double*, double*, double*)
+    Function: Calculates the gravity between every body from the first row up
+    to but not including the last row and every body after it in the store,
+    and adds the forces to the argument x, y and z force arrays. The square
+    of the softening length is added to the square of every distance.
+**/
+void DirectGravity::CalculatePairs(BodyStore& bodies, int firstRow,
+                                   int lastRow, double softening2,
+                                   double* pFx, double* pFy, double* pFz)
+{
+    //  the universal gravitational constant
+    const double g = 6.67428e-11;
+    const int count = bodies.GetCount();
+    const double* pX = bodies.GetX();
+    const double* pY = bodies.GetY();
+    const double* pZ = bodies.GetZ();
+    const double* pMass = bodies.GetMass();
+    //  iterate through the bodies
+    for(int i = firstRow; i < lastRow; i++)
+    {
+        const double x1 = pX[i];
+        const double y1 = pY[i];
+        const double z1 = pZ[i];
+        const double gm1 = g*pMass[i];
+        //  the force on the first body is summed up locally
+        double fx1 = 0;
+        double fy1 = 0;
+        double fz1 = 0;
+        //  iterate one step ahead of the previous for
+        for(int j = i + 1; j < count; j++)
+        {
+            //  calculate the distance between the two bodies
+            double dx = pX[j] - x1;
+            double dy = pY[j] - y1;
+            double dz = pZ[j] - z1;
+            //  calculate the lentgh of the distance
+            double length2 = dx*dx + dy*dy + dz*dz + softening2;
+            double length = sqrt(length2);
+            //  calculate the gravitational pull between the bodies:
+            //  F = (G*m1*m2)/r*r where r is the length of the distance,
+            //  divided by r once more to turn the distance into a direction
+            double force = (gm1*pMass[j])/(length2*length);
+            dx *= force;
+            dy *= force;
+            dz *= force;
+            //  add the gravitational force to body1
+            fx1 += dx;
+            fy1 += dy;
+            fz1 += dz;
+            //  add the gravitational force to body2
+            pFx[j] -= dx;
+            pFy[j] -= dy;
+            pFz[j] -= dz;
+        }
+        pFx[i] += fx1;
+        pFy[i] += fy1;
+        pFz[i] += fz1;
+    }
+}
+
+/**
+    Name: SplitRows(int)
+    Function: Splits the rows of the pair triangle into one range per thread
+    so that every range holds about the same amount of pairs. Row i holds
+    count-1-i pairs, so the early rows are longer and get fewer rows each.
+**/
+void DirectGravity::SplitRows(int count)
+{
+    const int threadCount = mThreads.GetThreadCount();
+    const double totalPairs = 0.5*count*(count - 1.0);
+    mFirstRow.assign(threadCount + 1, count);
+    mFirstRow[0] = 0;
+    double pairs = 0;
+    int thread = 1;
+    for(int i = 0; i < count && thread < threadCount; i++)
+    {
+        //  start the next range once this one holds its share of pairs
+        while(thread < threadCount &&
+              pairs >= totalPairs*thread/threadCount)
+        {
+            mFirstRow[thread] = i;
+            thread++;
+        }
+        pairs += count - 1 - i;
+    }
+}
+
+/**
+    Name: CalculateGravity(BodyStore&, double*, double*, double*)
+    Function: Calculates gravity between every pair of bodies in the store
+    and adds the forces to the argument x, y and z force arrays. With more
+    than one thread, every thread sums its pairs into its own arrays, and
+    then the threads sum up one part of the bodies each from all private
+    arrays.
+**/
+void DirectGravity::CalculateGravity(BodyStore& bodies, double* pFx,
+                                     double* pFy, double* pFz)
+{
+    const int count = bodies.GetCount();
+    const int threadCount = mThreads.GetThreadCount();
+    const double softening2 = mSoftening*mSoftening;
+    if(mKernel != KERNEL_SCALAR)
+    {
+        //  every row costs the same, so the rows are split evenly
+        mThreads.Run([&](int thread){
+            int first = (long long)count*thread/threadCount;
+            int last = (long long)count*(thread + 1)/threadCount;
+            mpKernel(bodies.GetX(), bodies.GetY(), bodies.GetZ(),
+                     bodies.GetMass(), count, first, last, softening2,
+                     pFx, pFy, pFz);
+        });
+        return;
+    }
+    if(threadCount == 1 || count < 2*threadCount)
+    {
+        CalculatePairs(bodies, 0, count, softening2, pFx, pFy, pFz);
+        return;
+    }
+    SplitRows(count);
+    mThreadFx.resize(threadCount);
+    mThreadFy.resize(threadCount);
+    mThreadFz.resize(threadCount);
+    mThreads.Run([&](int thread){
+        /*  START: Sum up the pairs of this thread   */
+        //  the private arrays are cleared by their own thread, which also
+        //  places their memory close to it
+        std::vector<double>& fx = mThreadFx[thread];
+        std::vector<double>& fy = mThreadFy[thread];
+        std::vector<double>& fz = mThreadFz[thread];
+        fx.assign(count, 0);
+        fy.assign(count, 0);
+        fz.assign(count, 0);
+        CalculatePairs(bodies, mFirstRow[thread], mFirstRow[thread + 1],
+                       softening2, &fx[0], &fy[0], &fz[0]);
+        /*  END: Sum up the pairs of this thread */
+    });
+    mThreads.Run([&](int thread){
+        /*  START: Reduce the private arrays into the result */
+        int first = (long long)count*thread/threadCount;
+        int last = (long long)count*(thread + 1)/threadCount;
+        for(int t = 0; t < threadCount; t++)
+        {
+            const double* pThreadFx = &mThreadFx[t][0];
+            const double* pThreadFy = &mThreadFy[t][0];
+            const double* pThreadFz = &mThreadFz[t][0];
+            for(int i = first; i < last; i++)
+            {
+                pFx[i] += pThreadFx[i];
+                pFy[i] += pThreadFy[i];
+                pFz[i] += pThreadFz[i];
+            }
+        }
+        /*  END: Reduce the private arrays into the result   */
+    });
+}
+
+/****************************************************************************
+* Getters and Setters
+*
+****************************************************************************/
+
+/**
+    Name: SetKernel(KernelLevel)
+    Function: Uses the kernel for the given instruction set. If the processor
+    does not support it, the widest supported set below it is used instead.
+    The scalar level uses the pair loop, which calculates every pair once.
+**/
+void DirectGravity::SetKernel(KernelLevel level)
+{
+    KernelLevel supported = GravityKernel::Detect();
+    mKernel = level < supported ? level : supported;
+    mpKernel = GravityKernel::Get(mKernel);
+}
@@ -0,0 +1,76 @@
+/****************************************************************************
+*   FILE: DirectGravity.h
+*
+*   FUNCTION: This class calculates gravity between every pair of bodies in a
+*   body store. The pairs are split evenly over the threads of a thread pool,
+*   every thread adds its forces to a private set of force arrays, and the
+*   arrays are summed up into the result once all threads are done.
+*
+*   When the processor has vector instructions, every thread instead runs a
+*   vectorized kernel over its own rows, summing the pull of all bodies on
+*   each row. That calculates every pair twice, but the kernel handles
+*   several pairs per instruction and every thread only writes its own rows.
+*
+*   PURPOSE: Every pair writes to both of its bodies, so letting several
+*   threads write to the same force arrays would make them overwrite each
+*   other's results. Private arrays avoid that without any locking.
+*
+****************************************************************************/
+
+#ifndef _DirectGravity_
+#define _DirectGravity_
+
+#include "BodyStore.h"
+#include "ThreadPool.h"
+#include "GravityKernel.h"
+#include <vector>
+
+class DirectGravity{
+    public:
+    /** Constructors    **/
+    //  constructs a solver running on a single thread
+    DirectGravity();
+    /** Member Functions   **/
+    //  adds the gravitational force on every body in the store to the
+    //  argument force arrays
+    void                CalculateGravity(BodyStore&, double*, double*,
+                                         double*);
+    //  adds the forces between every body in the given range of rows and all
+    //  bodies after it to the argument force arrays, softened by the given
+    //  square of the softening length
+    static void         CalculatePairs(BodyStore&, int, int, double,
+                                       double*, double*, double*);
+    /** Getters and Setters **/
+    int                 GetThreadCount()
+                            {return mThreads.GetThreadCount();}
+    void                SetThreadCount(int threadCount)
+                            {mThreads.SetThreadCount(threadCount);}
+    KernelLevel         GetKernel()
+                            {return mKernel;}
+    //  uses the kernel for the given instruction set, or the widest one
+    //  supported below it
+    void                SetKernel(KernelLevel);
+    //  the Plummer softening length in meters, 0 for none
+    double              GetSoftening()
+                            {return mSoftening;}
+    void                SetSoftening(double softening)
+                            {mSoftening = softening;}
+
+    private:
+    //  splits the rows of pairs into one range per thread
+    void                SplitRows(int);
+
+    /** Class Members   **/
+    ThreadPool                          mThreads;
+    KernelLevel                         mKernel;
+    GravityKernelFunction               mpKernel;
+    double                              mSoftening;
+    //  the first row of every thread, followed by the amount of bodies
+    std::vector<int>                    mFirstRow;
+    //  the private force arrays of every thread
+    std::vector< std::vector<double> >  mThreadFx;
+    std::vector< std::vector<double> >  mThreadFy;
+    std::vector< std::vector<double> >  mThreadFz;
+};
+
+#endif
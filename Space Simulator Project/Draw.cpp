@@ -2,9 +2,13 @@
 *   FILE: Draw.cpp
 *
 *   FUNCTION: This class is responsible for ALL drawing done in the application.
-*   It uses a window as the target for drawing and a space for the content to
-*   draw. The class manages GLUT fucntion calls, variables, user-input,
-*   scaling from window coordinates to real coordinates and vice versa.
+*   It uses a window as the target for drawing and a simulation for the
+*   content to draw. The class manages GLUT fucntion calls, variables,
+*   user-input, scaling from window coordinates to real coordinates and vice
+*   versa.
+*   Every frame is drawn from the newest snapshot of the simulation by the
+*   scene it is built on, and user input that changes the space is posted
+*   to the simulation.
 *
 *   PURPOSE: By collecting all the drawing done in the application in one
 *   class it keeps the cohesion at a manageable level. It might also make it
@@ -13,6 +17,28 @@
 ****************************************************************************/
 
 #include "Draw.h"
+#include <chrono>
+#include <stdio.h>
+#include <thread>
+#ifdef FREEGLUT
+#include <GL/freeglut_ext.h>
+#endif
+
+/**
+    Name: GetGlProc(const char*)
+    Function: Returns the address of the GL function with the given name,
+    or 0 where it cannot be looked up.
+**/
+static void* GetGlProc(const char* pName)
+{
+#if defined(FREEGLUT)
+    return (void*)glutGetProcAddress(pName);
+#elif defined(_WIN32)
+    return (void*)wglGetProcAddress(pName);
+#else
+    return 0;
+#endif
+}
 
 /****************************************************************************
  * Constructors
@@ -20,64 +46,22 @@
  ***************************************************************************/
 
 /**
-    Name: Draw(Window*, Space*, double)
+    Name: Draw(Window*, Simulation*, double)
     Function: Constructs a draw object by giving it a window to draw in, a
-    space to draw as well as the starting scale of the window. This function
-    also sets up the material and light variables to be used when drawing as
-    well specifying the functions to be called by GLUT.
+    simulation to draw as well as the starting scale of the window. This
+    function also sets up the scene in the window as well specifying the
+    functions to be called by GLUT.
 **/
-Draw::Draw(Window* pWindow, Space* pSpace, double scaleAu)
+Draw::Draw(Window* pWindow, Simulation* pSimulation, double scaleAu)
 {
     mpWindow        = pWindow;
-    mpSpace         = pSpace;
+    mpSimulation    = pSimulation;
+    mpSnapshot      = &mpSimulation->Acquire();
     mScaleAu        = scaleAu;
-    mLookAt         = mpSpace->GetObjectsInSpace();
-    mLookAtIterator = mLookAt.begin();
-
-    //  enable lighting
-    const GLfloat lightAmbient[]  = {0.0, 0.0, 0.0, 1.0};
-    const GLfloat lightDiffuse[]  = {1.0, 1.0, 1.0, 1.0};
-
-    //  enable materials
-    glEnable(GL_COLOR_MATERIAL);
-    //  enable lighting
-    glEnable(GL_LIGHTING);
-
-    /*  START: Enable light emission from all suns   */
-    //  create a copy of the list of the stars in space
-    std::list<Star*> starsList = mpSpace->GetStarsInSpace();
-    //  create a star list iterator
-    std::list<Star*>::iterator starsIterator;
-    //  iterate through the stars in space
-    for(starsIterator = starsList.begin();
-        starsIterator != starsList.end(); starsIterator++)
-    {
-        //  set a temporary emitter pointer
-        Star* pStar = *starsIterator;
-        if(pStar->GetLightSource())
-        {
-            //  enable lighting
-            glEnable(pStar->GetLightSource());
-            //  specify ambient lighting
-            glLightfv(pStar->GetLightSource(), GL_AMBIENT,  lightAmbient);
-            //  specify diffuse lighting
-            glLightfv(pStar->GetLightSource(), GL_DIFFUSE,  lightDiffuse);
-        }
-    }
-    /*  END: Enable lighting from all suns  */
+    mShownRate      = -1;
 
-    /*  START: Set materials    */
-    const GLfloat matAmbient[]    = {0.7, 0.7, 0.7, 1.0};
-    const GLfloat matDiffuse[]    = {0.8, 0.8, 0.8, 1.0};
-    const GLfloat highShininess[] = {50.0};
-
-    //  specify material ambient properties
-    glMaterialfv(GL_FRONT, GL_AMBIENT,   matAmbient);
-    //  specify diffuse properties
-    glMaterialfv(GL_FRONT, GL_DIFFUSE,   matDiffuse);
-    //  specify shininess
-    glMaterialfv(GL_FRONT, GL_SHININESS, highShininess);
-    /*  END: Set materials  */
+    //  set up the lights, materials and spheres in the window
+    Init(GetGlProc);
     //  point to my static GLUT handlers
     //  which in turn will call for my non-static handlers
     glutDisplayFunc(DisplayWrapper);
@@ -101,186 +85,21 @@ void Draw::Start()
 }
 
 /**
-    Name: DrawSphere(Coordinate, double)
-    Function: Draws a sphere using the arguments radius(in screen percentage)
-    and a position coordinate(that is being scaled to screen percentages
-    within the function).
-**/
-void Draw::DrawSphere(Coordinate position, double radius)
-{
-    //  start new state
-    glPushMatrix();
-    //  set the position of the object
-    glTranslated(ToScale(position.GetX()), ToScale(position.GetY()), 0.0);
-    //  draw object
-    glutSolidSphere(radius, 80, 80);
-    //  go back to previous state
-    glPopMatrix();
-}
-
-/**
-    Name: DrawLighting(Star*)
-    Function: Draws lighting on the argument star.
-**/
-void Draw::DrawLighting(Star* pStar)
-{
-            //  draws light positioned at the center of the star
-            float gLightPosition[] = {0.0, 0.0, 1.0, 1.0};
-            glLightfv(GL_LIGHT0, GL_POSITION, gLightPosition);
-}
-
-/**
-    Name: DrawLighting(Planet*)
-    Function: Draws lighting from all the stars in space on the argument
-    planet.
-**/
-void Draw::DrawLighting(Planet* pPlanet)
-{
-    //  create a copy of the list of the stars in space
-    std::list<Star*> starsList = mpSpace->GetStarsInSpace();
-    //  create a star list iterator
-    std::list<Star*>::iterator starsIterator;
-    //  iterate through the stars in space
-    for(starsIterator = starsList.begin();
-        starsIterator != starsList.end(); starsIterator++)
-    {
-        //  set a temporary emitter pointer
-        Star* pStar = *starsIterator;
-        //  calculate difference in x-axis
-        double x
-               = pStar->GetPosition().GetX() - pPlanet->GetPosition().GetX();
-        //  calculate difference in y-axis
-        double y
-               = pStar->GetPosition().GetY() - pPlanet->GetPosition().GetY();
-        //  set the light position towards the star
-        float gLightPosition[] = {x, y, 1.0, 1.0};
-        glLightfv(pStar->GetLightSource(), GL_POSITION, gLightPosition);
-    }
-}
-
-/**
-    Name: DrawLighting(Moon*)
-    Function: Draws lighting from all the stars in space on the argument
-    moon.
-**/
-void Draw::DrawLighting(Moon* pMoon)
-{
-    //  create a copy of the list of the stars in space
-    std::list<Star*> starsList = mpSpace->GetStarsInSpace();
-    //  create a star list iterator
-    std::list<Star*>::iterator starsIterator;
-    //  iterate through the stars in space
-    for(starsIterator = starsList.begin();
-        starsIterator != starsList.end(); starsIterator++)
-    {
-            //  set a temporary emitter pointer
-            Star* pStar = *starsIterator;
-            //  calculate difference in x-axis
-            float x =
-               pStar->GetPosition().GetX() - pMoon->GetPosition().GetX();
-            //  calculate difference in y-axis
-            float y =
-               pStar->GetPosition().GetY() - pMoon->GetPosition().GetY();
-            //  set the light position towards the star
-            float gLightPosition[] = {x, y, 1.0, 1.0};
-            glLightfv(pStar->GetLightSource(), GL_POSITION, gLightPosition);
-    }
-}
-
-/**
-    Name: DrawStars()
-    Function: Draws all the stars in space.
-**/
-void Draw::DrawStars()
-{
-    //  save a copy of the stars list
-    std::list<Star*> starsList = mpSpace->GetStarsInSpace();
-    //  iterate through the list
-    for(std::list<Star*>::iterator starsIterator = starsList.begin();
-        starsIterator != starsList.end(); starsIterator++)
-    {
-        //  create a temporary pointer to the current object
-        Star* pStar = *starsIterator;
-        //  set the colour to be used
-        glColor3f(pStar->GetRed(),
-                  pStar->GetGreen(),
-                  pStar->GetBlue());
-        //  draw the lighting on the current object
-        DrawLighting(pStar);
-        //  draw a sphere of the object
-        DrawSphere(pStar->GetPosition(), pStar->GetRadius());
-    }
-
-}
-
-/**
-    Name: DrawPlanets()
-    Function: Draws all the planets in space.
+    Name: ShowRate()
+    Function: Shows the simulated days per wall second the simulation
+    achieved and asked for in the window title. The title is only changed
+    when the simulation has measured a new rate.
 **/
-void Draw::DrawPlanets()
+void Draw::ShowRate()
 {
-    //  save a copy of the planets list
-    std::list<Planet*> planetsList = mpSpace->GetPlanetsInSpace();
-    //  iterate through the list
-    for(std::list<Planet*>::iterator planetsIterator = planetsList.begin();
-        planetsIterator != planetsList.end(); planetsIterator++)
-    {
-        //  create a temporary pointer to the current object
-        Planet * pPlanet = *planetsIterator;
-        //  set the colours to be used
-        glColor3f(pPlanet->GetRed(),
-                  pPlanet->GetGreen(),
-                  pPlanet->GetBlue());
-        //  draw the lighting on the current object
-        DrawLighting(pPlanet);
-        //  draw a sphere of the current object
-        DrawSphere(pPlanet->GetPosition(), pPlanet->GetRadius());
-    }
-}
-
-/**
-    Name: DrawMoons()
-    Function: Draws all the moons in space.
-**/
-void Draw::DrawMoons()
-{
-    //  save a copy of the moons list
-    std::list<Moon*> moonsList = mpSpace->GetMoonsInSpace();
-    //  iterate through the list
-    for(std::list<Moon*>::iterator moonsIt = moonsList.begin();
-        moonsIt != moonsList.end(); moonsIt++)
-    {
-        //  create a temporary pointer to the current object
-        Moon * pMoon = *moonsIt;
-        //  set the colour to be used
-        glColor3f(pMoon->GetRed(),
-                  pMoon->GetGreen(),
-                  pMoon->GetBlue());
-        //  draw the lighting on the current object
-        DrawLighting(pMoon);
-        //  draw a sphere of the current object
-        DrawSphere(pMoon->GetPosition(), pMoon->GetRadius());
-    }
-}
-
-/**
-    Name: ToScale(double)
-    Function: Scales the argument from meters to window percentages.
-**/
-double Draw::ToScale(double meters)
-{
-    //  One Astronomical Unit(roughly the distance between the sun and the earth)
-    //  is equal to 149598e6 meters
-    return (meters/(149598e6*mScaleAu));
-}
-
-/**
-    Name: FromScale(double)
-    Function: Scales the argument from window percentages to meters.
-**/
-double Draw::FromScale(double screenPercentage)
-{
-    return screenPercentage*149598e6*mScaleAu;
+    if(mpSnapshot->rate == mShownRate)
+        return;
+    mShownRate = mpSnapshot->rate;
+    char title[128];
+    snprintf(title, sizeof(title),
+             "Space Simulator - %.3g days per second (asked for %.3g)",
+             mpSnapshot->rate/86400, mpSnapshot->timeWarp/86400);
+    glutSetWindowTitle(title);
 }
 
 /**
@@ -301,45 +120,28 @@ double Draw::CalculateNewObjectSpeed(int buttonDown, int buttonUp)
 
 /**
     Name: Idle()
-    Function: The function called when GLUT is idle.
+    Function: The function called when GLUT is idle. The space is stepped
+    by the simulation thread, so all that is left is drawing the newest
+    snapshot.
 **/
 void Draw::Idle()
 {
-    for(int i = 0; i < 100; i++)
-    {
-        mpSpace->CalculateGravity();
-        mpSpace->PassTime();
-    }
-    //  set the matrix to default
-    glLoadIdentity();
-    SpaceObject * pFocus = *mLookAtIterator;
-    gluLookAt(
-                //  the position of the eye
-                ToScale(pFocus->GetPosition().GetX()),
-                ToScale(pFocus->GetPosition().GetY()), 1.0,
-                //  the position of the object
-                ToScale(pFocus->GetPosition().GetX()),
-                ToScale(pFocus->GetPosition().GetY()), 0.0,
-                //  the angular rotation around the x, y, and x axises
-                0, 1.0, 0);
     //  call the display function
     Display();
     //  put the application to sleep for 1 ms
-    Sleep(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
 }
 
 /**
     Name: Display()
-    Function: Displays all objects in space.
+    Function: Picks up the newest snapshot, renders the scene of it into
+    the window and shows it.
 **/
 void Draw::Display()
 {
-    //  clear the window
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-    DrawStars();
-    DrawPlanets();
-    DrawMoons();
+    mpSnapshot = &mpSimulation->Acquire();
+    Render(*mpSnapshot);
+    ShowRate();
     //  swap the back and front buffer
     glutSwapBuffers();
 }
@@ -357,6 +159,7 @@ void Draw::Keyboard(unsigned char key, int x, int y)
     {
         /* Exits the application   */
         case 'q':
+            mpSimulation->Stop();
             exit(0);
             break;
         /* Zooms in    */
@@ -405,43 +208,95 @@ void Draw::Keyboard(unsigned char key, int x, int y)
             break;
         /*  Look at next object in space */
         case 'n':
-            //  if the end of the list isnt reached
-            if(mLookAtIterator != mLookAt.end())
-            {
-                mLookAtIterator++;
-            }
-            //  if the end of the list is reached
-            else
+        {
+            int next = FindBody(mLookAt) + 1;
+            //  if the end of the snapshot is reached
+            if(next >= (int)mpSnapshot->bodies.size())
             {
-                //  iterate from first object
-                mLookAtIterator = mLookAt.begin();
+                //  start from the first object
+                next = 0;
             }
+            if(!mpSnapshot->bodies.empty())
+                mLookAt = mpSnapshot->bodies[next].handle;
+            break;
+        }
+        /*  Tilts the space away from the viewer   */
+        case 't':
+            if(mTilt < 90)
+                mTilt += 5;
+            break;
+        /*  Tilts the space towards the viewer  */
+        case 'g':
+            if(mTilt > -90)
+                mTilt -= 5;
+            break;
+        /*  Slows the simulation down   */
+        case ',':
+            mpSimulation->SetTimeWarp(mpSimulation->GetTimeWarp()/2);
+            break;
+        /*  Speeds the simulation up    */
+        case '.':
+            mpSimulation->SetTimeWarp(mpSimulation->GetTimeWarp()*2);
+            break;
+        /*  Switch between the direct sum and the Barnes-Hut tree */
+        case 'b':
+            mpSimulation->Post([](Space& space){
+                if(space.GetGravitySolver() == GRAVITY_DIRECT)
+                {
+                    space.SetGravitySolver(GRAVITY_BARNES_HUT);
+                }
+                else
+                {
+                    space.SetGravitySolver(GRAVITY_DIRECT);
+                }
+            });
+            break;
+        /*  Switch merging touching bodies on and off  */
+        case 'c':
+            mpSimulation->Post([](Space& space){
+                space.SetMergeCollisions(!space.GetMergeCollisions());
+            });
+            break;
+        /*  Switch to the next integrator   */
+        case 'i':
+            mpSimulation->Post([](Space& space){
+                space.SetIntegrator((IntegratorType)
+                    ((space.GetIntegratorType() + 1) %
+                     (INTEGRATOR_WISDOM_HOLMAN + 1)));
+            });
+            break;
+        /*  Saves the space to a checkpoint in the background */
+        case 's':
+            mpSimulation->Post([this](Space& space){
+                mCheckpoint.SaveAsync(space, "space.ckp");
+            });
+            break;
+        /*  Replaces the space with the last saved checkpoint    */
+        case 'l':
+            mpSimulation->Post([this](Space& space){
+                //  the file may still be being written
+                mCheckpoint.Wait();
+                Checkpoint::Load(space, "space.ckp");
+            });
             break;
         /*  Delete last object in space */
         case 127:
-            //  if looking at planet to be deleted
-            if(*mLookAtIterator == mpSpace->GetObjectsInSpace().back())
-            {
-                //  start looking at firstobject
-                mLookAtIterator = mLookAt.begin();
-            }
-            //  point to the last star in space
-            Star* pStar = mpSpace->GetStarsInSpace().back();
-            //  disable the last star in space's light emission
-            glDisable(pStar->GetLightSource());
-            //  deletes the last inserted object in space
-            mpSpace->PopObjectFromSpace();
-            //  if there are any stars in space
-            if(!mpSpace->GetStarsInSpace().empty())
-            {
-                //  point to the last star in space
-                pStar = mpSpace->GetStarsInSpace().back();
-                //  enable the last star in space's light emission
-                glEnable(pStar->GetLightSource());
-            }
-            // save the new list of objects
-            mLookAt = mpSpace->GetObjectsInSpace();
+            //  deletes the last inserted object in space, the light of a
+            //  deleted star goes out with the next snapshot. If it was the
+            //  followed object, the first one is followed from then on
+            mpSimulation->Post([](Space& space){
+                space.PopObjectFromSpace();
+            });
             break;
+        /*  Delete the followed object  */
+        case 'x':
+        {
+            const BodyHandle handle = mLookAt;
+            mpSimulation->Post([handle](Space& space){
+                space.RemoveObjectFromSpace(handle);
+            });
+            break;
+        }
     }
 }
 
@@ -469,30 +324,38 @@ void Draw::Mouse(int button, int state, int x, int y){
             }else if(state == GLUT_UP){
                 //  create a coordinate system using half window width
                 double hWidth = mpWindow->GetWidth()/2;
-                //  create a coordinate system using half window height
+                //  create a coordinate system using half window height,
+                //  which is one window unit on both axes
                 double hHeight = mpWindow->GetHeight()/2;
-                SpaceObject * lookingAt = *mLookAtIterator;
-                mpSpace->AddObjectToSpace(
-                                 new Planet("Vesta", //name
+                //  the position of the followed object when it was drawn
+                Vec3d lookingAt(0, 0, 0);
+                const int lookAt = FindBody(mLookAt);
+                if(lookAt != -1)
+                {
+                    lookingAt = Vec3d(mpSnapshot->bodies[lookAt].x,
+                                      mpSnapshot->bodies[lookAt].y,
+                                      mpSnapshot->bodies[lookAt].z);
+                }
+                //  the position and velocity in the window, turned back by
+                //  the tilt so that the planet appears under the mouse
+                Vec3d position = Untilt(
+                    FromScale((gPosX-hWidth)/hHeight),
+                    FromScale((-gPosY+hHeight)/hHeight));
+                Vec3d velocity = Untilt(
+                    CalculateNewObjectSpeed(gPosX-hWidth, x-hWidth),
+                    CalculateNewObjectSpeed(-gPosY+hHeight, -y+hHeight));
+                Planet* pPlanet = new Planet("Vesta", //name
                                             2.67e20, //mass
                                             0.00625 , //radius
-                                            Coordinate( //position
-                                               FromScale(
-                                                  (gPosX-hWidth)/hWidth) +
-                                                    lookingAt->
-                                                       GetPosition().GetX(),
-                                               FromScale(
-                                                  (-gPosY+hHeight)/hHeight) +
-                                                    lookingAt->
-                                                       GetPosition().GetY()),
-                                            Coordinate( //velocity
-                                                CalculateNewObjectSpeed(
-                                                   gPosX-hWidth, x-hWidth),
-                                                CalculateNewObjectSpeed(
-                                                  -gPosY+hWidth, -y+hWidth)),
+                                            position + lookingAt,
+                                            velocity,
                                             1.0, //colour red
                                             0,  //colour green
-                                            0)); //colour blue
+                                            0); //colour blue
+                //  the planet is added by the simulation thread
+                mpSimulation->Post([pPlanet](Space& space){
+                    space.AddObjectToSpace(pPlanet);
+                });
             }
             break;
         }
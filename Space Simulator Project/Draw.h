@@ -2,9 +2,13 @@
 *   FILE: Draw.h
 *
 *   FUNCTION: This class is responsible for ALL drawing done in the application.
-*   It uses a window as the target for drawing and a space for the content to
-*   draw. The class manages GLUT fucntion calls, variables, user-input,
-*   scaling from window coordinates to real coordinates and vice versa.
+*   It uses a window as the target for drawing and a simulation for the
+*   content to draw. The class manages GLUT fucntion calls, variables,
+*   user-input, scaling from window coordinates to real coordinates and vice
+*   versa.
+*   Every frame is drawn from the newest snapshot of the simulation by the
+*   scene it is built on, and user input that changes the space is posted
+*   to the simulation.
 *
 *   PURPOSE: By collecting all the drawing done in the application in one
 *   class it keeps the cohesion at a manageable level. It might also make it
@@ -16,41 +20,26 @@
 #define _Draw_
 
 #include "Window.h"
-#include "Space.h"
+#include "Simulation.h"
+#include "Checkpoint.h"
+#include "Scene.h"
 #include <GL/glut.h>
-#include <windows.h>
 
 /* Solution for encapsulating GLUT inspired by:
     http://paulsolt.com/2009/07/openglglut-classes-oop-and-problems/ */
 
-class Draw{
+class Draw : public Scene{
     public:
     /** Constructors    **/
     //  constructs a draw object with a target window to draw in,
-    //  a space to draw and a double starting scale
-    Draw(Window*, Space*, double);
+    //  a simulation to draw and a double starting scale
+    Draw(Window*, Simulation*, double);
 
     /** Member Functions   **/
     //  starts the GLUT main loop
     void            Start();
-    //  draws a sphere at a coordinate with a double size
-    void            DrawSphere(Coordinate, double);
-    //  scale a meters double to screen percentage
-    double          ToScale(double);
-    //  scale a screen percentage double to meters
-    double          FromScale(double);
-    // draw all the stars in space
-    void            DrawStars();
-    //  draw all the planets in space
-    void            DrawPlanets();
-    //  draw all the moons in space
-    void            DrawMoons();
-    //  draws lighting on the argument star
-    void            DrawLighting(Star*);
-    //  draws lighting on the argument planet
-    void            DrawLighting(Planet*);
-    //  draws lighting on the argument moon
-    void            DrawLighting(Moon*);
+    //  shows the achieved speed of the simulation in the window title
+    void            ShowRate();
 
     /** Functions called by GLUT  **/
     //  calls my own non-static display handler
@@ -78,18 +67,17 @@ class Draw{
 
     /** Getters and Setters **/
     static void     SetInstance(Draw * instance);
-    void            SetScale(double scaleAu){mScaleAu = scaleAu;}
-    double          GetScale(){return mScaleAu;}
     double          CalculateNewObjectSpeed(int, int);
 
     private:
     /** Class members   **/
     static  Draw*                       mspInstance;
     Window*                             mpWindow;
-    Space*                              mpSpace;
-    double                              mScaleAu;
-    std::list<SpaceObject*>             mLookAt;
-    std::list<SpaceObject*>::iterator   mLookAtIterator;
+    Simulation*                         mpSimulation;
+    //  the achieved rate shown in the window title
+    double                              mShownRate;
+    //  writes the checkpoints saved with the keyboard
+    Checkpoint                          mCheckpoint;
 
 };
 
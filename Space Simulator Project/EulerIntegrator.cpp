@@ -0,0 +1,31 @@
+/****************************************************************************
+*   FILE: EulerIntegrator.cpp
+*
+*   FUNCTION: This class inherits Integrator and moves the bodies the way the
+*   space always has: gravity is calculated once, and every body is moved by
+*   its velocity and acceleration and then given its new velocity.
+*
+*   PURPOSE: To keep the original behaviour available, both as the default
+*   and as something to compare the other integrators with. The method is
+*   cheap but its energy drifts, so it needs short steps.
+*
+****************************************************************************/
+
+#include "EulerIntegrator.h"
+#include "Space.h"
+
+/****************************************************************************
+* Member Functions
+*
+****************************************************************************/
+
+/**
+    Name: Step(Space&, double)
+    Function: Calculates gravity and passes the given amount of seconds,
+    which also sets all forces back to zero.
+**/
+void EulerIntegrator::Step(Space& space, double time)
+{
+    space.CalculateGravity();
+    space.PassTime(time);
+}
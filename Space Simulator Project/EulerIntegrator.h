@@ -0,0 +1,29 @@
+/****************************************************************************
+*   FILE: EulerIntegrator.h
+*
+*   FUNCTION: This class inherits Integrator and moves the bodies the way the
+*   space always has: gravity is calculated once, and every body is moved by
+*   its velocity and acceleration and then given its new velocity.
+*
+*   PURPOSE: To keep the original behaviour available, both as the default
+*   and as something to compare the other integrators with. The method is
+*   cheap but its energy drifts, so it needs short steps.
+*
+****************************************************************************/
+
+#ifndef _EulerIntegrator_
+#define _EulerIntegrator_
+
+#include "Integrator.h"
+
+class EulerIntegrator : public Integrator{
+    public:
+    /** Member Functions   **/
+    //  moves all bodies in the space forward by the given amount of seconds
+    void                Step(Space&, double);
+    /** Getters and Setters **/
+    const char*         GetName()
+                            {return "euler";}
+};
+
+#endif
@@ -0,0 +1,377 @@
+/****************************************************************************
+*   FILE: FrameWriter.cpp
+*
+*   FUNCTION: This class writes rendered frames to files: every frame to a
+*   numbered PNG or PPM image, or all frames one after the other to a
+*   single file of raw pixels.
+*
+*   PURPOSE: A sequence of images can be looked through one by one or be
+*   turned into a movie by any video encoder, and a raw stream can be piped
+*   straight into one, without the renderer depending on any of them.
+*
+*   FORMAT: The images are named by the prefix, an underscore, the frame
+*   number of six digits from zero and the extension, such as
+*   frame_000000.png. All formats keep the pixels as red, green and blue
+*   bytes, the top row first. The raw file is named by the prefix and
+*   ".rgb", or is the standard output if the prefix is "-", and can be read
+*   with "ffmpeg -f rawvideo -pix_fmt rgb24 -s WIDTHxHEIGHT".
+*
+*   NOTES: The PNG images are compressed by the writer itself, so that no
+*   image library is needed. Every row is stored as the difference of each
+*   byte from the same colour of the pixel before it, which turns the empty
+*   space and the insides of the bodies into runs of equal bytes, and the
+*   runs are stored as repeats of the byte before them with the fixed codes
+*   of deflate. That is all a frame of a few round bodies on black needs to
+*   shrink to a small part of its raw size.
+*
+****************************************************************************/
+
+#include "FrameWriter.h"
+
+//  the shortest length of every length symbol of deflate from 257 on, and
+//  the extra bits that follow the symbol
+const int LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19,
+                             23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115,
+                             131, 163, 195, 227, 258};
+const int LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                              2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+//  the longest repeat deflate can store at once
+const int MAX_REPEAT = 258;
+
+/**
+    Name: Crc32(const unsigned char*, int, unsigned int)
+    Function: Continues the CRC-32 of PNG chunks over the given bytes,
+    starting from the given value, which is all ones for a new chunk.
+**/
+static unsigned int Crc32(const unsigned char* pBytes, int count,
+                          unsigned int crc)
+{
+    static unsigned int table[256];
+    static bool made = false;
+    if(!made)
+    {
+        for(unsigned int i = 0; i < 256; i++)
+        {
+            unsigned int value = i;
+            for(int bit = 0; bit < 8; bit++)
+                value = value & 1 ? 0xEDB88320u ^ (value >> 1)
+                                  : value >> 1;
+            table[i] = value;
+        }
+        made = true;
+    }
+    for(int i = 0; i < count; i++)
+        crc = table[(crc ^ pBytes[i]) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+/**
+    Name: PutBigEndian(std::vector<unsigned char>&, unsigned int)
+    Function: Appends the four bytes of the value to the vector, the highest
+    first, as PNG and zlib store their numbers.
+**/
+static void PutBigEndian(std::vector<unsigned char>& bytes,
+                         unsigned int value)
+{
+    bytes.push_back((value >> 24) & 0xFF);
+    bytes.push_back((value >> 16) & 0xFF);
+    bytes.push_back((value >> 8) & 0xFF);
+    bytes.push_back(value & 0xFF);
+}
+
+/****************************************************************************
+ * Constructors
+ *
+ ***************************************************************************/
+
+/**
+    Name: FrameWriter()
+    Function: Constructs a writer of PNG images without a size, which has
+    to be opened before frames are written.
+**/
+FrameWriter::FrameWriter()
+{
+    mFormat         = FRAME_PNG;
+    mWidth          = 0;
+    mHeight         = 0;
+    mpRaw           = 0;
+    mFrames         = 0;
+    mWrittenBytes   = 0;
+    mBitBuffer      = 0;
+    mBitCount       = 0;
+}
+
+/**
+    Name: ~FrameWriter()
+    Function: Closes the raw file if it is still open.
+**/
+FrameWriter::~FrameWriter()
+{
+    Close();
+}
+
+/****************************************************************************
+* Member Functions
+*
+****************************************************************************/
+
+/**
+    Name: Open(const std::string&, FrameFormat, int, int)
+    Function: Keeps the prefix, format and size of the frames to write and
+    counts the frames from zero again. A raw stream is opened right away,
+    images are opened one by one as the frames are written.
+**/
+bool FrameWriter::Open(const std::string& prefix, FrameFormat format,
+                       int width, int height)
+{
+    Close();
+    mPrefix = prefix;
+    mFormat = format;
+    mWidth = width;
+    mHeight = height;
+    mFrames = 0;
+    mWrittenBytes = 0;
+    mFileName.clear();
+    if(format != FRAME_RAW)
+        return true;
+    mFileName = prefix == "-" ? "the standard output" : prefix + ".rgb";
+    mpRaw = prefix == "-" ? stdout : fopen(mFileName.c_str(), "wb");
+    return mpRaw != 0;
+}
+
+/**
+    Name: Write(const unsigned char*)
+    Function: Appends the frame to the raw stream, or writes it to an image
+    file named by its number. Returns false if the file could not be
+    opened or written.
+**/
+bool FrameWriter::Write(const unsigned char* pPixels)
+{
+    const long long frameBytes = 3LL*mWidth*mHeight;
+    if(mFormat == FRAME_RAW)
+    {
+        if(mpRaw == 0 ||
+           fwrite(pPixels, 1, frameBytes, mpRaw) != (size_t)frameBytes)
+            return false;
+        mFrames++;
+        mWrittenBytes += frameBytes;
+        return true;
+    }
+    char name[1024];
+    snprintf(name, sizeof(name), "%s_%06lld.%s", mPrefix.c_str(), mFrames,
+             mFormat == FRAME_PNG ? "png" : "ppm");
+    mFileName = name;
+    FILE* pFile = fopen(name, "wb");
+    if(pFile == 0)
+        return false;
+    bool written;
+    if(mFormat == FRAME_PNG)
+    {
+        EncodePng(pPixels);
+        written = fwrite(&mEncoded[0], 1, mEncoded.size(), pFile) ==
+                  mEncoded.size();
+        mWrittenBytes += mEncoded.size();
+    }
+    else
+    {
+        const int headerBytes = fprintf(pFile, "P6\n%d %d\n255\n", mWidth,
+                                        mHeight);
+        written = headerBytes > 0 &&
+                  fwrite(pPixels, 1, frameBytes, pFile) ==
+                  (size_t)frameBytes;
+        mWrittenBytes += headerBytes + frameBytes;
+    }
+    if(fclose(pFile) != 0)
+        written = false;
+    mFrames++;
+    return written;
+}
+
+/**
+    Name: Close()
+    Function: Flushes and closes the raw file, but leaves the standard
+    output open. Returns false if any of it could not be written.
+**/
+bool FrameWriter::Close()
+{
+    if(mpRaw == 0)
+        return true;
+    bool written = fflush(mpRaw) == 0 && !ferror(mpRaw);
+    if(mpRaw != stdout && fclose(mpRaw) != 0)
+        written = false;
+    mpRaw = 0;
+    return written;
+}
+
+/**
+    Name: EncodePng(const unsigned char*)
+    Function: Encodes the frame as an 8 bit RGB image: the signature, the
+    header, the compressed rows in a single data chunk and the end chunk.
+    Every row gets the Sub filter, which stores each byte minus the byte
+    three places before it.
+**/
+void FrameWriter::EncodePng(const unsigned char* pPixels)
+{
+    /*  START: Filter the rows  */
+    const int rowBytes = 3*mWidth;
+    mFiltered.resize((size_t)mHeight*(rowBytes + 1));
+    unsigned char* pOut = &mFiltered[0];
+    for(int y = 0; y < mHeight; y++)
+    {
+        const unsigned char* pRow = pPixels + (size_t)y*rowBytes;
+        //  the Sub filter
+        *pOut++ = 1;
+        for(int x = 0; x < rowBytes; x++)
+            *pOut++ = pRow[x] - (x >= 3 ? pRow[x - 3] : 0);
+    }
+    /*  END: Filter the rows    */
+    Deflate(mFiltered);
+    /*  START: Put the chunks   */
+    static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r',
+                                               '\n', 0x1A, '\n'};
+    mEncoded.assign(signature, signature + 8);
+    std::vector<unsigned char> header;
+    PutBigEndian(header, mWidth);
+    PutBigEndian(header, mHeight);
+    //  8 bits per colour, red, green and blue, deflate, the five filters
+    //  and no interlacing
+    const unsigned char format[5] = {8, 2, 0, 0, 0};
+    header.insert(header.end(), format, format + 5);
+    PutChunk("IHDR", &header[0], header.size());
+    PutChunk("IDAT", &mCompressed[0], mCompressed.size());
+    PutChunk("IEND", 0, 0);
+    /*  END: Put the chunks */
+}
+
+/**
+    Name: Deflate(const std::vector<unsigned char>&)
+    Function: Compresses the bytes into a zlib stream of a single deflate
+    block with the fixed codes. Every byte is stored as it is unless it
+    starts a run of at least three copies of the byte before it, which is
+    stored as a repeat at a distance of one.
+**/
+void FrameWriter::Deflate(const std::vector<unsigned char>& bytes)
+{
+    mCompressed.clear();
+    mBitBuffer = 0;
+    mBitCount = 0;
+    //  deflate with a window of 32 kilobytes and no dictionary
+    mCompressed.push_back(0x78);
+    mCompressed.push_back(0x01);
+    //  the last block, with the fixed codes
+    PutBits(1, 1);
+    PutBits(1, 2);
+    const size_t count = bytes.size();
+    size_t i = 0;
+    while(i < count)
+    {
+        PutSymbol(bytes[i]);
+        i++;
+        size_t run = 0;
+        while(i + run < count && bytes[i + run] == bytes[i - 1])
+            run++;
+        while(run >= 3)
+        {
+            const int length = run > (size_t)MAX_REPEAT ? MAX_REPEAT : run;
+            PutRepeat(length);
+            i += length;
+            run -= length;
+        }
+    }
+    //  the end of the block, and the bits left over
+    PutSymbol(256);
+    if(mBitCount > 0)
+        mCompressed.push_back(mBitBuffer & 0xFF);
+    /*  START: Put the Adler-32 checksum */
+    unsigned int a = 1;
+    unsigned int b = 0;
+    for(i = 0; i < count; i++)
+    {
+        a = (a + bytes[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    PutBigEndian(mCompressed, (b << 16) | a);
+    /*  END: Put the Adler-32 checksum   */
+}
+
+/**
+    Name: PutBits(unsigned int, int)
+    Function: Appends the lowest bits of the value, the lowest first, and
+    moves every full byte to the compressed stream.
+**/
+void FrameWriter::PutBits(unsigned int value, int count)
+{
+    mBitBuffer |= value << mBitCount;
+    mBitCount += count;
+    while(mBitCount >= 8)
+    {
+        mCompressed.push_back(mBitBuffer & 0xFF);
+        mBitBuffer >>= 8;
+        mBitCount -= 8;
+    }
+}
+
+/**
+    Name: PutCode(unsigned int, int)
+    Function: Appends a Huffman code, which deflate stores from its highest
+    bit down, unlike all other numbers.
+**/
+void FrameWriter::PutCode(unsigned int code, int length)
+{
+    unsigned int reversed = 0;
+    for(int i = 0; i < length; i++)
+        reversed |= ((code >> i) & 1) << (length - 1 - i);
+    PutBits(reversed, length);
+}
+
+/**
+    Name: PutSymbol(int)
+    Function: Appends the fixed code of a literal byte, the end of the
+    block or a length symbol.
+**/
+void FrameWriter::PutSymbol(int symbol)
+{
+    if(symbol < 144)
+        PutCode(0x30 + symbol, 8);
+    else if(symbol < 256)
+        PutCode(0x190 + symbol - 144, 9);
+    else if(symbol < 280)
+        PutCode(symbol - 256, 7);
+    else
+        PutCode(0xC0 + symbol - 280, 8);
+}
+
+/**
+    Name: PutRepeat(int)
+    Function: Appends a repeat of the byte before it, of 3 to 258 bytes: the
+    symbol of the longest base length that fits, the rest of the length in
+    its extra bits and the code of a distance of one.
+**/
+void FrameWriter::PutRepeat(int length)
+{
+    int symbol = 28;
+    while(LENGTH_BASE[symbol] > length)
+        symbol--;
+    PutSymbol(257 + symbol);
+    PutBits(length - LENGTH_BASE[symbol], LENGTH_EXTRA[symbol]);
+    PutCode(0, 5);
+}
+
+/**
+    Name: PutChunk(const char*, const unsigned char*, int)
+    Function: Appends a PNG chunk to the encoded image: the length of the
+    data, the type of four letters, the data and the CRC of the type and
+    data.
+**/
+void FrameWriter::PutChunk(const char* pType, const unsigned char* pData,
+                           int count)
+{
+    PutBigEndian(mEncoded, count);
+    const unsigned char* pTypeBytes = (const unsigned char*)pType;
+    mEncoded.insert(mEncoded.end(), pTypeBytes, pTypeBytes + 4);
+    if(count > 0)
+        mEncoded.insert(mEncoded.end(), pData, pData + count);
+    unsigned int crc = Crc32(pTypeBytes, 4, 0xFFFFFFFFu);
+    crc = Crc32(pData, count, crc);
+    PutBigEndian(mEncoded, crc ^ 0xFFFFFFFFu);
+}
@@ -0,0 +1,102 @@
+/****************************************************************************
+*   FILE: FrameWriter.h
+*
+*   FUNCTION: This class writes rendered frames to files: every frame to a
+*   numbered PNG or PPM image, or all frames one after the other to a
+*   single file of raw pixels.
+*
+*   PURPOSE: A sequence of images can be looked through one by one or be
+*   turned into a movie by any video encoder, and a raw stream can be piped
+*   straight into one, without the renderer depending on any of them.
+*
+*   FORMAT: The images are named by the prefix, an underscore, the frame
+*   number of six digits from zero and the extension, such as
+*   frame_000000.png. All formats keep the pixels as red, green and blue
+*   bytes, the top row first. The raw file is named by the prefix and
+*   ".rgb", or is the standard output if the prefix is "-", and can be read
+*   with "ffmpeg -f rawvideo -pix_fmt rgb24 -s WIDTHxHEIGHT".
+*
+****************************************************************************/
+
+#ifndef _FrameWriter_
+#define _FrameWriter_
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+//  the file formats a frame can be written in
+enum FrameFormat{
+    FRAME_PNG,
+    FRAME_PPM,
+    FRAME_RAW
+};
+
+class FrameWriter{
+    public:
+    /** Constructors    **/
+    //  constructs a writer that writes nothing until it is opened
+    FrameWriter();
+    //  closes the raw file
+    ~FrameWriter();
+    /** Member Functions   **/
+    //  starts writing frames of the given width and height in the given
+    //  format with the file names starting with the string, returns false
+    //  if the raw file could not be opened
+    bool                Open(const std::string&, FrameFormat, int, int);
+    //  writes the frame of rows of red, green and blue bytes, the top row
+    //  first, returns false if it could not be written
+    bool                Write(const unsigned char*);
+    //  closes the raw file, returns false if it could not be written
+    bool                Close();
+    /** Getters and Setters **/
+    long long           GetFrames()
+                            {return mFrames;}
+    long long           GetWrittenBytes()
+                            {return mWrittenBytes;}
+    //  the name of the file opened last, for reporting why it failed
+    const std::string&  GetFileName()
+                            {return mFileName;}
+
+    private:
+    //  the writer may own a file and can therefore not be copied
+    FrameWriter(const FrameWriter&);
+    FrameWriter&        operator=(const FrameWriter&);
+    //  encodes the frame as a PNG image into the encoded bytes
+    void                EncodePng(const unsigned char*);
+    //  compresses the filtered rows into the encoded bytes as a zlib
+    //  stream
+    void                Deflate(const std::vector<unsigned char>&);
+    //  appends the given amount of the lowest bits of the value to the
+    //  compressed stream, the lowest first
+    void                PutBits(unsigned int, int);
+    //  appends a Huffman code of the given length, the highest bit first
+    void                PutCode(unsigned int, int);
+    //  appends the fixed Huffman code of a literal byte or a length symbol
+    void                PutSymbol(int);
+    //  appends a repeat of the last byte of the given length
+    void                PutRepeat(int);
+    //  appends a PNG chunk of the given type with the given data
+    void                PutChunk(const char*, const unsigned char*, int);
+
+    /** Class Members   **/
+    std::string         mPrefix;
+    std::string         mFileName;
+    FrameFormat         mFormat;
+    int                 mWidth;
+    int                 mHeight;
+    //  the raw file, 0 if frames are written to files of their own
+    FILE*               mpRaw;
+    long long           mFrames;
+    long long           mWrittenBytes;
+    //  the rows of the frame being written, filtered for compression
+    std::vector<unsigned char> mFiltered;
+    //  the compressed stream, and the PNG image it ends up in
+    std::vector<unsigned char> mCompressed;
+    std::vector<unsigned char> mEncoded;
+    //  the bits not yet appended to the compressed stream
+    unsigned int        mBitBuffer;
+    int                 mBitCount;
+};
+
+#endif
@@ -0,0 +1,360 @@
+/****************************************************************************
+*   FILE: Generator.cpp
+*
+*   FUNCTION: This class fills a space with large generated systems: Plummer
+*   spheres of stars, exponential disks around a central star, belts of
+*   asteroids around a body already in the space and fields of binary
+*   stars. The bodies are made in pieces of a fixed size on all threads
+*   and every body draws its random numbers from a generator seeded by the
+*   seed and its own index.
+*
+*   PURPOSE: The solvers need large and realistic spaces to be measured and
+*   stressed with, and bodies could only be added by hand before. Since no
+*   body depends on which thread made it or on how many threads there are,
+*   the same seed gives exactly the same millions of bodies on every
+*   machine, so a run can be repeated anywhere.
+*
+****************************************************************************/
+
+
+#include "Generator.h"
+#include "ThreadPool.h"
+#include <functional>
+#include <math.h>
+#include <thread>
+
+//  the bodies are made in pieces of this many, whatever the thread count
+const int PIECE_SIZE = 1 << 14;
+//  the mass of the sun in kilograms
+const double SOLAR_MASS = 1.9891e30;
+//  one astronomical unit in meters
+const double AU = 149598e6;
+const double PI = 3.14159265358979;
+
+//  makes the bodies of the item with the given index, such as a star or a
+//  pair of stars, from the random state and adds them to the store
+typedef std::function<void(int, unsigned long long&, BodyStore&)>
+    MakeBodies;
+
+/**
+    Name: NextRandom(unsigned long long&)
+    Function: Moves the random state on and returns 64 random bits, using
+    the SplitMix64 generator.
+**/
+static unsigned long long NextRandom(unsigned long long& state)
+{
+    state += 0x9e3779b97f4a7c15ULL;
+    unsigned long long bits = state;
+    bits = (bits ^ (bits >> 30))*0xbf58476d1ce4e5b9ULL;
+    bits = (bits ^ (bits >> 27))*0x94d049bb133111ebULL;
+    return bits ^ (bits >> 31);
+}
+
+/**
+    Name: Uniform(unsigned long long&)
+    Function: Returns a random double above 0 and up to 1, so that it can
+    always be divided by or have its logarithm taken.
+**/
+static double Uniform(unsigned long long& state)
+{
+    return ((NextRandom(state) >> 11) + 1)*(1.0/9007199254740992.0);
+}
+
+/**
+    Name: Generate(Space&, int, int, unsigned int, const MakeBodies&)
+    Function: Makes the given amount of items, each of the given amount of
+    bodies, and adds them to the space. The items are split into pieces of
+    a fixed size, which the threads of a pool take turns at, each into a
+    body store of its own. Every item gets a random state made from the
+    seed and its index alone. The pieces are then moved into the space in
+    order, so the bodies come out the same for any amount of threads.
+**/
+static void Generate(Space& space, int count, int bodiesPerItem,
+                     unsigned int seed, const MakeBodies& make)
+{
+    const int pieceCount = (count + PIECE_SIZE - 1)/PIECE_SIZE;
+    if(pieceCount == 0)
+        return;
+    int threads = std::thread::hardware_concurrency();
+    if(threads < 1)
+        threads = 1;
+    if(threads > pieceCount)
+        threads = pieceCount;
+    std::vector<BodyStore*> pieces(pieceCount);
+    /*  START: Make the pieces  */
+    ThreadPool pool(threads);
+    pool.Run([&](int thread){
+        for(int piece = thread; piece < pieceCount; piece += threads)
+        {
+            const int first = piece*PIECE_SIZE;
+            const int last = first + PIECE_SIZE < count ?
+                             first + PIECE_SIZE : count;
+            BodyStore* pBodies = new BodyStore();
+            pBodies->Reserve((last - first)*bodiesPerItem);
+            for(int i = first; i < last; i++)
+            {
+                //  mix the index into the seed so that neighbouring
+                //  items get unrelated numbers
+                unsigned long long state =
+                    ((unsigned long long)seed << 32) ^ (unsigned int)i;
+                state = NextRandom(state);
+                make(i, state, *pBodies);
+            }
+            pieces[piece] = pBodies;
+        }
+    });
+    /*  END: Make the pieces    */
+    space.ReserveObjects(space.GetBodies().GetCount() +
+                         count*bodiesPerItem);
+    for(int i = 0; i < pieceCount; i++)
+    {
+        space.AddBodies(*pieces[i]);
+        delete pieces[i];
+    }
+}
+
+/****************************************************************************
+* Member Functions
+*
+****************************************************************************/
+
+/**
+    Name: CreatePlummerSphere(Space&, int, double, double, unsigned int)
+    Function: Adds a Plummer sphere of stars of equal mass around the
+    origin. Radii and speeds are drawn as by Aarseth, Henon and Wielen, so
+    that the sphere is in equilibrium in three dimensions. Stars further
+    out than 20 scale radii are drawn again. The sphere is finally moved
+    so that its center of mass is at rest at the origin.
+**/
+void Generator::CreatePlummerSphere(Space& space, int count,
+                                    double totalMass, double scaleRadius,
+                                    unsigned int seed)
+{
+    const double g = 6.67428e-11;
+    const double a = scaleRadius;
+    //  the speed that escapes from the center
+    const double escapeSpeed = sqrt(2*g*totalMass/a);
+    BodyInfo info;
+    info.name           = "Star";
+    info.radius         = 0.01;
+    info.red            = 1.0;
+    info.green          = 1.0;
+    info.blue           = 0.8;
+    info.type           = BODY_STAR;
+    info.lightSource    = 0;
+    info.pObject        = 0;
+    const double mass = totalMass/count;
+    const int first = space.GetBodies().GetCount();
+    Generate(space, count, 1, seed,
+             [&](int, unsigned long long& state, BodyStore& bodies){
+        /*  START: Pick the radius  */
+        double r;
+        do
+        {
+            r = a/sqrt(pow(Uniform(state), -2.0/3.0) - 1);
+        }while(r > 20*a);
+        double z = 2*Uniform(state) - 1;
+        double angle = 2*PI*Uniform(state);
+        double plane = r*sqrt(1 - z*z);
+        Vec3d position(plane*cos(angle), plane*sin(angle), r*z);
+        /*  END: Pick the radius    */
+        /*  START: Pick the speed   */
+        //  the speed as a part of the escape speed, with the chance of
+        //  q*q*(1 - q*q)^3.5
+        double q;
+        double chance;
+        do
+        {
+            q = Uniform(state);
+            chance = 0.1*Uniform(state);
+        }while(chance > q*q*pow(1 - q*q, 3.5));
+        double speed = q*escapeSpeed*pow(1 + r*r/(a*a), -0.25);
+        z = 2*Uniform(state) - 1;
+        angle = 2*PI*Uniform(state);
+        plane = speed*sqrt(1 - z*z);
+        Vec3d velocity(plane*cos(angle), plane*sin(angle), speed*z);
+        /*  END: Pick the speed */
+        bodies.Add(info, position, velocity, mass);
+    });
+    /*  START: Move to the center of mass   */
+    BodyStore& bodies = space.GetBodies();
+    double x = 0;
+    double y = 0;
+    double z = 0;
+    double vx = 0;
+    double vy = 0;
+    double vz = 0;
+    for(int i = first; i < bodies.GetCount(); i++)
+    {
+        x   += bodies.GetX()[i];
+        y   += bodies.GetY()[i];
+        z   += bodies.GetZ()[i];
+        vx  += bodies.GetVx()[i];
+        vy  += bodies.GetVy()[i];
+        vz  += bodies.GetVz()[i];
+    }
+    for(int i = first; i < bodies.GetCount(); i++)
+    {
+        bodies.GetX()[i]    -= x/count;
+        bodies.GetY()[i]    -= y/count;
+        bodies.GetZ()[i]    -= z/count;
+        bodies.GetVx()[i]   -= vx/count;
+        bodies.GetVy()[i]   -= vy/count;
+        bodies.GetVz()[i]   -= vz/count;
+    }
+    /*  END: Move to the center of mass */
+}
+
+/**
+    Name: CreateExponentialDisk(Space&, int, double, double, double,
+                                unsigned int)
+    Function: Adds a star at the origin and a disk of bodies around it,
+    whose density falls off with the distance as e^(-r/h) for the scale
+    length h. Bodies closer than a tenth of the scale length are drawn
+    again. Every body moves on a circle at the speed set by the star and
+    the mass of the disk inside its orbit, as if that mass were at the
+    center.
+**/
+void Generator::CreateExponentialDisk(Space& space, int count,
+                                      double starMass, double diskMass,
+                                      double scaleLength, unsigned int seed)
+{
+    const double g = 6.67428e-11;
+    const double h = scaleLength;
+    space.AddObjectToSpace(new Star("Star", starMass, 0.025,
+                                    Vec3d(0, 0), Vec3d(0, 0),
+                                    1.0, 1.0, 0.0));
+    BodyInfo info;
+    info.name           = "Body";
+    info.radius         = 0.003;
+    info.red            = 0.6;
+    info.green          = 0.6;
+    info.blue           = 0.6;
+    info.type           = BODY_PLANET;
+    info.lightSource    = 0;
+    info.pObject        = 0;
+    const double mass = diskMass/count;
+    Generate(space, count, 1, seed,
+             [&](int, unsigned long long& state, BodyStore& bodies){
+        //  the radius of a disk with this density has a gamma
+        //  distribution, which is the sum of two exponential ones
+        double r;
+        do
+        {
+            r = -h*log(Uniform(state)*Uniform(state));
+        }while(r < 0.1*h);
+        double angle = 2*PI*Uniform(state);
+        //  the mass of the disk inside the radius
+        double inside = diskMass*(1 - (1 + r/h)*exp(-r/h));
+        double speed = sqrt(g*(starMass + inside)/r);
+        bodies.Add(info, Vec3d(r*cos(angle), r*sin(angle)),
+                   Vec3d(-speed*sin(angle), speed*cos(angle)), mass);
+    });
+}
+
+/**
+    Name: CreateAsteroidBelt(Space&, const std::string&, int, double,
+                             double, double, unsigned int)
+    Function: Adds asteroids spread evenly over the ring between the inner
+    and outer distance around the earliest added body with the given name,
+    such as a planet or the sun, in the plane through the body parallel to
+    the x and y axes. Every asteroid moves on a circle around the body,
+    along with it. Returns false if there is no body with the name.
+**/
+bool Generator::CreateAsteroidBelt(Space& space, const std::string& owner,
+                                   int count, double inner, double outer,
+                                   double totalMass, unsigned int seed)
+{
+    const double g = 6.67428e-11;
+    BodyStore& store = space.GetBodies();
+    const int index = store.Find(owner);
+    if(index == -1)
+        return false;
+    const double x = store.GetX()[index];
+    const double y = store.GetY()[index];
+    const double z = store.GetZ()[index];
+    const double vx = store.GetVx()[index];
+    const double vy = store.GetVy()[index];
+    const double vz = store.GetVz()[index];
+    const double ownerMass = store.GetMass()[index];
+    BodyInfo info;
+    info.name           = "Asteroid";
+    info.radius         = 0.002;
+    info.red            = 0.6;
+    info.green          = 0.5;
+    info.blue           = 0.4;
+    info.type           = BODY_MOON;
+    info.lightSource    = 0;
+    info.pObject        = 0;
+    const double mass = totalMass/count;
+    Generate(space, count, 1, seed,
+             [&](int, unsigned long long& state, BodyStore& bodies){
+        //  the square root spreads the asteroids evenly over the area
+        double r = sqrt(inner*inner +
+                        Uniform(state)*(outer*outer - inner*inner));
+        double angle = 2*PI*Uniform(state);
+        double speed = sqrt(g*ownerMass/r);
+        bodies.Add(info,
+                   Vec3d(x + r*cos(angle), y + r*sin(angle), z),
+                   Vec3d(vx - speed*sin(angle), vy + speed*cos(angle), vz),
+                   mass);
+    });
+    return true;
+}
+
+/**
+    Name: CreateBinaryStars(Space&, int, double, unsigned int)
+    Function: Adds pairs of stars spread evenly over a disk of the given
+    radius around the origin. The heavier star of a pair has between half
+    and two solar masses and the lighter one between a fifth of it and as
+    much. They circle their common center of mass in either direction, at
+    a distance between 0.1 and 10 astronomical units, spread evenly on a
+    logarithmic scale.
+**/
+void Generator::CreateBinaryStars(Space& space, int count, double radius,
+                                  unsigned int seed)
+{
+    const double g = 6.67428e-11;
+    BodyInfo primary;
+    primary.name        = "Star";
+    primary.radius      = 0.01;
+    primary.red         = 1.0;
+    primary.green       = 1.0;
+    primary.blue        = 0.8;
+    primary.type        = BODY_STAR;
+    primary.lightSource = 0;
+    primary.pObject     = 0;
+    BodyInfo secondary  = primary;
+    secondary.radius    = 0.007;
+    secondary.green     = 0.6;
+    secondary.blue      = 0.4;
+    Generate(space, count, 2, seed,
+             [&](int, unsigned long long& state, BodyStore& bodies){
+        /*  START: Pick the pair    */
+        double r = radius*sqrt(Uniform(state));
+        double angle = 2*PI*Uniform(state);
+        Vec3d center(r*cos(angle), r*sin(angle));
+        double mass1 = SOLAR_MASS*(0.5 + 1.5*Uniform(state));
+        double mass2 = mass1*(0.2 + 0.8*Uniform(state));
+        double distance = AU*pow(10.0, 2*Uniform(state) - 1);
+        double phase = 2*PI*Uniform(state);
+        double sense = Uniform(state) < 0.5 ? 1 : -1;
+        /*  END: Pick the pair  */
+        /*  START: Put both stars on their orbits   */
+        double total = mass1 + mass2;
+        double speed = sense*sqrt(g*total/distance);
+        double c = cos(phase);
+        double s = sin(phase);
+        double r1 = distance*mass2/total;
+        double r2 = distance*mass1/total;
+        double v1 = speed*mass2/total;
+        double v2 = speed*mass1/total;
+        bodies.Add(primary,
+                   Vec3d(center.GetX() + r1*c, center.GetY() + r1*s),
+                   Vec3d(-v1*s, v1*c), mass1);
+        bodies.Add(secondary,
+                   Vec3d(center.GetX() - r2*c, center.GetY() - r2*s),
+                   Vec3d(v2*s, -v2*c), mass2);
+        /*  END: Put both stars on their orbits */
+    });
+}
@@ -0,0 +1,50 @@
+/****************************************************************************
+*   FILE: Generator.h
+*
+*   FUNCTION: This class fills a space with large generated systems: Plummer
+*   spheres of stars, exponential disks around a central star, belts of
+*   asteroids around a body already in the space and fields of binary
+*   stars. The bodies are made in pieces of a fixed size on all threads
+*   and every body draws its random numbers from a generator seeded by the
+*   seed and its own index.
+*
+*   PURPOSE: The solvers need large and realistic spaces to be measured and
+*   stressed with, and bodies could only be added by hand before. Since no
+*   body depends on which thread made it or on how many threads there are,
+*   the same seed gives exactly the same millions of bodies on every
+*   machine, so a run can be repeated anywhere.
+*
+****************************************************************************/
+
+#ifndef _Generator_
+#define _Generator_
+
+#include "Space.h"
+#include <string>
+
+class Generator{
+    public:
+    /** Member Functions   **/
+    //  adds a Plummer sphere of the given amount of stars with the given
+    //  total mass and scale radius doubles, picked from the seed
+    static void         CreatePlummerSphere(Space&, int, double, double,
+                                            unsigned int);
+    //  adds a star of the first given mass and a disk of the given amount
+    //  of bodies with the second given mass and the given scale length
+    //  double around it, picked from the seed
+    static void         CreateExponentialDisk(Space&, int, double, double,
+                                              double, unsigned int);
+    //  adds a belt of the given amount of asteroids with the given total
+    //  mass between the given inner and outer distance doubles around the
+    //  body named by the string, picked from the seed, returns false if
+    //  there is no such body
+    static bool         CreateAsteroidBelt(Space&, const std::string&, int,
+                                           double, double, double,
+                                           unsigned int);
+    //  adds the given amount of binary stars spread over a disk of the
+    //  given radius double, picked from the seed
+    static void         CreateBinaryStars(Space&, int, double,
+                                          unsigned int);
+};
+
+#endif
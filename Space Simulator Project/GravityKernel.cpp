@@ -0,0 +1,373 @@
+/****************************************************************************
+*   FILE: GravityKernel.cpp
+*
+*   FUNCTION: This file holds the vectorized kernels summing up the pull of
+*   every body on a range of bodies, one for each supported instruction set,
+*   and picks the best kernel the running processor supports.
+*
+*   PURPOSE: The scalar pair loop spends its time on one square root and one
+*   division per pair. The kernels instead handle two, four or eight pairs
+*   per instruction and replace the square root and division with a
+*   reciprocal square root estimate refined by Newton's method. Picking the
+*   kernel when running lets a single binary use the widest instructions of
+*   whatever machine it runs on.
+*
+*   NOTES:
+*   The kernels read the arrays in whole vectors up to the next multiple of
+*   eight bodies. The body store keeps its capacity at a multiple of eight
+*   and the unused elements at zero, and a body with zero mass or at zero
+*   distance does not pull, so the extra elements never change the result.
+*   The SSE2 and AVX2 estimates are made in single precision, which limits
+*   those kernels to distances between about 1e-18 and 1e19 meters.
+*   The square of the Plummer softening length is added to the square of
+*   every distance. The pull of a body on itself then no longer has a zero
+*   distance, but its direction is still zero, so it still adds nothing.
+*
+****************************************************************************/
+
+#include "GravityKernel.h"
+#include <math.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GRAVITY_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+//  the universal gravitational constant
+const double G = 6.67428e-11;
+//  the amount of bodies pulling on a row at a time, small enough for their
+//  positions and masses to stay in the first level cache
+const int BLOCK_SIZE = 1024;
+
+/**
+    Name: RoundUp(int)
+    Function: Rounds the amount of bodies up to a whole vector of eight.
+**/
+static inline int RoundUp(int count)
+{
+    return (count + 7) & ~7;
+}
+
+/****************************************************************************
+* Kernels
+*
+****************************************************************************/
+
+/**
+    Name: ScalarKernel(const double*, const double*, const double*,
+                       const double*, int, int, int, double, double*,
+                       double*, double*)
+    Function: Adds the pull of every body on every body in the range, one
+    pair at a time.
+**/
+static void ScalarKernel(const double* pX, const double* pY,
+                         const double* pZ, const double* pMass, int count,
+                         int first, int last, double softening2,
+                         double* pFx, double* pFy, double* pFz)
+{
+    for(int i = first; i < last; i++)
+    {
+        double fx = 0;
+        double fy = 0;
+        double fz = 0;
+        for(int j = 0; j < count; j++)
+        {
+            double dx = pX[j] - pX[i];
+            double dy = pY[j] - pY[i];
+            double dz = pZ[j] - pZ[i];
+            double length2 = dx*dx + dy*dy + dz*dz + softening2;
+            if(length2 == 0)
+                continue;
+            double force = pMass[j]/(length2*sqrt(length2));
+            fx += dx*force;
+            fy += dy*force;
+            fz += dz*force;
+        }
+        pFx[i] += G*pMass[i]*fx;
+        pFy[i] += G*pMass[i]*fy;
+        pFz[i] += G*pMass[i]*fz;
+    }
+}
+
+#ifdef GRAVITY_KERNEL_X86
+
+/**
+    Name: Sse2Kernel(const double*, const double*, const double*,
+                     const double*, int, int, int, double, double*,
+                     double*, double*)
+    Function: Adds the pull of every body on every body in the range, two
+    pairs at a time.
+**/
+__attribute__((target("sse2")))
+static void Sse2Kernel(const double* pX, const double* pY,
+                       const double* pZ, const double* pMass, int count,
+                       int first, int last, double softening2,
+                       double* pFx, double* pFy, double* pFz)
+{
+    const int padded = RoundUp(count);
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d half = _mm_set1_pd(0.5);
+    const __m128d threeHalves = _mm_set1_pd(1.5);
+    const __m128d softening = _mm_set1_pd(softening2);
+    for(int block = 0; block < padded; block += BLOCK_SIZE)
+    {
+        const int blockEnd = block + BLOCK_SIZE < padded ?
+                             block + BLOCK_SIZE : padded;
+        for(int i = first; i < last; i++)
+        {
+            const __m128d xi = _mm_set1_pd(pX[i]);
+            const __m128d yi = _mm_set1_pd(pY[i]);
+            const __m128d zi = _mm_set1_pd(pZ[i]);
+            __m128d fx = zero;
+            __m128d fy = zero;
+            __m128d fz = zero;
+            for(int j = block; j < blockEnd; j += 2)
+            {
+                __m128d dx = _mm_sub_pd(_mm_load_pd(pX + j), xi);
+                __m128d dy = _mm_sub_pd(_mm_load_pd(pY + j), yi);
+                __m128d dz = _mm_sub_pd(_mm_load_pd(pZ + j), zi);
+                __m128d length2 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx),
+                                                        _mm_mul_pd(dy, dy)),
+                                             _mm_add_pd(_mm_mul_pd(dz, dz),
+                                                        softening));
+                //  estimate 1/sqrt(r*r) in single precision
+                __m128d y = _mm_cvtps_pd(_mm_rsqrt_ps(
+                                _mm_cvtpd_ps(length2)));
+                //  two Newton steps: y = y*(1.5 - 0.5*r*r*y*y)
+                __m128d halfLength2 = _mm_mul_pd(half, length2);
+                y = _mm_mul_pd(y, _mm_sub_pd(threeHalves,
+                        _mm_mul_pd(halfLength2, _mm_mul_pd(y, y))));
+                y = _mm_mul_pd(y, _mm_sub_pd(threeHalves,
+                        _mm_mul_pd(halfLength2, _mm_mul_pd(y, y))));
+                //  a pair at zero distance does not pull
+                __m128d inverse3 = _mm_and_pd(
+                        _mm_mul_pd(y, _mm_mul_pd(y, y)),
+                        _mm_cmpgt_pd(length2, zero));
+                __m128d force = _mm_mul_pd(_mm_load_pd(pMass + j),
+                                           inverse3);
+                fx = _mm_add_pd(fx, _mm_mul_pd(dx, force));
+                fy = _mm_add_pd(fy, _mm_mul_pd(dy, force));
+                fz = _mm_add_pd(fz, _mm_mul_pd(dz, force));
+            }
+            double sumX[2], sumY[2], sumZ[2];
+            _mm_storeu_pd(sumX, fx);
+            _mm_storeu_pd(sumY, fy);
+            _mm_storeu_pd(sumZ, fz);
+            pFx[i] += G*pMass[i]*(sumX[0] + sumX[1]);
+            pFy[i] += G*pMass[i]*(sumY[0] + sumY[1]);
+            pFz[i] += G*pMass[i]*(sumZ[0] + sumZ[1]);
+        }
+    }
+}
+
+/**
+    Name: Avx2Kernel(const double*, const double*, const double*,
+                     const double*, int, int, int, double, double*,
+                     double*, double*)
+    Function: Adds the pull of every body on every body in the range, four
+    pairs at a time.
+**/
+__attribute__((target("avx2,fma")))
+static void Avx2Kernel(const double* pX, const double* pY,
+                       const double* pZ, const double* pMass, int count,
+                       int first, int last, double softening2,
+                       double* pFx, double* pFy, double* pFz)
+{
+    const int padded = RoundUp(count);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d threeHalves = _mm256_set1_pd(1.5);
+    const __m256d softening = _mm256_set1_pd(softening2);
+    for(int block = 0; block < padded; block += BLOCK_SIZE)
+    {
+        const int blockEnd = block + BLOCK_SIZE < padded ?
+                             block + BLOCK_SIZE : padded;
+        for(int i = first; i < last; i++)
+        {
+            const __m256d xi = _mm256_set1_pd(pX[i]);
+            const __m256d yi = _mm256_set1_pd(pY[i]);
+            const __m256d zi = _mm256_set1_pd(pZ[i]);
+            __m256d fx = zero;
+            __m256d fy = zero;
+            __m256d fz = zero;
+            for(int j = block; j < blockEnd; j += 4)
+            {
+                __m256d dx = _mm256_sub_pd(_mm256_load_pd(pX + j), xi);
+                __m256d dy = _mm256_sub_pd(_mm256_load_pd(pY + j), yi);
+                __m256d dz = _mm256_sub_pd(_mm256_load_pd(pZ + j), zi);
+                __m256d length2 = _mm256_fmadd_pd(dx, dx,
+                                      _mm256_fmadd_pd(dy, dy,
+                                          _mm256_fmadd_pd(dz, dz,
+                                                          softening)));
+                //  estimate 1/sqrt(r*r) in single precision
+                __m256d y = _mm256_cvtps_pd(_mm_rsqrt_ps(
+                                _mm256_cvtpd_ps(length2)));
+                //  two Newton steps: y = y*(1.5 - 0.5*r*r*y*y)
+                __m256d halfLength2 = _mm256_mul_pd(half, length2);
+                y = _mm256_mul_pd(y, _mm256_fnmadd_pd(halfLength2,
+                        _mm256_mul_pd(y, y), threeHalves));
+                y = _mm256_mul_pd(y, _mm256_fnmadd_pd(halfLength2,
+                        _mm256_mul_pd(y, y), threeHalves));
+                //  a pair at zero distance does not pull
+                __m256d inverse3 = _mm256_and_pd(
+                        _mm256_mul_pd(y, _mm256_mul_pd(y, y)),
+                        _mm256_cmp_pd(length2, zero, _CMP_GT_OQ));
+                __m256d force = _mm256_mul_pd(_mm256_load_pd(pMass + j),
+                                              inverse3);
+                fx = _mm256_fmadd_pd(dx, force, fx);
+                fy = _mm256_fmadd_pd(dy, force, fy);
+                fz = _mm256_fmadd_pd(dz, force, fz);
+            }
+            double sumX[4], sumY[4], sumZ[4];
+            _mm256_storeu_pd(sumX, fx);
+            _mm256_storeu_pd(sumY, fy);
+            _mm256_storeu_pd(sumZ, fz);
+            pFx[i] += G*pMass[i]*((sumX[0] + sumX[1]) + (sumX[2] + sumX[3]));
+            pFy[i] += G*pMass[i]*((sumY[0] + sumY[1]) + (sumY[2] + sumY[3]));
+            pFz[i] += G*pMass[i]*((sumZ[0] + sumZ[1]) + (sumZ[2] + sumZ[3]));
+        }
+    }
+}
+
+/**
+    Name: Avx512Kernel(const double*, const double*, const double*,
+                       const double*, int, int, int, double, double*,
+                       double*, double*)
+    Function: Adds the pull of every body on every body in the range, eight
+    pairs at a time. AVX-512 has a double precision estimate that is exact to
+    14 bits, so two Newton steps reach full double precision.
+**/
+__attribute__((target("avx512f")))
+static void Avx512Kernel(const double* pX, const double* pY,
+                         const double* pZ, const double* pMass, int count,
+                         int first, int last, double softening2,
+                         double* pFx, double* pFy, double* pFz)
+{
+    const int padded = RoundUp(count);
+    const __m512d zero = _mm512_setzero_pd();
+    const __m512d half = _mm512_set1_pd(0.5);
+    const __m512d threeHalves = _mm512_set1_pd(1.5);
+    const __m512d softening = _mm512_set1_pd(softening2);
+    for(int block = 0; block < padded; block += BLOCK_SIZE)
+    {
+        const int blockEnd = block + BLOCK_SIZE < padded ?
+                             block + BLOCK_SIZE : padded;
+        for(int i = first; i < last; i++)
+        {
+            const __m512d xi = _mm512_set1_pd(pX[i]);
+            const __m512d yi = _mm512_set1_pd(pY[i]);
+            const __m512d zi = _mm512_set1_pd(pZ[i]);
+            __m512d fx = zero;
+            __m512d fy = zero;
+            __m512d fz = zero;
+            for(int j = block; j < blockEnd; j += 8)
+            {
+                __m512d dx = _mm512_sub_pd(_mm512_load_pd(pX + j), xi);
+                __m512d dy = _mm512_sub_pd(_mm512_load_pd(pY + j), yi);
+                __m512d dz = _mm512_sub_pd(_mm512_load_pd(pZ + j), zi);
+                __m512d length2 = _mm512_fmadd_pd(dx, dx,
+                                      _mm512_fmadd_pd(dy, dy,
+                                          _mm512_fmadd_pd(dz, dz,
+                                                          softening)));
+                //  a pair at zero distance does not pull
+                __mmask8 pulls = _mm512_cmp_pd_mask(length2, zero,
+                                                    _CMP_GT_OQ);
+                __m512d y = _mm512_maskz_rsqrt14_pd(pulls, length2);
+                //  two Newton steps: y = y*(1.5 - 0.5*r*r*y*y)
+                __m512d halfLength2 = _mm512_mul_pd(half, length2);
+                y = _mm512_mul_pd(y, _mm512_fnmadd_pd(halfLength2,
+                        _mm512_mul_pd(y, y), threeHalves));
+                y = _mm512_mul_pd(y, _mm512_fnmadd_pd(halfLength2,
+                        _mm512_mul_pd(y, y), threeHalves));
+                __m512d force = _mm512_mul_pd(_mm512_load_pd(pMass + j),
+                                    _mm512_mul_pd(y, _mm512_mul_pd(y, y)));
+                fx = _mm512_fmadd_pd(dx, force, fx);
+                fy = _mm512_fmadd_pd(dy, force, fy);
+                fz = _mm512_fmadd_pd(dz, force, fz);
+            }
+            double sumX[8], sumY[8], sumZ[8];
+            _mm512_storeu_pd(sumX, fx);
+            _mm512_storeu_pd(sumY, fy);
+            _mm512_storeu_pd(sumZ, fz);
+            double x = ((sumX[0] + sumX[1]) + (sumX[2] + sumX[3])) +
+                       ((sumX[4] + sumX[5]) + (sumX[6] + sumX[7]));
+            double y = ((sumY[0] + sumY[1]) + (sumY[2] + sumY[3])) +
+                       ((sumY[4] + sumY[5]) + (sumY[6] + sumY[7]));
+            double z = ((sumZ[0] + sumZ[1]) + (sumZ[2] + sumZ[3])) +
+                       ((sumZ[4] + sumZ[5]) + (sumZ[6] + sumZ[7]));
+            pFx[i] += G*pMass[i]*x;
+            pFy[i] += G*pMass[i]*y;
+            pFz[i] += G*pMass[i]*z;
+        }
+    }
+}
+
+#endif
+
+/****************************************************************************
+* Member Functions
+*
+****************************************************************************/
+
+/**
+    Name: Detect()
+    Function: Returns the widest instruction set that both the processor and
+    the operating system support.
+**/
+KernelLevel GravityKernel::Detect()
+{
+#ifdef GRAVITY_KERNEL_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f"))
+        return KERNEL_AVX512;
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return KERNEL_AVX2;
+    if(__builtin_cpu_supports("sse2"))
+        return KERNEL_SSE2;
+#endif
+    return KERNEL_SCALAR;
+}
+
+/**
+    Name: Get(KernelLevel)
+    Function: Returns the kernel for the given instruction set. Asking for a
+    wider set than the processor supports gives the widest supported one.
+**/
+GravityKernelFunction GravityKernel::Get(KernelLevel level)
+{
+    KernelLevel supported = Detect();
+    if(level > supported)
+        level = supported;
+    switch(level)
+    {
+#ifdef GRAVITY_KERNEL_X86
+        case KERNEL_AVX512:
+            return Avx512Kernel;
+        case KERNEL_AVX2:
+            return Avx2Kernel;
+        case KERNEL_SSE2:
+            return Sse2Kernel;
+#endif
+        default:
+            return ScalarKernel;
+    }
+}
+
+/**
+    Name: GetName(KernelLevel)
+    Function: Returns the name of the given instruction set.
+**/
+const char* GravityKernel::GetName(KernelLevel level)
+{
+    switch(level)
+    {
+        case KERNEL_AVX512:
+            return "AVX-512";
+        case KERNEL_AVX2:
+            return "AVX2";
+        case KERNEL_SSE2:
+            return "SSE2";
+        default:
+            return "scalar";
+    }
+}
@@ -0,0 +1,49 @@
+/****************************************************************************
+*   FILE: GravityKernel.h
+*
+*   FUNCTION: This file holds the vectorized kernels summing up the pull of
+*   every body on a range of bodies, one for each supported instruction set,
+*   and picks the best kernel the running processor supports.
+*
+*   PURPOSE: The scalar pair loop spends its time on one square root and one
+*   division per pair. The kernels instead handle two, four or eight pairs
+*   per instruction and replace the square root and division with a
+*   reciprocal square root estimate refined by Newton's method. Picking the
+*   kernel when running lets a single binary use the widest instructions of
+*   whatever machine it runs on.
+*
+****************************************************************************/
+
+#ifndef _GravityKernel_
+#define _GravityKernel_
+
+//  the instruction sets a kernel can be written for, from narrowest to widest
+enum KernelLevel{
+    KERNEL_SCALAR,
+    KERNEL_SSE2,
+    KERNEL_AVX2,
+    KERNEL_AVX512
+};
+
+//  a kernel takes the x, y, z and mass arrays and the amount of bodies, and
+//  adds the force from all bodies on every body from the first up to but not
+//  including the last index to the x, y and z force arrays, with the square
+//  of the softening length added to the square of every distance
+typedef void (*GravityKernelFunction)(const double*, const double*,
+                                      const double*, const double*,
+                                      int, int, int, double,
+                                      double*, double*, double*);
+
+class GravityKernel{
+    public:
+    /** Member Functions   **/
+    //  returns the widest instruction set supported by the processor
+    static KernelLevel              Detect();
+    //  returns the kernel for the given instruction set, or the widest one
+    //  below it that is compiled in and supported
+    static GravityKernelFunction    Get(KernelLevel);
+    //  returns the name of the given instruction set
+    static const char*              GetName(KernelLevel);
+};
+
+#endif
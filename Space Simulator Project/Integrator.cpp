@@ -0,0 +1,70 @@
+/****************************************************************************
+*   FILE: Integrator.cpp
+*
+*   FUNCTION: This class is the base for all integrators. An integrator moves
+*   every body in a space forward in time by one step, calculating gravity
+*   as many times as its method needs.
+*
+*   PURPOSE: Different methods of moving the bodies trade speed for accuracy
+*   in different ways. Keeping them behind a common base lets a space switch
+*   between them at runtime, and lets new methods be added without changing
+*   the space.
+*
+****************************************************************************/
+
+#include "Integrator.h"
+
+/****************************************************************************
+* Member Functions
+*
+****************************************************************************/
+
+/**
+    Name: Kick(BodyStore&, double)
+    Function: Changes the velocity of every body by the acceleration from its
+    current force over the given amount of seconds. Bodies without mass are
+    left alone, since the force is divided by the mass.
+**/
+void Integrator::Kick(BodyStore& bodies, double time)
+{
+    const int count = bodies.GetCount();
+    double* pVx = bodies.GetVx();
+    double* pVy = bodies.GetVy();
+    double* pVz = bodies.GetVz();
+    const double* pFx = bodies.GetFx();
+    const double* pFy = bodies.GetFy();
+    const double* pFz = bodies.GetFz();
+    const double* pMass = bodies.GetMass();
+    for(int i = 0; i < count; i++)
+    {
+        if(pMass[i] != 0)
+        {
+            double scale = time/pMass[i];
+            pVx[i] += pFx[i]*scale;
+            pVy[i] += pFy[i]*scale;
+            pVz[i] += pFz[i]*scale;
+        }
+    }
+}
+
+/**
+    Name: Drift(BodyStore&, double)
+    Function: Changes the position of every body by its velocity over the
+    given amount of seconds.
+**/
+void Integrator::Drift(BodyStore& bodies, double time)
+{
+    const int count = bodies.GetCount();
+    double* pX = bodies.GetX();
+    double* pY = bodies.GetY();
+    double* pZ = bodies.GetZ();
+    const double* pVx = bodies.GetVx();
+    const double* pVy = bodies.GetVy();
+    const double* pVz = bodies.GetVz();
+    for(int i = 0; i < count; i++)
+    {
+        pX[i] += pVx[i]*time;
+        pY[i] += pVy[i]*time;
+        pZ[i] += pVz[i]*time;
+    }
+}
@@ -0,0 +1,72 @@
+/****************************************************************************
+*   FILE: Integrator.h
+*
+*   FUNCTION: This class is the base for all integrators. An integrator moves
+*   every body in a space forward in time by one step, calculating gravity
+*   as many times as its method needs.
+*
+*   PURPOSE: Different methods of moving the bodies trade speed for accuracy
+*   in different ways. Keeping them behind a common base lets a space switch
+*   between them at runtime, and lets new methods be added without changing
+*   the space.
+*
+****************************************************************************/
+
+#ifndef _Integrator_
+#define _Integrator_
+
+#include "BodyStore.h"
+#include <vector>
+
+class Space;
+
+//  the integrators a space can use
+enum IntegratorType{
+    //  the original update, one gravity calculation per step
+    INTEGRATOR_EULER,
+    //  kick-drift-kick leapfrog, one gravity calculation per step
+    INTEGRATOR_LEAPFROG,
+    //  velocity Verlet, one gravity calculation per step
+    INTEGRATOR_VELOCITY_VERLET,
+    //  Yoshida's fourth order method, three gravity calculations per step
+    INTEGRATOR_YOSHIDA,
+    //  Hermite steps of a power-of-two length per body, only the bodies
+    //  whose step ends are calculated again
+    INTEGRATOR_BLOCK_TIMESTEP,
+    //  exact Kepler orbits around the heaviest star plus kicks from the
+    //  other bodies, one gravity calculation per step
+    INTEGRATOR_WISDOM_HOLMAN
+};
+
+class Integrator{
+    public:
+    /** Constructors    **/
+    //  default constructor
+    Integrator(){};
+    //  lets integrators be deleted through a base pointer
+    virtual ~Integrator(){};
+    /** Member Functions   **/
+    //  moves all bodies in the space forward by the given amount of seconds
+    virtual void        Step(Space&, double) = 0;
+    //  forgets anything kept from the previous step, called whenever bodies
+    //  are added or removed
+    virtual void        Reset(){};
+    //  appends anything kept between steps that cannot be calculated again
+    //  from the bodies alone to the vector
+    virtual void        SaveState(std::vector<double>&){};
+    //  takes back a state appended by SaveState() for the bodies of the
+    //  space, returns false if it does not fit, in which case the
+    //  integrator starts over as after Reset()
+    virtual bool        LoadState(Space&, const double*, int)
+                            {Reset(); return false;};
+    /** Getters and Setters **/
+    virtual const char* GetName() = 0;
+
+    protected:
+    //  changes the velocity of every body by its force for the given time
+    static void         Kick(BodyStore&, double);
+    //  changes the position of every body by its velocity for the given time
+    static void         Drift(BodyStore&, double);
+};
+
+#endif
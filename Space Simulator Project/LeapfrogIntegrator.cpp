@@ -0,0 +1,61 @@
+/****************************************************************************
+*   FILE: LeapfrogIntegrator.cpp
+*
+*   FUNCTION: This class inherits Integrator and moves the bodies with the
+*   kick-drift-kick leapfrog method: half a step of velocity change from the
+*   current forces, a whole step of movement, new forces, and another half
+*   step of velocity change.
+*
+*   PURPOSE: Leapfrog is symplectic, so the energy of the space does not
+*   drift away over time but only wobbles around its true value. It stays
+*   accurate at much longer steps than the Euler method for the same single
+*   gravity calculation per step, since the forces at the end of one step
+*   are kept and reused at the start of the next.
+*
+****************************************************************************/
+
+#include "LeapfrogIntegrator.h"
+#include "Space.h"
+
+/****************************************************************************
+ * Constructors
+ *
+ ***************************************************************************/
+
+/**
+    Name: LeapfrogIntegrator()
+    Function: Constructs an integrator that calculates the forces at the
+    start of its first step.
+**/
+LeapfrogIntegrator::LeapfrogIntegrator()
+{
+    mForcesValid = false;
+}
+
+/****************************************************************************
+* Member Functions
+*
+****************************************************************************/
+
+/**
+    Name: Step(Space&, double)
+    Function: Kicks the velocities for half the time, drifts the positions
+    for the whole time, calculates the forces at the new positions and kicks
+    the velocities for the second half. The new forces are left in the store
+    for the first kick of the next step.
+**/
+void LeapfrogIntegrator::Step(Space& space, double time)
+{
+    BodyStore& bodies = space.GetBodies();
+    if(!mForcesValid)
+    {
+        space.ClearForces();
+        space.CalculateGravity();
+    }
+    Kick(bodies, time*0.5);
+    Drift(bodies, time);
+    space.ClearForces();
+    space.CalculateGravity();
+    Kick(bodies, time*0.5);
+    mForcesValid = true;
+}
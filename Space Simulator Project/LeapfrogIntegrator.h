@@ -0,0 +1,43 @@
+/****************************************************************************
+*   FILE: LeapfrogIntegrator.h
+*
+*   FUNCTION: This class inherits Integrator and moves the bodies with the
+*   kick-drift-kick leapfrog method: half a step of velocity change from the
+*   current forces, a whole step of movement, new forces, and another half
+*   step of velocity change.
+*
+*   PURPOSE: Leapfrog is symplectic, so the energy of the space does not
+*   drift away over time but only wobbles around its true value. It stays
+*   accurate at much longer steps than the Euler method for the same single
+*   gravity calculation per step, since the forces at the end of one step
+*   are kept and reused at the start of the next.
+*
+****************************************************************************/
+
+#ifndef _LeapfrogIntegrator_
+#define _LeapfrogIntegrator_
+
+#include "Integrator.h"
+
+class LeapfrogIntegrator : public Integrator{
+    public:
+    /** Constructors    **/
+    //  constructs an integrator without any forces kept
+    LeapfrogIntegrator();
+    /** Member Functions   **/
+    //  moves all bodies in the space forward by the given amount of seconds
+    void                Step(Space&, double);
+    //  forgets the forces kept from the previous step
+    void                Reset()
+                            {mForcesValid = false;}
+    /** Getters and Setters **/
+    const char*         GetName()
+                            {return "leapfrog";}
+
+    private:
+    /** Class Members   **/
+    //  true when the forces in the store belong to the current positions
+    bool                mForcesValid;
+};
+
+#endif
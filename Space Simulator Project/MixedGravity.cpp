@@ -0,0 +1,854 @@
+/****************************************************************************
+*   FILE: MixedGravity.cpp
+*
+*   FUNCTION: This class calculates gravity between every pair of bodies in a
+*   body store with the pull of each pair worked out in single precision.
+*   Every calculation sorts the bodies along a Morton curve into small cells
+*   and gives every cell an anchor kept in double precision. For the bodies
+*   of a cell, the positions of all other bodies are measured from its
+*   anchor in double precision and only then rounded to floats, so a float
+*   only ever holds the distance from a nearby point. The pull on a body is
+*   summed in single precision over a block of bodies at a time, and the
+*   blocks in double precision.
+*
+*   PURPOSE: A vector register holds twice as many floats as doubles, so the
+*   single precision kernels calculate twice as many pairs per instruction.
+*   The positions themselves cannot be floats: Neptune is 4.5e12 meters from
+*   the sun, where a float cannot tell apart positions a third of a million
+*   meters from each other. Measuring from a nearby anchor keeps the error of
+*   every distance relative to the size of a cell instead of the distance
+*   from the origin.
+*
+*   NOTES: The double precision position of every body stays in the body
+*   store and is the only state integrated, the floats are made again on
+*   every calculation. The forces are about as accurate as a float, a
+*   relative error around 1e-7, which the space can report by comparing them
+*   with the double precision direct sum.
+*
+*   A cell holds at most 128 bodies and is split further as long as it is
+*   much wider than the shortest distance between two of its bodies, so that
+*   a planet and its moon far out from the sun get an anchor of their own.
+*   Lengths are divided by a power of two about the size of the whole space
+*   and masses by a power of two above the heaviest body, which keeps the
+*   cube of a distance inside the range of a float. Pairs closer than about
+*   1e-12 times the size of the space fall out of that range.
+*
+****************************************************************************/
+
+#include "MixedGravity.h"
+#include <math.h>
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MIXED_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+//  the universal gravitational constant
+const double G = 6.67428e-11;
+//  the most bodies kept in one cell
+const int CELL_SIZE = 128;
+//  the amount of bodies is padded to a whole vector of the widest kernel
+const int LANES = 16;
+//  the amount of bodies pulling on a body before their pull is added up in
+//  double precision, small enough for the block to stay in the first level
+//  cache
+const int BLOCK_SIZE = 512;
+//  the bits of the Morton key given to every axis
+const int KEY_BITS = 21;
+//  how many times wider than the shortest distance between two of its
+//  bodies a cell may be
+const double SPREAD_LIMIT = 64;
+
+/**
+    Name: SpreadBits(unsigned long long)
+    Function: Spreads the lowest 21 bits of the argument out so that two
+    zero bits follow every bit, ready to be interleaved with two other axes.
+**/
+static unsigned long long SpreadBits(unsigned long long bits)
+{
+    bits &= 0x1fffff;
+    bits = (bits | bits << 32) & 0x1f00000000ffffULL;
+    bits = (bits | bits << 16) & 0x1f0000ff0000ffULL;
+    bits = (bits | bits << 8)  & 0x100f00f00f00f00fULL;
+    bits = (bits | bits << 4)  & 0x10c30c30c30c30c3ULL;
+    bits = (bits | bits << 2)  & 0x1249249249249249ULL;
+    return bits;
+}
+
+/**
+    Name: Quantize(double, double, double)
+    Function: Returns the cell along one axis of the grid of 2^21 cells over
+    the space that the coordinate falls in, given the lower corner and the
+    length of the space.
+**/
+static unsigned long long Quantize(double value, double minimum,
+                                   double length)
+{
+    double cell = (value - minimum)/length*(1 << KEY_BITS);
+    if(cell < 0)
+        return 0;
+    if(cell >= (1 << KEY_BITS) - 1)
+        return (1 << KEY_BITS) - 1;
+    return (unsigned long long)cell;
+}
+
+/**
+    Name: PowerOfTwoAbove(double)
+    Function: Returns the smallest power of two above the argument, or one
+    when the argument is zero.
+**/
+static double PowerOfTwoAbove(double value)
+{
+    if(value <= 0)
+        return 1;
+    int exponent;
+    frexp(value, &exponent);
+    return ldexp(1.0, exponent);
+}
+
+/****************************************************************************
+* Kernels
+*
+****************************************************************************/
+
+/**
+    Name: ScalarKernel(const AnchoredCells&, int, int, const double*,
+                       double*, double*, double*)
+    Function: Adds the pull of every body on every body in the range of
+    cells, one pair at a time.
+**/
+static void ScalarKernel(const AnchoredCells& cells, int firstCell,
+                         int lastCell, const double* pBodyMass,
+                         double* pFx, double* pFy, double* pFz)
+{
+    double sumX[CELL_SIZE];
+    double sumY[CELL_SIZE];
+    double sumZ[CELL_SIZE];
+    //  a block of bodies measured from the anchor of the cell
+    float blockX[BLOCK_SIZE];
+    float blockY[BLOCK_SIZE];
+    float blockZ[BLOCK_SIZE];
+    for(int cell = firstCell; cell < lastCell; cell++)
+    {
+        const int first = cells.pFirstBody[cell];
+        const int last = cells.pFirstBody[cell + 1];
+        const double anchorX = cells.pAnchorX[cell];
+        const double anchorY = cells.pAnchorY[cell];
+        const double anchorZ = cells.pAnchorZ[cell];
+        std::fill(sumX, sumX + (last - first), 0.0);
+        std::fill(sumY, sumY + (last - first), 0.0);
+        std::fill(sumZ, sumZ + (last - first), 0.0);
+        for(int block = 0; block < cells.padded; block += BLOCK_SIZE)
+        {
+            const int size = std::min(BLOCK_SIZE, cells.padded - block);
+            const double* pX = cells.pX + block;
+            const double* pY = cells.pY + block;
+            const double* pZ = cells.pZ + block;
+            const float* pMass = cells.pMass + block;
+            //  the anchor is subtracted in double precision
+            for(int j = 0; j < size; j++)
+            {
+                blockX[j] = (float)(pX[j] - anchorX);
+                blockY[j] = (float)(pY[j] - anchorY);
+                blockZ[j] = (float)(pZ[j] - anchorZ);
+            }
+            for(int i = first; i < last; i++)
+            {
+                const float xi = (float)(cells.pX[i] - anchorX);
+                const float yi = (float)(cells.pY[i] - anchorY);
+                const float zi = (float)(cells.pZ[i] - anchorZ);
+                float fx = 0;
+                float fy = 0;
+                float fz = 0;
+                for(int j = 0; j < size; j++)
+                {
+                    float dx = blockX[j] - xi;
+                    float dy = blockY[j] - yi;
+                    float dz = blockZ[j] - zi;
+                    float length2 = dx*dx + dy*dy + dz*dz + cells.softening2;
+                    if(length2 == 0)
+                        continue;
+                    float force = pMass[j]/(length2*sqrtf(length2));
+                    fx += dx*force;
+                    fy += dy*force;
+                    fz += dz*force;
+                }
+                sumX[i - first] += fx;
+                sumY[i - first] += fy;
+                sumZ[i - first] += fz;
+            }
+        }
+        for(int i = first; i < last; i++)
+        {
+            const int body = cells.pBody[i];
+            const double scale = cells.forceScale*pBodyMass[body];
+            pFx[body] += scale*sumX[i - first];
+            pFy[body] += scale*sumY[i - first];
+            pFz[body] += scale*sumZ[i - first];
+        }
+    }
+}
+
+#ifdef MIXED_KERNEL_X86
+
+/**
+    Name: Sum4(__m128)
+    Function: Adds up the four floats of the vector.
+**/
+__attribute__((target("sse2")))
+static inline float Sum4(__m128 v)
+{
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+
+/**
+    Name: Sum8(__m256)
+    Function: Adds up the eight floats of the vector.
+**/
+__attribute__((target("avx2,fma")))
+static inline float Sum8(__m256 v)
+{
+    return Sum4(_mm_add_ps(_mm256_castps256_ps128(v),
+                           _mm256_extractf128_ps(v, 1)));
+}
+
+/**
+    Name: Sum16(__m512)
+    Function: Adds up the sixteen floats of the vector, first the upper half
+    onto the lower and then the second quarter onto the first. The shuffles
+    are masked with every lane set, which does the same as the unmasked ones
+    without GCC warning about their undefined source.
+**/
+__attribute__((target("avx512f")))
+static inline float Sum16(__m512 v)
+{
+    v = _mm512_add_ps(v, _mm512_maskz_shuffle_f32x4(0xffff, v, v,
+                             _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm512_add_ps(v, _mm512_maskz_shuffle_f32x4(0xffff, v, v,
+                             _MM_SHUFFLE(2, 3, 0, 1)));
+    return Sum4(_mm512_maskz_extractf32x4_ps(0xf, v, 0));
+}
+
+/**
+    Name: Sse2Kernel(const AnchoredCells&, int, int, const double*,
+                     double*, double*, double*)
+    Function: Adds the pull of every body on every body in the range of
+    cells, four pairs at a time.
+**/
+__attribute__((target("sse2")))
+static void Sse2Kernel(const AnchoredCells& cells, int firstCell,
+                       int lastCell, const double* pBodyMass,
+                       double* pFx, double* pFy, double* pFz)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 threeHalves = _mm_set1_ps(1.5f);
+    const __m128 softening = _mm_set1_ps(cells.softening2);
+    double sumX[CELL_SIZE];
+    double sumY[CELL_SIZE];
+    double sumZ[CELL_SIZE];
+    //  a block of bodies measured from the anchor of the cell
+    float blockX[BLOCK_SIZE];
+    float blockY[BLOCK_SIZE];
+    float blockZ[BLOCK_SIZE];
+    for(int cell = firstCell; cell < lastCell; cell++)
+    {
+        const int first = cells.pFirstBody[cell];
+        const int last = cells.pFirstBody[cell + 1];
+        const double anchorX = cells.pAnchorX[cell];
+        const double anchorY = cells.pAnchorY[cell];
+        const double anchorZ = cells.pAnchorZ[cell];
+        const __m128d anchorVX = _mm_set1_pd(anchorX);
+        const __m128d anchorVY = _mm_set1_pd(anchorY);
+        const __m128d anchorVZ = _mm_set1_pd(anchorZ);
+        std::fill(sumX, sumX + (last - first), 0.0);
+        std::fill(sumY, sumY + (last - first), 0.0);
+        std::fill(sumZ, sumZ + (last - first), 0.0);
+        for(int block = 0; block < cells.padded; block += BLOCK_SIZE)
+        {
+            const int size = std::min(BLOCK_SIZE, cells.padded - block);
+            const double* pX = cells.pX + block;
+            const double* pY = cells.pY + block;
+            const double* pZ = cells.pZ + block;
+            const float* pMass = cells.pMass + block;
+            //  the anchor is subtracted in double precision
+            for(int j = 0; j < size; j += 2)
+            {
+                _mm_storel_pi((__m64*)(blockX + j), _mm_cvtpd_ps(
+                    _mm_sub_pd(_mm_loadu_pd(pX + j), anchorVX)));
+                _mm_storel_pi((__m64*)(blockY + j), _mm_cvtpd_ps(
+                    _mm_sub_pd(_mm_loadu_pd(pY + j), anchorVY)));
+                _mm_storel_pi((__m64*)(blockZ + j), _mm_cvtpd_ps(
+                    _mm_sub_pd(_mm_loadu_pd(pZ + j), anchorVZ)));
+            }
+            for(int i = first; i < last; i++)
+            {
+                const __m128 xi = _mm_set1_ps(
+                                    (float)(cells.pX[i] - anchorX));
+                const __m128 yi = _mm_set1_ps(
+                                    (float)(cells.pY[i] - anchorY));
+                const __m128 zi = _mm_set1_ps(
+                                    (float)(cells.pZ[i] - anchorZ));
+                __m128 fx = zero;
+                __m128 fy = zero;
+                __m128 fz = zero;
+                for(int j = 0; j < size; j += 4)
+                {
+                    __m128 dx = _mm_sub_ps(_mm_loadu_ps(blockX + j), xi);
+                    __m128 dy = _mm_sub_ps(_mm_loadu_ps(blockY + j), yi);
+                    __m128 dz = _mm_sub_ps(_mm_loadu_ps(blockZ + j), zi);
+                    __m128 length2 = _mm_add_ps(
+                            _mm_add_ps(_mm_mul_ps(dx, dx),
+                                       _mm_mul_ps(dy, dy)),
+                            _mm_add_ps(_mm_mul_ps(dz, dz), softening));
+                    //  one Newton step: y = y*(1.5 - 0.5*r*r*y*y)
+                    __m128 y = _mm_rsqrt_ps(length2);
+                    y = _mm_mul_ps(y, _mm_sub_ps(threeHalves,
+                            _mm_mul_ps(_mm_mul_ps(half, length2),
+                                       _mm_mul_ps(y, y))));
+                    //  a pair at zero distance does not pull
+                    __m128 inverse3 = _mm_and_ps(
+                            _mm_mul_ps(y, _mm_mul_ps(y, y)),
+                            _mm_cmpgt_ps(length2, zero));
+                    __m128 force = _mm_mul_ps(_mm_loadu_ps(pMass + j),
+                                              inverse3);
+                    fx = _mm_add_ps(fx, _mm_mul_ps(dx, force));
+                    fy = _mm_add_ps(fy, _mm_mul_ps(dy, force));
+                    fz = _mm_add_ps(fz, _mm_mul_ps(dz, force));
+                }
+                sumX[i - first] += Sum4(fx);
+                sumY[i - first] += Sum4(fy);
+                sumZ[i - first] += Sum4(fz);
+            }
+        }
+        for(int i = first; i < last; i++)
+        {
+            const int body = cells.pBody[i];
+            const double scale = cells.forceScale*pBodyMass[body];
+            pFx[body] += scale*sumX[i - first];
+            pFy[body] += scale*sumY[i - first];
+            pFz[body] += scale*sumZ[i - first];
+        }
+    }
+}
+
+/**
+    Name: Avx2Kernel(const AnchoredCells&, int, int, const double*,
+                     double*, double*, double*)
+    Function: Adds the pull of every body on every body in the range of
+    cells, eight pairs at a time.
+**/
+__attribute__((target("avx2,fma")))
+static void Avx2Kernel(const AnchoredCells& cells, int firstCell,
+                       int lastCell, const double* pBodyMass,
+                       double* pFx, double* pFy, double* pFz)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 threeHalves = _mm256_set1_ps(1.5f);
+    const __m256 softening = _mm256_set1_ps(cells.softening2);
+    double sumX[CELL_SIZE];
+    double sumY[CELL_SIZE];
+    double sumZ[CELL_SIZE];
+    //  a block of bodies measured from the anchor of the cell
+    float blockX[BLOCK_SIZE];
+    float blockY[BLOCK_SIZE];
+    float blockZ[BLOCK_SIZE];
+    for(int cell = firstCell; cell < lastCell; cell++)
+    {
+        const int first = cells.pFirstBody[cell];
+        const int last = cells.pFirstBody[cell + 1];
+        const double anchorX = cells.pAnchorX[cell];
+        const double anchorY = cells.pAnchorY[cell];
+        const double anchorZ = cells.pAnchorZ[cell];
+        const __m256d anchorVX = _mm256_set1_pd(anchorX);
+        const __m256d anchorVY = _mm256_set1_pd(anchorY);
+        const __m256d anchorVZ = _mm256_set1_pd(anchorZ);
+        std::fill(sumX, sumX + (last - first), 0.0);
+        std::fill(sumY, sumY + (last - first), 0.0);
+        std::fill(sumZ, sumZ + (last - first), 0.0);
+        for(int block = 0; block < cells.padded; block += BLOCK_SIZE)
+        {
+            const int size = std::min(BLOCK_SIZE, cells.padded - block);
+            const double* pX = cells.pX + block;
+            const double* pY = cells.pY + block;
+            const double* pZ = cells.pZ + block;
+            const float* pMass = cells.pMass + block;
+            //  the anchor is subtracted in double precision
+            for(int j = 0; j < size; j += 4)
+            {
+                _mm_storeu_ps(blockX + j, _mm256_cvtpd_ps(
+                    _mm256_sub_pd(_mm256_loadu_pd(pX + j), anchorVX)));
+                _mm_storeu_ps(blockY + j, _mm256_cvtpd_ps(
+                    _mm256_sub_pd(_mm256_loadu_pd(pY + j), anchorVY)));
+                _mm_storeu_ps(blockZ + j, _mm256_cvtpd_ps(
+                    _mm256_sub_pd(_mm256_loadu_pd(pZ + j), anchorVZ)));
+            }
+            for(int i = first; i < last; i++)
+            {
+                const __m256 xi = _mm256_set1_ps(
+                                    (float)(cells.pX[i] - anchorX));
+                const __m256 yi = _mm256_set1_ps(
+                                    (float)(cells.pY[i] - anchorY));
+                const __m256 zi = _mm256_set1_ps(
+                                    (float)(cells.pZ[i] - anchorZ));
+                __m256 fx = zero;
+                __m256 fy = zero;
+                __m256 fz = zero;
+                for(int j = 0; j < size; j += 8)
+                {
+                    __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(blockX + j),
+                                                xi);
+                    __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(blockY + j),
+                                                yi);
+                    __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(blockZ + j),
+                                                zi);
+                    __m256 length2 = _mm256_fmadd_ps(dx, dx,
+                            _mm256_fmadd_ps(dy, dy,
+                                _mm256_fmadd_ps(dz, dz, softening)));
+                    //  one Newton step: y = y*(1.5 - 0.5*r*r*y*y)
+                    __m256 y = _mm256_rsqrt_ps(length2);
+                    y = _mm256_mul_ps(y, _mm256_fnmadd_ps(
+                            _mm256_mul_ps(half, length2),
+                            _mm256_mul_ps(y, y), threeHalves));
+                    //  a pair at zero distance does not pull
+                    __m256 inverse3 = _mm256_and_ps(
+                            _mm256_mul_ps(y, _mm256_mul_ps(y, y)),
+                            _mm256_cmp_ps(length2, zero, _CMP_GT_OQ));
+                    __m256 force = _mm256_mul_ps(_mm256_loadu_ps(pMass + j),
+                                                 inverse3);
+                    fx = _mm256_fmadd_ps(dx, force, fx);
+                    fy = _mm256_fmadd_ps(dy, force, fy);
+                    fz = _mm256_fmadd_ps(dz, force, fz);
+                }
+                sumX[i - first] += Sum8(fx);
+                sumY[i - first] += Sum8(fy);
+                sumZ[i - first] += Sum8(fz);
+            }
+        }
+        for(int i = first; i < last; i++)
+        {
+            const int body = cells.pBody[i];
+            const double scale = cells.forceScale*pBodyMass[body];
+            pFx[body] += scale*sumX[i - first];
+            pFy[body] += scale*sumY[i - first];
+            pFz[body] += scale*sumZ[i - first];
+        }
+    }
+}
+
+/**
+    Name: Avx512Kernel(const AnchoredCells&, int, int, const double*,
+                       double*, double*, double*)
+    Function: Adds the pull of every body on every body in the range of
+    cells, sixteen pairs at a time. The estimate of AVX-512 is exact to
+    14 bits, so one Newton step reaches full single precision.
+**/
+__attribute__((target("avx512f")))
+static void Avx512Kernel(const AnchoredCells& cells, int firstCell,
+                         int lastCell, const double* pBodyMass,
+                         double* pFx, double* pFy, double* pFz)
+{
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512 half = _mm512_set1_ps(0.5f);
+    const __m512 threeHalves = _mm512_set1_ps(1.5f);
+    const __m512 softening = _mm512_set1_ps(cells.softening2);
+    double sumX[CELL_SIZE];
+    double sumY[CELL_SIZE];
+    double sumZ[CELL_SIZE];
+    //  a block of bodies measured from the anchor of the cell
+    float blockX[BLOCK_SIZE];
+    float blockY[BLOCK_SIZE];
+    float blockZ[BLOCK_SIZE];
+    for(int cell = firstCell; cell < lastCell; cell++)
+    {
+        const int first = cells.pFirstBody[cell];
+        const int last = cells.pFirstBody[cell + 1];
+        const double anchorX = cells.pAnchorX[cell];
+        const double anchorY = cells.pAnchorY[cell];
+        const double anchorZ = cells.pAnchorZ[cell];
+        const __m512d anchorVX = _mm512_set1_pd(anchorX);
+        const __m512d anchorVY = _mm512_set1_pd(anchorY);
+        const __m512d anchorVZ = _mm512_set1_pd(anchorZ);
+        std::fill(sumX, sumX + (last - first), 0.0);
+        std::fill(sumY, sumY + (last - first), 0.0);
+        std::fill(sumZ, sumZ + (last - first), 0.0);
+        for(int block = 0; block < cells.padded; block += BLOCK_SIZE)
+        {
+            const int size = std::min(BLOCK_SIZE, cells.padded - block);
+            const double* pX = cells.pX + block;
+            const double* pY = cells.pY + block;
+            const double* pZ = cells.pZ + block;
+            const float* pMass = cells.pMass + block;
+            //  the anchor is subtracted in double precision
+            for(int j = 0; j < size; j += 8)
+            {
+                _mm256_storeu_ps(blockX + j, _mm512_maskz_cvtpd_ps(0xff,
+                    _mm512_sub_pd(_mm512_loadu_pd(pX + j), anchorVX)));
+                _mm256_storeu_ps(blockY + j, _mm512_maskz_cvtpd_ps(0xff,
+                    _mm512_sub_pd(_mm512_loadu_pd(pY + j), anchorVY)));
+                _mm256_storeu_ps(blockZ + j, _mm512_maskz_cvtpd_ps(0xff,
+                    _mm512_sub_pd(_mm512_loadu_pd(pZ + j), anchorVZ)));
+            }
+            for(int i = first; i < last; i++)
+            {
+                const __m512 xi = _mm512_set1_ps(
+                                    (float)(cells.pX[i] - anchorX));
+                const __m512 yi = _mm512_set1_ps(
+                                    (float)(cells.pY[i] - anchorY));
+                const __m512 zi = _mm512_set1_ps(
+                                    (float)(cells.pZ[i] - anchorZ));
+                __m512 fx = zero;
+                __m512 fy = zero;
+                __m512 fz = zero;
+                for(int j = 0; j < size; j += 16)
+                {
+                    __m512 dx = _mm512_sub_ps(_mm512_loadu_ps(blockX + j),
+                                                xi);
+                    __m512 dy = _mm512_sub_ps(_mm512_loadu_ps(blockY + j),
+                                                yi);
+                    __m512 dz = _mm512_sub_ps(_mm512_loadu_ps(blockZ + j),
+                                                zi);
+                    __m512 length2 = _mm512_fmadd_ps(dx, dx,
+                            _mm512_fmadd_ps(dy, dy,
+                                _mm512_fmadd_ps(dz, dz, softening)));
+                    //  a pair at zero distance does not pull
+                    __mmask16 pulls = _mm512_cmp_ps_mask(length2, zero,
+                                                         _CMP_GT_OQ);
+                    __m512 y = _mm512_maskz_rsqrt14_ps(pulls, length2);
+                    //  one Newton step: y = y*(1.5 - 0.5*r*r*y*y)
+                    y = _mm512_mul_ps(y, _mm512_fnmadd_ps(
+                            _mm512_mul_ps(half, length2),
+                            _mm512_mul_ps(y, y), threeHalves));
+                    __m512 force = _mm512_mul_ps(_mm512_loadu_ps(pMass + j),
+                            _mm512_mul_ps(y, _mm512_mul_ps(y, y)));
+                    fx = _mm512_fmadd_ps(dx, force, fx);
+                    fy = _mm512_fmadd_ps(dy, force, fy);
+                    fz = _mm512_fmadd_ps(dz, force, fz);
+                }
+                sumX[i - first] += Sum16(fx);
+                sumY[i - first] += Sum16(fy);
+                sumZ[i - first] += Sum16(fz);
+            }
+        }
+        for(int i = first; i < last; i++)
+        {
+            const int body = cells.pBody[i];
+            const double scale = cells.forceScale*pBodyMass[body];
+            pFx[body] += scale*sumX[i - first];
+            pFy[body] += scale*sumY[i - first];
+            pFz[body] += scale*sumZ[i - first];
+        }
+    }
+}
+
+#endif
+
+/****************************************************************************
+ * Constructors
+ *
+ ***************************************************************************/
+
+/**
+    Name: MixedGravity()
+    Function: Constructs a solver that runs on the calling thread only until
+    a higher thread count is set, using the widest kernel the processor
+    supports. Four floats fit in an SSE2 register, so unlike the double
+    precision direct sum, SSE2 processors use their kernel as well.
+**/
+MixedGravity::MixedGravity() : mThreads(1)
+{
+    mLength = 1;
+    mMassScale = 1;
+    mSoftening = 0;
+    SetKernel(GravityKernel::Detect());
+}
+
+/****************************************************************************
+* Member Functions
+*
+****************************************************************************/
+
+/**
+    Name: CalculateGravity(BodyStore&, double*, double*, double*)
+    Function: Sorts the bodies into anchored cells and adds the force on
+    every body to the argument x, y and z force arrays. The cells are split
+    over the threads so that every thread gets about the same amount of
+    bodies, and every thread only writes the bodies of its own cells.
+**/
+void MixedGravity::CalculateGravity(BodyStore& bodies, double* pFx,
+                                    double* pFy, double* pFz)
+{
+    const int count = bodies.GetCount();
+    if(count < 2)
+        return;
+    Build(bodies);
+    AnchoredCells cells;
+    cells.count         = (int)mAnchorX.size();
+    cells.pFirstBody    = &mFirstBody[0];
+    cells.padded        = (int)mX.size();
+    cells.pAnchorX      = &mAnchorX[0];
+    cells.pAnchorY      = &mAnchorY[0];
+    cells.pAnchorZ      = &mAnchorZ[0];
+    cells.pX            = &mX[0];
+    cells.pY            = &mY[0];
+    cells.pZ            = &mZ[0];
+    cells.pMass         = &mMass[0];
+    cells.pBody         = &mBody[0];
+    cells.softening2    = (float)(mSoftening*mSoftening/
+                                  (mLength*mLength));
+    cells.forceScale    = G*mMassScale/(mLength*mLength);
+    //  every body of a cell costs the same
+    const int threadCount = mThreads.GetThreadCount();
+    mFirstCell.assign(threadCount + 1, cells.count);
+    mFirstCell[0] = 0;
+    int thread = 1;
+    for(int c = 0; c < cells.count && thread < threadCount; c++)
+    {
+        while(thread < threadCount &&
+              mFirstBody[c] >= (long long)count*thread/threadCount)
+        {
+            mFirstCell[thread] = c;
+            thread++;
+        }
+    }
+    const double* pBodyMass = bodies.GetMass();
+    mThreads.Run([&](int thread){
+        mpKernel(cells, mFirstCell[thread], mFirstCell[thread + 1],
+                 pBodyMass, pFx, pFy, pFz);
+    });
+}
+
+/**
+    Name: Build(BodyStore&)
+    Function: Finds the size of the space and the heaviest body, sorts the
+    bodies along a Morton curve over the space, copies them in that order
+    divided by the scales and splits them into cells. Dividing by a power
+    of two does not round, so the sorted positions are as exact as the ones
+    in the store.
+**/
+void MixedGravity::Build(BodyStore& bodies)
+{
+    const int count = bodies.GetCount();
+    const double* pX = bodies.GetX();
+    const double* pY = bodies.GetY();
+    const double* pZ = bodies.GetZ();
+    const double* pMass = bodies.GetMass();
+    /*  START: Measure the space    */
+    double minimumX = pX[0], maximumX = pX[0];
+    double minimumY = pY[0], maximumY = pY[0];
+    double minimumZ = pZ[0], maximumZ = pZ[0];
+    double maximumMass = 0;
+    for(int i = 0; i < count; i++)
+    {
+        minimumX = std::min(minimumX, pX[i]);
+        maximumX = std::max(maximumX, pX[i]);
+        minimumY = std::min(minimumY, pY[i]);
+        maximumY = std::max(maximumY, pY[i]);
+        minimumZ = std::min(minimumZ, pZ[i]);
+        maximumZ = std::max(maximumZ, pZ[i]);
+        maximumMass = std::max(maximumMass, pMass[i]);
+    }
+    double size = std::max(maximumX - minimumX,
+                           std::max(maximumY - minimumY,
+                                    maximumZ - minimumZ));
+    mLength = PowerOfTwoAbove(size);
+    mMassScale = PowerOfTwoAbove(maximumMass);
+    /*  END: Measure the space  */
+    /*  START: Sort the bodies along the curve  */
+    mSorted.resize(count);
+    for(int i = 0; i < count; i++)
+    {
+        unsigned long long key =
+            SpreadBits(Quantize(pX[i], minimumX, mLength)) << 2 |
+            SpreadBits(Quantize(pY[i], minimumY, mLength)) << 1 |
+            SpreadBits(Quantize(pZ[i], minimumZ, mLength));
+        mSorted[i] = std::make_pair(key, i);
+    }
+    std::sort(mSorted.begin(), mSorted.end());
+    /*  END: Sort the bodies along the curve    */
+    /*  START: Copy the sorted bodies   */
+    //  the padding pulls on nothing and is never pulled
+    const int padded = (count + LANES - 1)/LANES*LANES;
+    const double inverseLength = 1/mLength;
+    const double inverseMass = 1/mMassScale;
+    mX.assign(padded, 0);
+    mY.assign(padded, 0);
+    mZ.assign(padded, 0);
+    mMass.assign(padded, 0);
+    mBody.resize(count);
+    for(int i = 0; i < count; i++)
+    {
+        const int body = mSorted[i].second;
+        mX[i] = pX[body]*inverseLength;
+        mY[i] = pY[body]*inverseLength;
+        mZ[i] = pZ[body]*inverseLength;
+        mMass[i] = (float)(pMass[body]*inverseMass);
+        mBody[i] = body;
+    }
+    /*  END: Copy the sorted bodies */
+    mFirstBody.clear();
+    mAnchorX.clear();
+    mAnchorY.clear();
+    mAnchorZ.clear();
+    BuildCells(0, count, KEY_BITS - 1);
+    mFirstBody.push_back(count);
+}
+
+/**
+    Name: BuildCells(int, int, int)
+    Function: Adds the sorted bodies from the first up to but not including
+    the last as one cell if there are few enough of them and they are close
+    enough together. Otherwise they are split into the eight octants of the
+    given level of the curve, counted from the finest level at zero, which
+    are already next to each other in the sorted order. Neighbouring octants
+    with few enough bodies between them are tried as one cell before each
+    of them is split further, which keeps the cells full.
+**/
+void MixedGravity::BuildCells(int first, int last, int level)
+{
+    const int count = last - first;
+    if(count <= CELL_SIZE && (count == 1 || level < 0 ||
+                              IsCompact(first, last)))
+    {
+        AddCell(first, last);
+        return;
+    }
+    if(level < 0)
+    {
+        //  more bodies than fit a cell share the finest level of the curve
+        for(int i = first; i < last; i += CELL_SIZE)
+            AddCell(i, std::min(i + CELL_SIZE, last));
+        return;
+    }
+    /*  START: Find the octants at this level */
+    const int shift = 3*level;
+    int ends[9];
+    int octants = 0;
+    ends[0] = first;
+    while(ends[octants] < last)
+    {
+        int end = ends[octants];
+        const unsigned long long octant = mSorted[end].first >> shift & 7;
+        while(end < last && (mSorted[end].first >> shift & 7) == octant)
+            end++;
+        octants++;
+        ends[octants] = end;
+    }
+    /*  END: Find the octants at this level   */
+    int group = 0;
+    while(group < octants)
+    {
+        //  gather the following octants as long as they fit in a cell
+        int groupEnd = group + 1;
+        while(groupEnd < octants &&
+              ends[groupEnd + 1] - ends[group] <= CELL_SIZE)
+            groupEnd++;
+        if(groupEnd - group > 1 && IsCompact(ends[group], ends[groupEnd]))
+            AddCell(ends[group], ends[groupEnd]);
+        else
+        {
+            for(int octant = group; octant < groupEnd; octant++)
+                BuildCells(ends[octant], ends[octant + 1], level - 1);
+        }
+        group = groupEnd;
+    }
+}
+
+/**
+    Name: IsCompact(int, int)
+    Function: Returns true if the sorted bodies from the first up to but not
+    including the last are at most the spread limit times wider than the
+    shortest distance between two of them. Bodies at the same position are
+    never compact.
+**/
+bool MixedGravity::IsCompact(int first, int last)
+{
+    double shortest2 = -1;
+    double minimumX = mX[first], maximumX = minimumX;
+    double minimumY = mY[first], maximumY = minimumY;
+    double minimumZ = mZ[first], maximumZ = minimumZ;
+    for(int i = first; i < last; i++)
+    {
+        minimumX = std::min(minimumX, mX[i]);
+        maximumX = std::max(maximumX, mX[i]);
+        minimumY = std::min(minimumY, mY[i]);
+        maximumY = std::max(maximumY, mY[i]);
+        minimumZ = std::min(minimumZ, mZ[i]);
+        maximumZ = std::max(maximumZ, mZ[i]);
+        for(int j = i + 1; j < last; j++)
+        {
+            double dx = mX[j] - mX[i];
+            double dy = mY[j] - mY[i];
+            double dz = mZ[j] - mZ[i];
+            double length2 = dx*dx + dy*dy + dz*dz;
+            if(shortest2 < 0 || length2 < shortest2)
+                shortest2 = length2;
+        }
+    }
+    double size = std::max(maximumX - minimumX,
+                           std::max(maximumY - minimumY,
+                                    maximumZ - minimumZ));
+    return size*size <= SPREAD_LIMIT*SPREAD_LIMIT*shortest2;
+}
+
+/**
+    Name: AddCell(int, int)
+    Function: Adds the sorted bodies from the first up to but not including
+    the last as one cell, anchored at the center of their bounding box.
+**/
+void MixedGravity::AddCell(int first, int last)
+{
+    double minimumX = mX[first], maximumX = minimumX;
+    double minimumY = mY[first], maximumY = minimumY;
+    double minimumZ = mZ[first], maximumZ = minimumZ;
+    for(int i = first; i < last; i++)
+    {
+        minimumX = std::min(minimumX, mX[i]);
+        maximumX = std::max(maximumX, mX[i]);
+        minimumY = std::min(minimumY, mY[i]);
+        maximumY = std::max(maximumY, mY[i]);
+        minimumZ = std::min(minimumZ, mZ[i]);
+        maximumZ = std::max(maximumZ, mZ[i]);
+    }
+    mFirstBody.push_back(first);
+    mAnchorX.push_back(0.5*(minimumX + maximumX));
+    mAnchorY.push_back(0.5*(minimumY + maximumY));
+    mAnchorZ.push_back(0.5*(minimumZ + maximumZ));
+}
+
+/****************************************************************************
+* Getters and Setters
+*
+****************************************************************************/
+
+/**
+    Name: SetKernel(KernelLevel)
+    Function: Uses the kernel for the given instruction set. If the processor
+    does not support it, the widest supported set below it is used instead.
+**/
+void MixedGravity::SetKernel(KernelLevel level)
+{
+    KernelLevel supported = GravityKernel::Detect();
+    mKernel = level < supported ? level : supported;
+    switch(mKernel)
+    {
+#ifdef MIXED_KERNEL_X86
+        case KERNEL_AVX512:
+            mpKernel = Avx512Kernel;
+            break;
+        case KERNEL_AVX2:
+            mpKernel = Avx2Kernel;
+            break;
+        case KERNEL_SSE2:
+            mpKernel = Sse2Kernel;
+            break;
+#endif
+        default:
+            mpKernel = ScalarKernel;
+            break;
+    }
+}
@@ -0,0 +1,140 @@
+/****************************************************************************
+*   FILE: MixedGravity.h
+*
+*   FUNCTION: This class calculates gravity between every pair of bodies in a
+*   body store with the pull of each pair worked out in single precision.
+*   Every calculation sorts the bodies along a Morton curve into small cells
+*   and gives every cell an anchor kept in double precision. For the bodies
+*   of a cell, the positions of all other bodies are measured from its
+*   anchor in double precision and only then rounded to floats, so a float
+*   only ever holds the distance from a nearby point. The pull on a body is
+*   summed in single precision over a block of bodies at a time, and the
+*   blocks in double precision.
+*
+*   PURPOSE: A vector register holds twice as many floats as doubles, so the
+*   single precision kernels calculate twice as many pairs per instruction.
+*   The positions themselves cannot be floats: Neptune is 4.5e12 meters from
+*   the sun, where a float cannot tell apart positions a third of a million
+*   meters from each other. Measuring from a nearby anchor keeps the error of
+*   every distance relative to the size of a cell instead of the distance
+*   from the origin.
+*
+*   NOTES: The double precision position of every body stays in the body
+*   store and is the only state integrated, the floats are made again on
+*   every calculation. The forces are about as accurate as a float, a
+*   relative error around 1e-7, which the space can report by comparing them
+*   with the double precision direct sum.
+*
+****************************************************************************/
+
+#ifndef _MixedGravity_
+#define _MixedGravity_
+
+#include "BodyStore.h"
+#include "ThreadPool.h"
+#include "GravityKernel.h"
+#include <utility>
+#include <vector>
+
+//  the bodies of a store sorted into anchored cells, as read by a kernel
+struct AnchoredCells{
+    //  the amount of cells
+    int                 count;
+    //  the first sorted body of every cell, followed by the amount of bodies
+    const int*          pFirstBody;
+    //  the amount of bodies rounded up to a whole vector
+    int                 padded;
+    //  the anchor of every cell and the position of every sorted body,
+    //  divided by the length scale, with the padding at zero
+    const double*       pAnchorX;
+    const double*       pAnchorY;
+    const double*       pAnchorZ;
+    const double*       pX;
+    const double*       pY;
+    const double*       pZ;
+    //  the mass of every sorted body divided by the mass scale, with the
+    //  padding at zero
+    const float*        pMass;
+    //  the index in the store of every sorted body
+    const int*          pBody;
+    //  the square of the softening length divided by the length scale
+    float               softening2;
+    //  the factor turning a summed pull into newtons per kilogram of the
+    //  pulled body
+    double              forceScale;
+};
+
+//  a mixed kernel adds the force on every body in the cells from the first
+//  up to but not including the last to the x, y and z force arrays, given
+//  the masses in the store
+typedef void (*MixedKernelFunction)(const AnchoredCells&, int, int,
+                                    const double*,
+                                    double*, double*, double*);
+
+class MixedGravity{
+    public:
+    /** Constructors    **/
+    //  constructs a solver running on a single thread
+    MixedGravity();
+    /** Member Functions   **/
+    //  adds the gravitational force on every body in the store to the
+    //  argument force arrays
+    void                CalculateGravity(BodyStore&, double*, double*,
+                                         double*);
+    /** Getters and Setters **/
+    int                 GetThreadCount()
+                            {return mThreads.GetThreadCount();}
+    void                SetThreadCount(int threadCount)
+                            {mThreads.SetThreadCount(threadCount);}
+    KernelLevel         GetKernel()
+                            {return mKernel;}
+    //  uses the kernel for the given instruction set, or the widest one
+    //  supported below it
+    void                SetKernel(KernelLevel);
+    //  the amount of cells the bodies were sorted into last time
+    int                 GetCellCount()
+                            {return mAnchorX.size();}
+    //  the Plummer softening length in meters, 0 for none
+    double              GetSoftening()
+                            {return mSoftening;}
+    void                SetSoftening(double softening)
+                            {mSoftening = softening;}
+
+    private:
+    //  sorts the bodies of the store into anchored cells
+    void                Build(BodyStore&);
+    //  turns the sorted bodies from the first up to but not including the
+    //  last into cells, splitting them on the given level of the curve
+    void                BuildCells(int, int, int);
+    //  true if the sorted bodies from the first up to but not including the
+    //  last are close enough together to share a cell
+    bool                IsCompact(int, int);
+    //  adds the sorted bodies from the first up to but not including the
+    //  last as one cell
+    void                AddCell(int, int);
+
+    /** Class Members   **/
+    ThreadPool                  mThreads;
+    KernelLevel                 mKernel;
+    MixedKernelFunction         mpKernel;
+    double                      mSoftening;
+    //  the Morton key and the index of every body, sorted by key
+    std::vector< std::pair<unsigned long long, int> > mSorted;
+    //  the length and the mass scale of the last build
+    double                      mLength;
+    double                      mMassScale;
+    //  the sorted bodies and the cells, as described by AnchoredCells
+    std::vector<double>         mX;
+    std::vector<double>         mY;
+    std::vector<double>         mZ;
+    std::vector<float>          mMass;
+    std::vector<int>            mBody;
+    std::vector<int>            mFirstBody;
+    std::vector<double>         mAnchorX;
+    std::vector<double>         mAnchorY;
+    std::vector<double>         mAnchorZ;
+    //  the first cell of every thread, followed by the amount of cells
+    std::vector<int>            mFirstCell;
+};
+
+#endif
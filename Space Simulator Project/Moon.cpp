@@ -33,9 +33,40 @@ Moon::Moon(Planet * pOwner, std::string name, double mass, double radius,
     mName = name;
     mMass = mass;
     mRadius = radius;
+    mPosition = CalculatePosition(pOwner->GetPosition(), distance);
+    mVelocity = CalculateVelocity(pOwner->GetVelocity(),
+                                  pOwner->GetMass(), distance);
+    //  force starts at neutral
+    mForce = Vec3d(0, 0);
+    mRed = red;
+    mGreen = green;
+    mBlue = blue;
+}
+
+/****************************************************************************
+* Member Functions
+*
+****************************************************************************/
+
+/**
+    Name: CalculatePosition(Vec3d, double)
+    Function: Returns the position of a moon at the given distance right
+    above its owner.
+**/
+Vec3d Moon::CalculatePosition(Vec3d ownerPosition, double distance)
+{
     //  place the moon at a certain distance from its owner
-    mPosition = Coordinate(pOwner->GetPosition().GetX(),
-                           pOwner->GetPosition().GetY()+distance);
+    return ownerPosition + Vec3d(0, distance);
+}
+
+/**
+    Name: CalculateVelocity(Vec3d, double, double)
+    Function: Returns the velocity of a moon at the given distance from its
+    owner, so that it orbits the owner in a circle.
+**/
+Vec3d Moon::CalculateVelocity(Vec3d ownerVelocity, double ownerMass,
+                              double distance)
+{
     /*  START Calculate velocity    */
     //  the gravitational constant
     const double g = 6.67428e-11;
@@ -43,18 +74,12 @@ Moon::Moon(Planet * pOwner, std::string name, double mass, double radius,
     //  calculating orbital period: T = 2*PI*sqrt(a*a*a/(g*M))
     //  where M is the mass of the central object and a is the distance
     double a = distance*distance*distance;
-    double T = 2*PI*sqrt(a/(g*pOwner->GetMass()));
+    double T = 2*PI*sqrt(a/(g*ownerMass));
     //  calculating orbital speed: v = (a*2*PI)/T
     //  where a is the distance and T is the orbital period
     double circumference = distance*2*PI;
     double velocity = circumference/T;
-    //  setting the speed
-    mVelocity = Coordinate(pOwner->GetVelocity().GetX()+velocity,
-                           pOwner->GetVelocity().GetY());
     /*  END Calculate velocity  */
-    //  force starts at neutral
-    mForce = Coordinate(0, 0);
-    mRed = red;
-    mGreen = green;
-    mBlue = blue;
+    //  setting the speed
+    return ownerVelocity + Vec3d(velocity, 0);
 }
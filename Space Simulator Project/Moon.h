@@ -26,5 +26,12 @@ class Moon : public SpaceObject{
     Moon(Planet*, std::string, double, double,
          double,
          float, float, float);
+    /** Member Functions   **/
+    //  returns the position of a moon at the given distance double from
+    //  an owner at the given position coordinate
+    static Vec3d        CalculatePosition(Vec3d, double);
+    //  returns the velocity of a moon at the given distance double from an
+    //  owner with the given velocity coordinate and mass double
+    static Vec3d        CalculateVelocity(Vec3d, double, double);
 };
 #endif
@@ -0,0 +1,156 @@
+/****************************************************************************
+*   FILE: ObjectPool.cpp
+*
+*   FUNCTION: This class hands out memory blocks of one fixed size, carved
+*   from large chunks. A freed block is put on a free list, where the next
+*   allocation takes it from, so once enough chunks are allocated creating
+*   and destroying objects reuses the same memory over and over.
+*
+*   PURPOSE: Creating every object with its own call to the allocator
+*   spreads the objects over the heap and makes spawning many objects wait
+*   on the allocator. Taking them from a few large chunks keeps them close
+*   together in memory and makes an allocation a few instructions.
+*
+*   NOTES: A pool can be used from several threads at once, such as when
+*   objects are created by the drawing thread and freed by the simulation.
+*   The chunks are only given back when the pool is destroyed.
+*
+*   Every new chunk holds as many blocks as all chunks before it together,
+*   so a pool filled one block at a time allocates only a logarithmic
+*   amount of chunks. The blocks of a chunk are put on the free list in
+*   order, so objects created one after another lie next to each other.
+*
+****************************************************************************/
+
+#include "ObjectPool.h"
+#include <new>
+
+//  the least amount of blocks in a chunk
+const int MIN_CHUNK_BLOCKS = 64;
+
+/****************************************************************************
+* Constructors
+*
+****************************************************************************/
+
+/**
+    Name: ObjectPool(size_t)
+    Function: Constructs an empty pool of blocks of the given size, rounded
+    up so that every block can hold a pointer and is aligned for any type.
+    No memory is allocated until the first block is.
+**/
+ObjectPool::ObjectPool(size_t blockSize)
+{
+    const size_t alignment = alignof(max_align_t);
+    if(blockSize < sizeof(void*))
+        blockSize = sizeof(void*);
+    mBlockSize = (blockSize + alignment - 1)/alignment*alignment;
+    mpFree = 0;
+    mUsedCount = 0;
+    mBlockCount = 0;
+}
+
+/**
+    Name: ~ObjectPool()
+    Function: Frees all chunks of the pool.
+**/
+ObjectPool::~ObjectPool()
+{
+    for(unsigned int i = 0; i < mChunks.size(); i++)
+        ::operator delete(mChunks[i]);
+}
+
+/****************************************************************************
+* Member Functions
+*
+****************************************************************************/
+
+/**
+    Name: Allocate()
+    Function: Takes the first block off the free list and returns it. If the
+    list is empty, a chunk as large as all chunks so far is allocated first.
+**/
+void* ObjectPool::Allocate()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if(mpFree == 0)
+        AddChunk(mBlockCount > MIN_CHUNK_BLOCKS ? mBlockCount
+                                                : MIN_CHUNK_BLOCKS);
+    void* pBlock = mpFree;
+    mpFree = *(void**)pBlock;
+    mUsedCount++;
+    return pBlock;
+}
+
+/**
+    Name: Free(void*)
+    Function: Puts the block at the front of the free list, so that the
+    next allocation reuses it while it is still in the cache.
+**/
+void ObjectPool::Free(void* pBlock)
+{
+    if(pBlock == 0)
+        return;
+    std::lock_guard<std::mutex> lock(mMutex);
+    *(void**)pBlock = mpFree;
+    mpFree = pBlock;
+    mUsedCount--;
+}
+
+/**
+    Name: Reserve(int)
+    Function: Allocates a single chunk for all blocks missing to allocate
+    the given amount without another chunk, so that a batch of objects is
+    created from one piece of memory.
+**/
+void ObjectPool::Reserve(int count)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    const int missing = count - (mBlockCount - mUsedCount);
+    if(missing > 0)
+        AddChunk(missing > MIN_CHUNK_BLOCKS ? missing : MIN_CHUNK_BLOCKS);
+}
+
+/**
+    Name: AddChunk(int)
+    Function: Allocates a chunk of the given amount of blocks and links them
+    in front of the free list, from the first to the last.
+**/
+void ObjectPool::AddChunk(int count)
+{
+    char* pChunk = (char*)::operator new(count*mBlockSize);
+    mChunks.push_back(pChunk);
+    for(int i = count - 1; i >= 0; i--)
+    {
+        void* pBlock = pChunk + i*mBlockSize;
+        *(void**)pBlock = mpFree;
+        mpFree = pBlock;
+    }
+    mBlockCount += count;
+}
+
+/****************************************************************************
+* Getters and Setters
+*
+****************************************************************************/
+
+/**
+    Name: GetUsedCount()
+    Function: Returns the amount of blocks allocated and not freed yet.
+**/
+int ObjectPool::GetUsedCount()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mUsedCount;
+}
+
+/**
+    Name: GetBlockCount()
+    Function: Returns the amount of blocks in all chunks together, free or
+    not.
+**/
+int ObjectPool::GetBlockCount()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mBlockCount;
+}
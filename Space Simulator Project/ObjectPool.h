@@ -0,0 +1,69 @@
+/****************************************************************************
+*   FILE: ObjectPool.h
+*
+*   FUNCTION: This class hands out memory blocks of one fixed size, carved
+*   from large chunks. A freed block is put on a free list, where the next
+*   allocation takes it from, so once enough chunks are allocated creating
+*   and destroying objects reuses the same memory over and over.
+*
+*   PURPOSE: Creating every object with its own call to the allocator
+*   spreads the objects over the heap and makes spawning many objects wait
+*   on the allocator. Taking them from a few large chunks keeps them close
+*   together in memory and makes an allocation a few instructions.
+*
+*   NOTES: A pool can be used from several threads at once, such as when
+*   objects are created by the drawing thread and freed by the simulation.
+*   The chunks are only given back when the pool is destroyed.
+*
+****************************************************************************/
+
+#ifndef _ObjectPool_
+#define _ObjectPool_
+
+#include <stddef.h>
+#include <mutex>
+#include <vector>
+
+class ObjectPool{
+    public:
+    /** Constructors    **/
+    //  constructs an empty pool of blocks of the given size in bytes
+    ObjectPool(size_t);
+    //  frees all chunks, every block has to be freed already
+    ~ObjectPool();
+    /** Member Functions   **/
+    //  returns a free block, allocating a new chunk if there is none
+    void*               Allocate();
+    //  puts a block returned by Allocate() back on the free list
+    void                Free(void*);
+    //  makes sure the given amount of blocks can be allocated without
+    //  allocating another chunk
+    void                Reserve(int);
+    /** Getters and Setters **/
+    size_t              GetBlockSize()
+                            {return mBlockSize;}
+    //  the amount of blocks allocated and not freed
+    int                 GetUsedCount();
+    //  the amount of blocks in all chunks together
+    int                 GetBlockCount();
+
+    private:
+    //  the pool owns its chunks and can therefore not be copied
+    ObjectPool(const ObjectPool&);
+    ObjectPool&         operator=(const ObjectPool&);
+    //  allocates a chunk of the given amount of blocks and puts them all on
+    //  the free list
+    void                AddChunk(int);
+
+    /** Class Members   **/
+    size_t              mBlockSize;
+    //  the first free block, which holds the address of the next one
+    void*               mpFree;
+    int                 mUsedCount;
+    int                 mBlockCount;
+    std::vector<char*>  mChunks;
+    //  guards the free list and the counts
+    std::mutex          mMutex;
+};
+
+#endif
@@ -0,0 +1,179 @@
+/****************************************************************************
+*   FILE: Offscreen.cpp
+*
+*   FUNCTION: This class makes an OpenGL context that draws into a buffer in
+*   memory instead of a window, through EGL, and reads the drawn pixels
+*   back.
+*
+*   PURPOSE: Rendering a long run into a movie does not need a window, and
+*   should not need a display server either, so that it can run on the
+*   same machines as the batch runner.
+*
+*   NOTES: Mesa's EGL can draw without any display through its surfaceless
+*   platform and its software rasterizer, which is tried first. Otherwise
+*   the default display of EGL is used.
+*
+*   The context is a compatibility context of desktop OpenGL, since the
+*   scene is drawn with the fixed pipeline where the GL has no shaders.
+*
+****************************************************************************/
+
+#include "Offscreen.h"
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+#include <string.h>
+
+/****************************************************************************
+ * Constructors
+ *
+ ***************************************************************************/
+
+/**
+    Name: Offscreen()
+    Function: Constructs an offscreen target without a display, buffer or
+    context.
+**/
+Offscreen::Offscreen()
+{
+    mDisplay    = EGL_NO_DISPLAY;
+    mSurface    = EGL_NO_SURFACE;
+    mContext    = EGL_NO_CONTEXT;
+    mWidth      = 0;
+    mHeight     = 0;
+}
+
+/**
+    Name: ~Offscreen()
+    Function: Releases the context and destroys it together with the buffer
+    and the connection to the display.
+**/
+Offscreen::~Offscreen()
+{
+    if(mDisplay == EGL_NO_DISPLAY)
+        return;
+    eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                   EGL_NO_CONTEXT);
+    if(mContext != EGL_NO_CONTEXT)
+        eglDestroyContext(mDisplay, mContext);
+    if(mSurface != EGL_NO_SURFACE)
+        eglDestroySurface(mDisplay, mSurface);
+    eglTerminate(mDisplay);
+}
+
+/****************************************************************************
+* Member Functions
+*
+****************************************************************************/
+
+/**
+    Name: Create(int, int, std::string&)
+    Function: Makes a buffer of the given width and height with 8 bits per
+    colour and a depth buffer, a desktop OpenGL context drawing into it,
+    and makes the context current on the calling thread. The viewport is
+    set to the whole buffer. Returns false and the step that failed in the
+    string if any step fails.
+**/
+bool Offscreen::Create(int width, int height, std::string& error)
+{
+    mDisplay = GetDisplay();
+    if(mDisplay == EGL_NO_DISPLAY || !eglInitialize(mDisplay, 0, 0))
+    {
+        mDisplay = EGL_NO_DISPLAY;
+        error = "could not open an EGL display";
+        return false;
+    }
+    const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE,       EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE,    EGL_OPENGL_BIT,
+        EGL_RED_SIZE,           8,
+        EGL_GREEN_SIZE,         8,
+        EGL_BLUE_SIZE,          8,
+        EGL_DEPTH_SIZE,         16,
+        EGL_NONE};
+    EGLConfig config;
+    EGLint configs = 0;
+    if(!eglChooseConfig(mDisplay, configAttributes, &config, 1, &configs) ||
+       configs == 0)
+    {
+        error = "EGL has no buffer for desktop OpenGL";
+        return false;
+    }
+    const EGLint surfaceAttributes[] = {
+        EGL_WIDTH,  width,
+        EGL_HEIGHT, height,
+        EGL_NONE};
+    mSurface = eglCreatePbufferSurface(mDisplay, config, surfaceAttributes);
+    if(mSurface == EGL_NO_SURFACE)
+    {
+        error = "could not make an offscreen buffer of that size";
+        return false;
+    }
+    if(!eglBindAPI(EGL_OPENGL_API))
+    {
+        error = "EGL does not support desktop OpenGL";
+        return false;
+    }
+    mContext = eglCreateContext(mDisplay, config, EGL_NO_CONTEXT, 0);
+    if(mContext == EGL_NO_CONTEXT ||
+       !eglMakeCurrent(mDisplay, mSurface, mSurface, mContext))
+    {
+        error = "could not make an OpenGL context";
+        return false;
+    }
+    mWidth = width;
+    mHeight = height;
+    glViewport(0, 0, width, height);
+    return true;
+}
+
+/**
+    Name: ReadPixels(std::vector<unsigned char>&)
+    Function: Reads the buffer as tightly packed red, green and blue bytes
+    and copies the rows into the vector from the top down, the order image
+    files keep them in. Reading waits for the GL to finish drawing.
+**/
+void Offscreen::ReadPixels(std::vector<unsigned char>& pixels)
+{
+    const int rowBytes = 3*mWidth;
+    mRows.resize(rowBytes*mHeight);
+    pixels.resize(rowBytes*mHeight);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, mWidth, mHeight, GL_RGB, GL_UNSIGNED_BYTE,
+                 &mRows[0]);
+    for(int y = 0; y < mHeight; y++)
+        memcpy(&pixels[y*rowBytes], &mRows[(mHeight - 1 - y)*rowBytes],
+               rowBytes);
+}
+
+/**
+    Name: GetProcAddress(const char*)
+    Function: Returns the address of the GL function with the given name
+    as EGL looks it up.
+**/
+void* Offscreen::GetProcAddress(const char* pName)
+{
+    return (void*)eglGetProcAddress(pName);
+}
+
+/**
+    Name: GetDisplay()
+    Function: Returns Mesa's surfaceless display if EGL has it, which needs
+    no display server, and the default display otherwise.
+**/
+EGLDisplay Offscreen::GetDisplay()
+{
+    PFNEGLGETPLATFORMDISPLAYEXTPROC pGetPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+            eglGetProcAddress("eglGetPlatformDisplayEXT");
+    const char* pExtensions = eglQueryString(EGL_NO_DISPLAY,
+                                             EGL_EXTENSIONS);
+    if(pGetPlatformDisplay != 0 && pExtensions != 0 &&
+       strstr(pExtensions, "EGL_MESA_platform_surfaceless") != 0)
+    {
+        EGLDisplay display = pGetPlatformDisplay(
+            EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, 0);
+        if(display != EGL_NO_DISPLAY)
+            return display;
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
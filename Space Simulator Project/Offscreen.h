@@ -0,0 +1,67 @@
+/****************************************************************************
+*   FILE: Offscreen.h
+*
+*   FUNCTION: This class makes an OpenGL context that draws into a buffer in
+*   memory instead of a window, through EGL, and reads the drawn pixels
+*   back.
+*
+*   PURPOSE: Rendering a long run into a movie does not need a window, and
+*   should not need a display server either, so that it can run on the
+*   same machines as the batch runner.
+*
+*   NOTES: Mesa's EGL can draw without any display through its surfaceless
+*   platform and its software rasterizer, which is tried first. Otherwise
+*   the default display of EGL is used.
+*
+****************************************************************************/
+
+#ifndef _Offscreen_
+#define _Offscreen_
+
+#include <EGL/egl.h>
+#include <string>
+#include <vector>
+
+class Offscreen{
+    public:
+    /** Constructors    **/
+    //  constructs an offscreen target without a context, Create() makes
+    //  one
+    Offscreen();
+    //  destroys the context and the buffer drawn into
+    ~Offscreen();
+    /** Member Functions   **/
+    //  makes a context drawing into a buffer of the given width and height
+    //  and makes it current, returns false with a reason if it fails
+    bool                Create(int, int, std::string&);
+    //  waits for the drawing to finish and reads the buffer into the
+    //  vector as rows of red, green and blue bytes, the top row first
+    void                ReadPixels(std::vector<unsigned char>&);
+    //  returns the address of the GL function with the given name, for
+    //  the context made by Create()
+    static void*        GetProcAddress(const char*);
+    /** Getters and Setters **/
+    int                 GetWidth()
+                            {return mWidth;}
+    int                 GetHeight()
+                            {return mHeight;}
+
+    private:
+    //  the target owns its context and can therefore not be copied
+    Offscreen(const Offscreen&);
+    Offscreen&          operator=(const Offscreen&);
+    //  returns the display to draw with, without a display server if
+    //  EGL can
+    static EGLDisplay   GetDisplay();
+
+    /** Class Members   **/
+    EGLDisplay          mDisplay;
+    EGLSurface          mSurface;
+    EGLContext          mContext;
+    int                 mWidth;
+    int                 mHeight;
+    //  the rows read from the GL, which starts at the bottom row
+    std::vector<unsigned char> mRows;
+};
+
+#endif
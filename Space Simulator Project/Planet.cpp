@@ -20,14 +20,14 @@
  ***************************************************************************/
 
 /**
-    Name: Planet(std::string, double, double, Coordinate, Coordinate,
+    Name: Planet(std::string, double, double, Vec3d, Vec3d,
                  float, float, float)
     Function: Creates a planet with a name string, mass and radius doubles,
     position and velocity coordinates and RGB floats.
 **/
 Planet::Planet(
                std::string name, double mass, double radius,
-               Coordinate position, Coordinate velocity,
+               Vec3d position, Vec3d velocity,
                float red, float green, float blue){
 
     mName           = name;
@@ -36,7 +36,7 @@ Planet::Planet(
     mPosition       = position;
     mVelocity       = velocity;
     //  force starts at neutral
-    mForce          = Coordinate(0, 0);
+    mForce          = Vec3d(0, 0);
     mRed            = red;
     mGreen          = green;
     mBlue           = blue;
@@ -22,7 +22,7 @@ class Planet : public SpaceObject{
     //  constructs a planet with a name string, mass and radius doubles,
     //  position and velociy coordinates and RGB floats
     Planet(std::string, double, double,
-           Coordinate, Coordinate,
+           Vec3d, Vec3d,
            float, float, float);
 };
 #endif
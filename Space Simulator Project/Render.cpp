@@ -0,0 +1,306 @@
+/****************************************************************************
+*   FILE: Render.cpp
+*
+*   FUNCTION: The file containing the main function of the offscreen
+*   renderer. The renderer steps a space like the batch runner and draws
+*   it every given amount of simulated seconds, with the same scene as the
+*   window, into an offscreen buffer, writing every frame to an image or a
+*   raw video stream, as fast as the machine allows.
+*
+*   PURPOSE: Making an animation of a long run with the window application
+*   means watching all of it in real time on a screen. The renderer needs
+*   no window and no display server, and its frames are evenly spaced in
+*   simulated time however long each of them takes to calculate.
+*
+*   USAGE: Render [options]
+*       --frames N      render N frames (default 100)
+*       --every T       simulate T seconds between frames (default 86400)
+*       --dt S          simulate S seconds per step (default 150)
+*       --width W       the width of the frames in pixels (default 800)
+*       --height H      the height of the frames in pixels (default 800)
+*       --scale AU      the astronomical units from the center to the top
+*                       and bottom edges of the frames (default 10)
+*       --tilt DEG      tilt the space away from the viewer (default 0)
+*       --follow NAME   keep the body called NAME in the center (default
+*                       the first body)
+*       --out PREFIX    the start of the file names (default frame)
+*       --format NAME   png, ppm or raw (default png)
+*       --solver NAME   direct or barneshut (default direct)
+*       --threads N     split the direct sum over N threads (default 1)
+*       --integrator NAME
+*                       euler, leapfrog, verlet, yoshida, block or
+*                       wisdomholman (default euler)
+*       --scenario FILE start from the bodies in a scenario file instead
+*                       of the solar system
+*       --load FILE     start from a checkpoint instead of the solar
+*                       system
+*
+****************************************************************************/
+
+#include "Space.h"
+#include "Scenario.h"
+#include "Checkpoint.h"
+#include "Scene.h"
+#include "Offscreen.h"
+#include "FrameWriter.h"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+    Name: PrintUsage()
+    Function: Prints the options of the offscreen renderer.
+**/
+static void PrintUsage()
+{
+    printf("usage: Render [--frames N] [--every T] [--dt S]\n"
+           "              [--width W] [--height H] [--scale AU]\n"
+           "              [--tilt DEG] [--follow NAME]\n"
+           "              [--out PREFIX] [--format png|ppm|raw]\n"
+           "              [--solver direct|barneshut] [--threads N]\n"
+           "              [--integrator euler|leapfrog|verlet|yoshida|"
+           "block|wisdomholman]\n"
+           "              [--scenario FILE] [--load FILE]\n");
+}
+
+/**
+    Name: main(int, char*)
+    Function: Reads the options, creates the space and the offscreen
+    buffer, renders the frames and prints how fast it went.
+**/
+int main(int argc, char* argv[]){
+    /*  START: Read the options */
+    int frames = 100;
+    double interval = 86400;
+    //  the settings below zero are left at their default, or at the value
+    //  in the checkpoint when one is loaded
+    int timeStep = -1;
+    int solver = -1;
+    int integrator = -1;
+    int threads = 1;
+    int width = 800;
+    int height = 800;
+    double scaleAu = 10;
+    double tilt = 0;
+    const char* pFollow = 0;
+    std::string prefix = "frame";
+    FrameFormat format = FRAME_PNG;
+    const char* pScenarioPath = 0;
+    const char* pLoadPath = 0;
+    for(int i = 1; i < argc; i += 2)
+    {
+        //  every option takes a value
+        const char* pValue = i + 1 < argc ? argv[i + 1] : 0;
+        if(pValue == 0)
+        {
+            PrintUsage();
+            return 1;
+        }
+        if(strcmp(argv[i], "--frames") == 0)
+            frames = atoi(pValue);
+        else if(strcmp(argv[i], "--every") == 0)
+            interval = atof(pValue);
+        else if(strcmp(argv[i], "--dt") == 0)
+            timeStep = atoi(pValue);
+        else if(strcmp(argv[i], "--width") == 0)
+            width = atoi(pValue);
+        else if(strcmp(argv[i], "--height") == 0)
+            height = atoi(pValue);
+        else if(strcmp(argv[i], "--scale") == 0)
+            scaleAu = atof(pValue);
+        else if(strcmp(argv[i], "--tilt") == 0)
+            tilt = atof(pValue);
+        else if(strcmp(argv[i], "--follow") == 0)
+            pFollow = pValue;
+        else if(strcmp(argv[i], "--out") == 0)
+            prefix = pValue;
+        else if(strcmp(argv[i], "--format") == 0)
+        {
+            if(strcmp(pValue, "ppm") == 0)
+                format = FRAME_PPM;
+            else if(strcmp(pValue, "raw") == 0)
+                format = FRAME_RAW;
+            else
+                format = FRAME_PNG;
+        }
+        else if(strcmp(argv[i], "--solver") == 0)
+            solver = strcmp(pValue, "barneshut") == 0 ?
+                     GRAVITY_BARNES_HUT : GRAVITY_DIRECT;
+        else if(strcmp(argv[i], "--threads") == 0)
+            threads = atoi(pValue);
+        else if(strcmp(argv[i], "--integrator") == 0)
+        {
+            if(strcmp(pValue, "leapfrog") == 0)
+                integrator = INTEGRATOR_LEAPFROG;
+            else if(strcmp(pValue, "verlet") == 0)
+                integrator = INTEGRATOR_VELOCITY_VERLET;
+            else if(strcmp(pValue, "yoshida") == 0)
+                integrator = INTEGRATOR_YOSHIDA;
+            else if(strcmp(pValue, "block") == 0)
+                integrator = INTEGRATOR_BLOCK_TIMESTEP;
+            else if(strcmp(pValue, "wisdomholman") == 0)
+                integrator = INTEGRATOR_WISDOM_HOLMAN;
+            else
+                integrator = INTEGRATOR_EULER;
+        }
+        else if(strcmp(argv[i], "--scenario") == 0)
+            pScenarioPath = pValue;
+        else if(strcmp(argv[i], "--load") == 0)
+            pLoadPath = pValue;
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+    if(timeStep == 0 || timeStep < -1 || frames <= 0 || interval <= 0 ||
+       width <= 0 || height <= 0 || scaleAu <= 0)
+    {
+        PrintUsage();
+        return 1;
+    }
+    //  the report goes to the error stream while the frames go to the
+    //  standard output
+    FILE* pReport = format == FRAME_RAW && prefix == "-" ? stderr : stdout;
+    /*  END: Read the options   */
+
+    /*  START: Create the universe   */
+    Space space(timeStep > 0 ? timeStep : 150);
+    std::string error;
+    if(pLoadPath != 0)
+    {
+        if(!Checkpoint::Load(space, pLoadPath))
+        {
+            fprintf(pReport, "could not load %s\n", pLoadPath);
+            return 1;
+        }
+    }
+    else if(pScenarioPath != 0)
+    {
+        if(!Scenario::Load(space, pScenarioPath, error))
+        {
+            fprintf(pReport, "%s\n", error.c_str());
+            return 1;
+        }
+    }
+    else
+    {
+        Scenario::CreateSolarSystem(space);
+    }
+    if(timeStep > 0)
+        space.SetTime(timeStep);
+    timeStep = space.GetTime();
+    if(solver >= 0)
+        space.SetGravitySolver((GravitySolver)solver);
+    space.SetThreadCount(threads);
+    //  setting the integrator again would throw away a loaded state
+    if(integrator >= 0 && integrator != space.GetIntegratorType())
+        space.SetIntegrator((IntegratorType)integrator);
+    //  the frames are a whole amount of steps apart
+    long long stepsPerFrame = (long long)(interval/timeStep + 0.5);
+    if(stepsPerFrame < 1)
+        stepsPerFrame = 1;
+    /*  END: Create the universe */
+
+    /*  START: Set up the scene */
+    Offscreen offscreen;
+    if(!offscreen.Create(width, height, error))
+    {
+        fprintf(pReport, "%s\n", error.c_str());
+        return 1;
+    }
+    Scene scene;
+    scene.Init(Offscreen::GetProcAddress);
+    scene.SetScale(scaleAu);
+    scene.SetTilt(tilt);
+    if(pFollow != 0)
+    {
+        BodyStore& store = space.GetBodies();
+        const int follow = store.Find(pFollow);
+        if(follow == -1)
+        {
+            fprintf(pReport, "there is no body called %s\n", pFollow);
+            return 1;
+        }
+        scene.SetLookAt(store.GetHandle(follow));
+    }
+    FrameWriter writer;
+    if(!writer.Open(prefix, format, width, height))
+    {
+        fprintf(pReport, "could not open %s\n",
+                writer.GetFileName().c_str());
+        return 1;
+    }
+    /*  END: Set up the scene   */
+
+    /*  START: Render the frames    */
+    Snapshot snapshot;
+    std::vector<unsigned char> pixels;
+    double stepSeconds = 0;
+    double drawSeconds = 0;
+    double writeSeconds = 0;
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    for(int frame = 0; frame < frames; frame++)
+    {
+        //  the first frame shows the space as it starts
+        std::chrono::steady_clock::time_point stepped =
+            std::chrono::steady_clock::now();
+        if(frame > 0)
+        {
+            for(long long step = 0; step < stepsPerFrame; step++)
+                space.Step();
+            stepped = std::chrono::steady_clock::now();
+        }
+        Simulation::TakeSnapshot(space, snapshot);
+        snapshot.time = (double)frame*stepsPerFrame*timeStep;
+        scene.Render(snapshot);
+        offscreen.ReadPixels(pixels);
+        std::chrono::steady_clock::time_point drawn =
+            std::chrono::steady_clock::now();
+        if(!writer.Write(&pixels[0]))
+        {
+            fprintf(pReport, "could not write frame %d to %s\n", frame,
+                    writer.GetFileName().c_str());
+            return 1;
+        }
+        std::chrono::steady_clock::time_point written =
+            std::chrono::steady_clock::now();
+        stepSeconds += std::chrono::duration<double>(stepped -
+                                                     start).count();
+        drawSeconds += std::chrono::duration<double>(drawn -
+                                                     stepped).count();
+        writeSeconds += std::chrono::duration<double>(written -
+                                                      drawn).count();
+        start = written;
+    }
+    if(!writer.Close())
+    {
+        fprintf(pReport, "could not write %s\n",
+                writer.GetFileName().c_str());
+        return 1;
+    }
+    /*  END: Render the frames  */
+
+    /*  START: Report   */
+    const double seconds = stepSeconds + drawSeconds + writeSeconds;
+    fprintf(pReport, "bodies:                  %d\n",
+            space.GetBodies().GetCount());
+    fprintf(pReport, "frames:                  %lld of %dx%d\n",
+            writer.GetFrames(), width, height);
+    fprintf(pReport, "steps per frame:         %lld\n", stepsPerFrame);
+    fprintf(pReport, "simulated seconds:       %.6g\n",
+            (double)(frames - 1)*stepsPerFrame*timeStep);
+    fprintf(pReport, "bytes written:           %lld\n",
+            writer.GetWrittenBytes());
+    fprintf(pReport, "wall seconds:            %.6g\n", seconds);
+    fprintf(pReport, "  stepping:              %.6g\n", stepSeconds);
+    fprintf(pReport, "  drawing:               %.6g\n", drawSeconds);
+    fprintf(pReport, "  writing:               %.6g\n", writeSeconds);
+    fprintf(pReport, "frames per second:       %.6g\n",
+            seconds > 0 ? frames/seconds : 0.0);
+    /*  END: Report */
+    return 0;
+}
@@ -0,0 +1,512 @@
+/****************************************************************************
+*   FILE: Scenario.cpp
+*
+*   FUNCTION: This class fills a space with a ready-made set of objects, or
+*   with the bodies described in a scenario file.
+*
+*   PURPOSE: Keeping the creation of the universe apart from the main
+*   function lets both the window application and the batch runner start
+*   from the same objects. Scenario files let any universe be run without
+*   changing the code. They are parsed in parallel pieces and the bodies
+*   go straight into the body store, without an object of their own, so
+*   that files of millions of bodies load about as fast as they are read.
+*
+*   FORMAT: A scenario file is text, one statement per line. Everything
+*   after a '#' is a comment. Names cannot contain spaces. Masses are in
+*   kilograms, distances in meters and speeds in meters per second, while
+*   the radius and the red, green and blue colour are as drawn.
+*       time SECONDS
+*       star NAME MASS RADIUS X Y VX VY RED GREEN BLUE
+*       planet NAME MASS RADIUS X Y VX VY RED GREEN BLUE
+*       star NAME MASS RADIUS X Y Z VX VY VZ RED GREEN BLUE
+*       planet NAME MASS RADIUS X Y Z VX VY VZ RED GREEN BLUE
+*       moon NAME OWNER MASS RADIUS DISTANCE RED GREEN BLUE
+*   A star or planet given without Z and VZ lies in the plane. Like the
+*   Moon class, a moon is placed at the given distance from the planet
+*   named as its owner, which can be anywhere in the file, and orbits it
+*   in a circle at the owner's height.
+*
+****************************************************************************/
+
+#include "Scenario.h"
+#include "ThreadPool.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <unordered_map>
+
+//  a file is only split into pieces of at least this many bytes
+const size_t MIN_PIECE_SIZE = 1 << 16;
+//  the powers of ten that are exact as doubles
+const double EXACT_POWERS[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8,
+                               1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                               1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+//  the bodies parsed from one piece of a scenario file
+struct ScenarioPiece{
+    //  the start and end of the piece in the file
+    const char*         pBegin;
+    const char*         pEnd;
+    BodyStore           bodies;
+    //  the index of every moon in the bodies, with its owner and distance
+    std::vector<int>    moons;
+    std::vector<std::string> owners;
+    std::vector<double> distances;
+    //  the last time statement of the piece, 0 if there is none
+    int                 time;
+    int                 lineCount;
+    //  the line of the first error within the piece, 0 if there is none
+    int                 errorLine;
+    std::string         error;
+};
+
+/**
+    Name: SkipSpace(const char*&)
+    Function: Moves past spaces and tabs and returns true if the line
+    holds anything more.
+**/
+static bool SkipSpace(const char*& p)
+{
+    while(*p == ' ' || *p == '\t' || *p == '\r')
+        p++;
+    return *p != '\n' && *p != '\0' && *p != '#';
+}
+
+/**
+    Name: ReadWord(const char*&, std::string&)
+    Function: Reads the next word on the line into the string, returns
+    false if the line ended.
+**/
+static bool ReadWord(const char*& p, std::string& word)
+{
+    if(!SkipSpace(p))
+        return false;
+    const char* pStart = p;
+    while(*p != ' ' && *p != '\t' && *p != '\r' && *p != '\n' &&
+          *p != '\0' && *p != '#')
+        p++;
+    word.assign(pStart, p - pStart);
+    return true;
+}
+
+/**
+    Name: ParseNumber(const char*, char**)
+    Function: Does the same as strtod, only faster for the numbers most
+    files hold. When the digits fit in 53 bits and the power of ten is
+    exact as a double, one multiplication or division gives the correctly
+    rounded result. Anything else is left to strtod.
+**/
+static double ParseNumber(const char* pText, char** ppEnd)
+{
+    const char* p = pText;
+    bool negative = *p == '-';
+    if(*p == '-' || *p == '+')
+        p++;
+    unsigned long long digits = 0;
+    int digitCount = 0;
+    int exponent = 0;
+    for(; *p >= '0' && *p <= '9'; p++, digitCount++)
+        digits = digits*10 + (*p - '0');
+    if(*p == '.')
+    {
+        for(p++; *p >= '0' && *p <= '9'; p++, digitCount++, exponent--)
+            digits = digits*10 + (*p - '0');
+    }
+    //  no digits at all, or too many to have been counted exactly
+    if(digitCount == 0 || digitCount > 19)
+        return strtod(pText, ppEnd);
+    if(*p == 'e' || *p == 'E')
+    {
+        const char* pExponent = p + 1;
+        bool negativeExponent = *pExponent == '-';
+        if(*pExponent == '-' || *pExponent == '+')
+            pExponent++;
+        if(*pExponent < '0' || *pExponent > '9')
+            return strtod(pText, ppEnd);
+        int value = 0;
+        for(; *pExponent >= '0' && *pExponent <= '9' && value < 10000;
+            pExponent++)
+            value = value*10 + (*pExponent - '0');
+        exponent += negativeExponent ? -value : value;
+        p = pExponent;
+    }
+    //  anything else right after the number, such as hexadecimal digits
+    bool ended = !((*p >= '0' && *p <= '9') || (*p >= 'a' && *p <= 'z') ||
+                   (*p >= 'A' && *p <= 'Z') || *p == '.');
+    if(!ended || digits >= (1ULL << 53) || exponent < -22 || exponent > 22)
+        return strtod(pText, ppEnd);
+    double number = (double)digits;
+    if(exponent < 0)
+        number /= EXACT_POWERS[-exponent];
+    else
+        number *= EXACT_POWERS[exponent];
+    *ppEnd = (char*)p;
+    return negative ? -number : number;
+}
+
+/**
+    Name: ReadNumbers(const char*&, double*, int)
+    Function: Reads the given amount of numbers on the line into the array,
+    returns false if the line ended early or a word is not a number.
+**/
+static bool ReadNumbers(const char*& p, double* pNumbers, int count)
+{
+    for(int i = 0; i < count; i++)
+    {
+        if(!SkipSpace(p))
+            return false;
+        char* pEnd;
+        pNumbers[i] = ParseNumber(p, &pEnd);
+        if(pEnd == p || (*pEnd != ' ' && *pEnd != '\t' && *pEnd != '\r' &&
+                         *pEnd != '\n' && *pEnd != '\0' && *pEnd != '#'))
+            return false;
+        p = pEnd;
+    }
+    return true;
+}
+
+/**
+    Name: ParsePiece(ScenarioPiece&)
+    Function: Parses every line of the piece into its body store. Moons
+    only get their state once all pieces are parsed, since their owner may
+    be in another piece. Stops at the first error.
+**/
+static void ParsePiece(ScenarioPiece& piece)
+{
+    std::string word;
+    BodyInfo info;
+    info.lightSource = 0;
+    info.pObject = 0;
+    double numbers[11];
+    const char* p = piece.pBegin;
+    while(p < piece.pEnd)
+    {
+        piece.lineCount++;
+        const char* pLine = p;
+        /*  START: Parse the line   */
+        bool valid = true;
+        if(ReadWord(p, word))
+        {
+            if(word == "time")
+            {
+                //  the seconds per step are kept in an int
+                valid = ReadNumbers(p, numbers, 1) && numbers[0] >= 1 &&
+                        numbers[0] <= INT_MAX;
+                if(valid)
+                    piece.time = (int)numbers[0];
+            }
+            else if(word == "star" || word == "planet")
+            {
+                info.type = word == "star" ? BODY_STAR : BODY_PLANET;
+                valid = ReadWord(p, info.name) &&
+                        ReadNumbers(p, numbers, 9);
+                //  two more numbers give the body a z and vz
+                bool depth = valid && SkipSpace(p);
+                if(depth)
+                    valid = ReadNumbers(p, numbers + 9, 2);
+                Vec3d position(numbers[2], numbers[3]);
+                Vec3d velocity(numbers[4], numbers[5]);
+                const double* pColour = numbers + 6;
+                if(depth)
+                {
+                    position = Vec3d(numbers[2], numbers[3], numbers[4]);
+                    velocity = Vec3d(numbers[5], numbers[6], numbers[7]);
+                    pColour = numbers + 8;
+                }
+                info.radius = numbers[1];
+                info.red    = pColour[0];
+                info.green  = pColour[1];
+                info.blue   = pColour[2];
+                if(valid)
+                    piece.bodies.Add(info, position, velocity, numbers[0]);
+            }
+            else if(word == "moon")
+            {
+                info.type = BODY_MOON;
+                valid = ReadWord(p, info.name) && ReadWord(p, word) &&
+                        ReadNumbers(p, numbers, 6);
+                info.radius = numbers[1];
+                info.red    = numbers[3];
+                info.green  = numbers[4];
+                info.blue   = numbers[5];
+                if(valid)
+                {
+                    //  the state is filled in once the owner is known
+                    piece.moons.push_back(piece.bodies.Add(info,
+                        Vec3d(0, 0), Vec3d(0, 0), numbers[0]));
+                    piece.owners.push_back(word);
+                    piece.distances.push_back(numbers[2]);
+                }
+            }
+            else
+            {
+                valid = false;
+            }
+        }
+        /*  END: Parse the line */
+        //  anything but a comment after the statement is an error
+        valid = valid && !SkipSpace(p);
+        if(!valid)
+        {
+            piece.errorLine = piece.lineCount;
+            piece.error.assign(pLine, strcspn(pLine, "\r\n"));
+            return;
+        }
+        while(p < piece.pEnd && *p != '\n')
+            p++;
+        p++;
+    }
+}
+
+/**
+    Name: ReadFile(const std::string&, std::vector<char>&)
+    Function: Reads the whole file named by the string into the vector in
+    one go, ended by a zero, returns false if it could not be read.
+**/
+static bool ReadFile(const std::string& path, std::vector<char>& text)
+{
+    FILE* pFile = fopen(path.c_str(), "rb");
+    if(pFile == 0)
+        return false;
+    bool read = fseek(pFile, 0, SEEK_END) == 0;
+    long size = read ? ftell(pFile) : -1;
+    read = size >= 0 && fseek(pFile, 0, SEEK_SET) == 0;
+    if(read)
+    {
+        text.resize(size + 1);
+        read = fread(&text[0], 1, size, pFile) == (size_t)size;
+        text[size] = '\0';
+    }
+    fclose(pFile);
+    return read;
+}
+
+/****************************************************************************
+* Member Functions
+*
+****************************************************************************/
+
+/**
+    Name: CreateSolarSystem(Space&)
+    Function: Adds the sun, the planets of the solar system and two moons to
+    the argument space. More objects can be created here by following the
+    same steps: first create an object and then add it to the space.
+**/
+void Scenario::CreateSolarSystem(Space& space)
+{
+    /*  START: Declare objects  */
+    Star* sun =         new Star("Sun", //name
+                                 1.9891e30, //mass
+                                 0.025,   //radius
+                                 Vec3d(0, 0), //position
+                                 Vec3d(0, 0), //velocity
+                                 1.00, 1.00, 0.00); //rgb colour
+    Planet* mercury =   new Planet("Mercury", //name
+                                   6.083e10, //mass
+                                   0.0125, //radius
+                                   Vec3d(5790906e4, 0), //position
+                                   Vec3d(0, 47870), //velocity
+                                   0.6, 0.6, 0.6); //rgb colour
+    Planet* venus =     new Planet("Venus", 4.8685e24, 0.0125,
+                                   Vec3d(1082089e5, 0),
+                                   Vec3d(0, 35020),
+                                   1.0, 0.5, 0.5);
+    Planet* earth =     new Planet("Earth", 5.9736e24, 0.0125,
+                                   Vec3d(149598261e3,  0),
+                                   Vec3d(0, 29783),
+                                   0, 1.0, 0);
+    Planet* mars =      new Planet("Mars", 4.185e23, 0.0125 ,
+                                   Vec3d(227939100e3, 0),
+                                   Vec3d(0, 24077),
+                                   1.0, 0, 0);
+    Planet* jupiter =   new Planet("Jupiter",1.8986e27, 0.0125,
+                                   Vec3d(778547200e3, 0),
+                                   Vec3d(0, 13.07e3),
+                                   0.8 ,0.4 ,0);
+    Planet* saturn =    new Planet("Saturn",8.2713e14, 0.0125,
+                                   Vec3d(1433449370e3, 0),
+                                   Vec3d(0, 9.69e3),
+                                   0.7, 0.5, 0);
+    Planet* uranus =    new Planet("Uranus",8.6810e25, 0.0125,
+                                   Vec3d(2876679082e3, 0),
+                                   Vec3d(0, 6.81e3),
+                                   0, 0, 0.8);
+    Planet* neptune =   new Planet("Neptune", 1.0243e26, 0.0125,
+                                   Vec3d(4452940833e3, 0),
+                                   Vec3d(0, 5.43e3),
+                                   0, 0, 1.0);
+    Moon* moon =        new Moon(earth, //"owner" planet
+                                 "Moon", //name
+                                 7.3477e22,  //mass
+                                 0.00625,   //radius
+                                 384399e3, //distance from owner
+                                 0.8, 0.8, 0.8); //rgb colour
+    Moon* mJupiter =    new Moon(jupiter, "Moon", 7.3477e22,
+                                 0.00625, 184399e4, 0.8, 0.8, 0.8);
+
+    /*  END: Declaration of objects */
+    /*  START: Add objects to space */
+    space.AddObjectToSpace(sun);
+    space.AddObjectToSpace(mercury);
+    space.AddObjectToSpace(venus);
+    space.AddObjectToSpace(earth);
+    space.AddObjectToSpace(moon);
+    space.AddObjectToSpace(mars);
+    space.AddObjectToSpace(jupiter);
+    space.AddObjectToSpace(mJupiter);
+    space.AddObjectToSpace(saturn);
+    space.AddObjectToSpace(uranus);
+    space.AddObjectToSpace(neptune);
+    /*  END: Add objects to space   */
+}
+
+/**
+    Name: Load(Space&, const std::string&, std::string&)
+    Function: Reads the whole scenario file and splits it into a piece per
+    thread at line ends. Every piece is parsed into a body store of its own
+    on a thread of a pool. The stores are then moved into the space one
+    after the other, each in one go, and the moons are placed around their
+    owners. The space is only changed once the whole file was parsed
+    without errors.
+**/
+bool Scenario::Load(Space& space, const std::string& path,
+                    std::string& error)
+{
+    error.clear();
+    std::vector<char> text;
+    if(!ReadFile(path, text))
+    {
+        error = "could not read " + path;
+        return false;
+    }
+    /*  START: Split the file into pieces  */
+    const char* pText = &text[0];
+    const char* pTextEnd = pText + text.size() - 1;
+    int threads = std::thread::hardware_concurrency();
+    if(threads < 1)
+        threads = 1;
+    size_t pieceSize = (text.size() + threads - 1)/threads;
+    if(pieceSize < MIN_PIECE_SIZE)
+        pieceSize = MIN_PIECE_SIZE;
+    std::vector<ScenarioPiece*> pieces;
+    const char* p = pText;
+    while(p < pTextEnd)
+    {
+        ScenarioPiece* pPiece = new ScenarioPiece();
+        pPiece->pBegin = p;
+        p = (size_t)(pTextEnd - p) > pieceSize ? p + pieceSize : pTextEnd;
+        //  end the piece right after a line
+        while(p < pTextEnd && p[-1] != '\n')
+            p++;
+        pPiece->pEnd = p;
+        pPiece->time = 0;
+        pPiece->lineCount = 0;
+        pPiece->errorLine = 0;
+        pieces.push_back(pPiece);
+    }
+    /*  END: Split the file into pieces    */
+    /*  START: Parse the pieces  */
+    if(pieces.size() > 1)
+    {
+        ThreadPool pool(pieces.size());
+        pool.Run([&pieces](int index){
+            ParsePiece(*pieces[index]);
+        });
+    }
+    else if(pieces.size() == 1)
+    {
+        ParsePiece(*pieces[0]);
+    }
+    int time = 0;
+    int lines = 0;
+    for(size_t i = 0; i < pieces.size() && error.empty(); i++)
+    {
+        if(pieces[i]->errorLine != 0)
+        {
+            char line[32];
+            snprintf(line, sizeof(line), "%d",
+                     lines + pieces[i]->errorLine);
+            error = path + ":" + line + ": cannot read \"" +
+                    pieces[i]->error + "\"";
+        }
+        lines += pieces[i]->lineCount;
+        if(pieces[i]->time != 0)
+            time = pieces[i]->time;
+    }
+    /*  END: Parse the pieces    */
+    /*  START: Find the owner of every moon    */
+    //  only the names of owners are looked up, there are few of them
+    std::unordered_map<std::string, int> planets;
+    for(size_t i = 0; i < pieces.size() && error.empty(); i++)
+    {
+        for(size_t j = 0; j < pieces[i]->owners.size(); j++)
+            planets[pieces[i]->owners[j]] = -1;
+    }
+    int first = 0;
+    for(size_t i = 0; i < pieces.size() && !planets.empty(); i++)
+    {
+        BodyStore& bodies = pieces[i]->bodies;
+        for(int j = 0; j < bodies.GetCount(); j++)
+        {
+            if(bodies.GetInfo(j).type != BODY_PLANET)
+                continue;
+            std::unordered_map<std::string, int>::iterator planet =
+                planets.find(bodies.GetInfo(j).name);
+            //  the first planet of a name owns the moons
+            if(planet != planets.end() && planet->second < 0)
+                planet->second = first + j;
+        }
+        first += bodies.GetCount();
+    }
+    std::vector<int> moons;
+    std::vector<int> owners;
+    std::vector<double> distances;
+    first = 0;
+    for(size_t i = 0; i < pieces.size() && error.empty(); i++)
+    {
+        ScenarioPiece& piece = *pieces[i];
+        for(size_t j = 0; j < piece.moons.size() && error.empty(); j++)
+        {
+            std::unordered_map<std::string, int>::iterator owner =
+                planets.find(piece.owners[j]);
+            if(owner->second < 0)
+            {
+                error = path + ": the owner " + piece.owners[j] +
+                        " of the moon " +
+                        piece.bodies.GetInfo(piece.moons[j]).name +
+                        " is not a planet";
+                break;
+            }
+            moons.push_back(first + piece.moons[j]);
+            owners.push_back(owner->second);
+            distances.push_back(piece.distances[j]);
+        }
+        first += piece.bodies.GetCount();
+    }
+    /*  END: Find the owner of every moon  */
+    /*  START: Move the bodies into the space  */
+    if(error.empty())
+    {
+        space.ClearObjects();
+        if(time != 0)
+            space.SetTime(time);
+        space.ReserveObjects(first);
+        for(size_t i = 0; i < pieces.size(); i++)
+            space.AddBodies(pieces[i]->bodies);
+        BodyStore& bodies = space.GetBodies();
+        for(size_t i = 0; i < moons.size(); i++)
+        {
+            bodies.SetPosition(moons[i], Moon::CalculatePosition(
+                bodies.GetPosition(owners[i]), distances[i]));
+            bodies.SetVelocity(moons[i], Moon::CalculateVelocity(
+                bodies.GetVelocity(owners[i]), bodies.GetMass()[owners[i]],
+                distances[i]));
+        }
+    }
+    /*  END: Move the bodies into the space    */
+    for(size_t i = 0; i < pieces.size(); i++)
+        delete pieces[i];
+    return error.empty();
+}
@@ -0,0 +1,48 @@
+/****************************************************************************
+*   FILE: Scenario.h
+*
+*   FUNCTION: This class fills a space with a ready-made set of objects, or
+*   with the bodies described in a scenario file.
+*
+*   PURPOSE: Keeping the creation of the universe apart from the main
+*   function lets both the window application and the batch runner start
+*   from the same objects. Scenario files let any universe be run without
+*   changing the code. They are parsed in parallel pieces and the bodies
+*   go straight into the body store, without an object of their own, so
+*   that files of millions of bodies load about as fast as they are read.
+*
+*   FORMAT: A scenario file is text, one statement per line. Everything
+*   after a '#' is a comment. Names cannot contain spaces. Masses are in
+*   kilograms, distances in meters and speeds in meters per second, while
+*   the radius and the red, green and blue colour are as drawn.
+*       time SECONDS
+*       star NAME MASS RADIUS X Y VX VY RED GREEN BLUE
+*       planet NAME MASS RADIUS X Y VX VY RED GREEN BLUE
+*       star NAME MASS RADIUS X Y Z VX VY VZ RED GREEN BLUE
+*       planet NAME MASS RADIUS X Y Z VX VY VZ RED GREEN BLUE
+*       moon NAME OWNER MASS RADIUS DISTANCE RED GREEN BLUE
+*   A star or planet given without Z and VZ lies in the plane. Like the
+*   Moon class, a moon is placed at the given distance from the planet
+*   named as its owner, which can be anywhere in the file, and orbits it
+*   in a circle at the owner's height.
+*
+****************************************************************************/
+
+#ifndef _Scenario_
+#define _Scenario_
+
+#include "Space.h"
+#include <string>
+
+class Scenario{
+    public:
+    /** Member Functions   **/
+    //  adds the sun, the planets and two moons to the argument space
+    static void         CreateSolarSystem(Space&);
+    //  replaces the objects in the argument space with the bodies in the
+    //  scenario file named by the first string and takes over its time,
+    //  or returns false and puts the reason in the second string
+    static bool         Load(Space&, const std::string&, std::string&);
+};
+
+#endif
@@ -0,0 +1,434 @@
+/****************************************************************************
+*   FILE: Scene.cpp
+*
+*   FUNCTION: This class draws a snapshot of a space with OpenGL: the stars,
+*   planets and moons in it as lit spheres, seen from above the followed
+*   body at a scale and tilt. It only needs a current GL context, and does
+*   not know where the context comes from.
+*
+*   PURPOSE: Keeping the drawing of the space apart from GLUT lets the same
+*   scene be drawn into a window, where Draw adds the user input, and into
+*   an offscreen context without any display, where the frames are written
+*   to files.
+*
+*   NOTES: The scale, tilt and followed body can be changed between frames.
+*   The followed body is kept by its handle, so it stays followed while
+*   bodies are added and removed, and the first body is followed when it
+*   is gone.
+*
+****************************************************************************/
+
+#include "Scene.h"
+#include <math.h>
+
+//  the degrees in a radian
+const double DEGREES_PER_RADIAN = 57.2957795130823;
+
+/****************************************************************************
+ * Constructors
+ *
+ ***************************************************************************/
+
+/**
+    Name: Scene()
+    Function: Constructs a scene looking at the first body, untilted, with
+    one astronomical unit from the center to the top and bottom edges of
+    the view.
+**/
+Scene::Scene()
+{
+    mpSnapshot      = 0;
+    mScaleAu        = 1;
+    mLookAt         = NO_BODY;
+    mTilt           = 0;
+    mAspect         = 1;
+}
+
+/****************************************************************************
+* Member Functions
+*
+****************************************************************************/
+
+/**
+    Name: Init(GlProcLoader)
+    Function: Sets up the material and light variables to be used when
+    drawing in the current GL context, and makes the spheres, looking the
+    functions beyond OpenGL 1.1 up with the argument loader.
+**/
+void Scene::Init(GlProcLoader loader)
+{
+    //  enable lighting
+    const GLfloat lightAmbient[]  = {0.0, 0.0, 0.0, 1.0};
+    const GLfloat lightDiffuse[]  = {1.0, 1.0, 1.0, 1.0};
+
+    //  enable materials
+    glEnable(GL_COLOR_MATERIAL);
+    //  enable lighting
+    glEnable(GL_LIGHTING);
+
+    /*  START: Set up the light sources of the suns   */
+    //  the light sources are turned on and off every frame, depending on
+    //  the stars in the snapshot
+    for(int i = 0; i < 8; i++)
+    {
+        //  specify ambient lighting
+        glLightfv(GL_LIGHT0 + i, GL_AMBIENT,  lightAmbient);
+        //  specify diffuse lighting
+        glLightfv(GL_LIGHT0 + i, GL_DIFFUSE,  lightDiffuse);
+    }
+    /*  END: Set up the light sources of the suns  */
+
+    /*  START: Set materials    */
+    const GLfloat matAmbient[]    = {0.7, 0.7, 0.7, 1.0};
+    const GLfloat matDiffuse[]    = {0.8, 0.8, 0.8, 1.0};
+    const GLfloat highShininess[] = {50.0};
+
+    //  specify material ambient properties
+    glMaterialfv(GL_FRONT, GL_AMBIENT,   matAmbient);
+    //  specify diffuse properties
+    glMaterialfv(GL_FRONT, GL_DIFFUSE,   matDiffuse);
+    //  specify shininess
+    glMaterialfv(GL_FRONT, GL_SHININESS, highShininess);
+    /*  END: Set materials  */
+    //  bodies in front hide the ones behind them, whatever their type
+    glEnable(GL_DEPTH_TEST);
+    //  the spheres are made once and scaled to every body, which needs the
+    //  normals made unit length again for the lighting
+    mSpheres.Init(loader);
+    glEnable(GL_NORMALIZE);
+}
+
+/**
+    Name: Render(const Snapshot&)
+    Function: Draws all objects in the snapshot into the current viewport,
+    looking at the followed object. The view is orthographic and deep
+    enough for bodies far in front of and behind the followed object, and
+    the space is tilted around the x-axis by the chosen angle so that the
+    heights of the bodies can be seen. The scale reaches from the center to
+    the top and bottom edges, and the sides are as far as the width of the
+    viewport over its height, so that circles stay round in any frame.
+**/
+void Scene::Render(const Snapshot& snapshot)
+{
+    mpSnapshot = &snapshot;
+    const std::vector<SnapshotBody>& bodies = mpSnapshot->bodies;
+    //  the followed object may have been removed since the last frame,
+    //  then the first one is followed
+    int lookAt = FindBody(mLookAt);
+    if(lookAt == -1 && !bodies.empty())
+    {
+        lookAt = 0;
+        mLookAt = bodies[0].handle;
+    }
+    //  the window shows one scale unit up and down, as many as its aspect
+    //  to the sides and a hundred in depth
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    mAspect = viewport[3] > 0 ? (double)viewport[2]/viewport[3] : 1.0;
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho(-mAspect, mAspect, -1.0, 1.0, -100.0, 100.0);
+    glMatrixMode(GL_MODELVIEW);
+    //  set the matrix to default
+    glLoadIdentity();
+    //  tilt the space around the followed object
+    glRotated(-mTilt, 1.0, 0.0, 0.0);
+    if(!bodies.empty())
+    {
+        const SnapshotBody& focus = bodies[lookAt];
+        glTranslated(-ToScale(focus.x), -ToScale(focus.y),
+                     -ToScale(focus.z));
+    }
+    EnableLights();
+    //  clear the window
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    mSpheres.Begin();
+    CullBodies(lookAt);
+    if(mSpheres.IsInstanced())
+    {
+        DrawInstanced();
+    }
+    else
+    {
+        DrawStars();
+        DrawPlanets();
+        DrawMoons();
+    }
+    //  draws the instanced spheres and the bodies less than a pixel wide
+    mSpheres.End();
+}
+
+/**
+    Name: DrawSphere(Vec3d, double)
+    Function: Draws a sphere using the arguments radius(in screen percentage)
+    and a position coordinate(that is being scaled to screen percentages
+    within the function). The sphere of the level of detail fitting its
+    size on screen is drawn scaled to the radius.
+**/
+void Scene::DrawSphere(Vec3d position, double radius)
+{
+    //  start new state
+    glPushMatrix();
+    //  set the position of the object
+    glTranslated(ToScale(position.GetX()), ToScale(position.GetY()),
+                 ToScale(position.GetZ()));
+    //  draw object
+    glScaled(radius, radius, radius);
+    mSpheres.DrawMesh(mSpheres.ChooseLevel(radius));
+    //  go back to previous state
+    glPopMatrix();
+}
+
+/**
+    Name: DrawLighting(int)
+    Function: Draws lighting on the body at the argument index in the
+    snapshot. A star is lit from its own center, all other bodies are lit
+    from all the stars in the snapshot.
+**/
+void Scene::DrawLighting(int index)
+{
+    const std::vector<SnapshotBody>& bodies = mpSnapshot->bodies;
+    if(bodies[index].type == BODY_STAR)
+    {
+        //  draws light positioned at the center of the star
+        float gLightPosition[] = {0.0, 0.0, 1.0, 1.0};
+        glLightfv(GL_LIGHT0, GL_POSITION, gLightPosition);
+        return;
+    }
+    const std::vector<int>& stars = mpSnapshot->ofType[BODY_STAR];
+    //  iterate through the stars in the snapshot
+    for(unsigned int i = 0; i < stars.size(); i++)
+    {
+        const SnapshotBody& star = bodies[stars[i]];
+        if(!star.lightSource)
+            continue;
+        //  calculate difference in x-axis
+        float x = star.x - bodies[index].x;
+        //  calculate difference in y-axis
+        float y = star.y - bodies[index].y;
+        //  calculate difference in z-axis
+        float z = star.z - bodies[index].z;
+        //  set the light position towards the star
+        float gLightPosition[] = {x, y, z + 1.0f, 1.0};
+        glLightfv(star.lightSource, GL_POSITION, gLightPosition);
+    }
+}
+
+/**
+    Name: EnableLights()
+    Function: Turns on the light source of every star in the snapshot and
+    turns off the light sources no star uses, so that stars added or removed
+    by the simulation light up or go dark on the next frame.
+**/
+void Scene::EnableLights()
+{
+    const std::vector<SnapshotBody>& bodies = mpSnapshot->bodies;
+    const std::vector<int>& stars = mpSnapshot->ofType[BODY_STAR];
+    for(int i = 0; i < 8; i++)
+    {
+        bool used = false;
+        for(unsigned int j = 0; j < stars.size() && !used; j++)
+        {
+            used = bodies[stars[j]].lightSource ==
+                   (unsigned int)(GL_LIGHT0 + i);
+        }
+        if(used)
+            glEnable(GL_LIGHT0 + i);
+        else
+            glDisable(GL_LIGHT0 + i);
+    }
+}
+
+/**
+    Name: FindBody(BodyHandle)
+    Function: Returns the index in the snapshot of the body the handle
+    stands for, looked up through the slots of the snapshot, or -1 if the
+    body is not in the snapshot.
+**/
+int Scene::FindBody(BodyHandle handle)
+{
+    const std::vector<int>& slotIndex = mpSnapshot->slotIndex;
+    if(handle.slot >= slotIndex.size() || slotIndex[handle.slot] == -1)
+        return -1;
+    const int index = slotIndex[handle.slot];
+    //  the slot may be used by a newer body
+    if(mpSnapshot->bodies[index].handle != handle)
+        return -1;
+    return index;
+}
+
+/**
+    Name: DrawBodies(BodyType)
+    Function: Draws all the bodies of the argument type in the snapshot
+    that are drawn as spheres this frame.
+**/
+void Scene::DrawBodies(BodyType type)
+{
+    const std::vector<SnapshotBody>& bodies = mpSnapshot->bodies;
+    const std::vector<int>& visible = mVisible[type];
+    //  iterate through the visible bodies of the type in the snapshot
+    for(unsigned int i = 0; i < visible.size(); i++)
+    {
+        const SnapshotBody& body = bodies[visible[i]];
+        //  set the colour to be used
+        glColor3f(body.red, body.green, body.blue);
+        //  draw the lighting on the current body
+        DrawLighting(visible[i]);
+        //  draw a sphere of the current body
+        DrawSphere(Vec3d(body.x, body.y, body.z), body.radius);
+    }
+}
+
+/**
+    Name: DrawInstanced()
+    Function: Hands every body drawn as a sphere this frame and all stars
+    lighting them, with their positions and colours, to the instanced
+    renderer.
+**/
+void Scene::DrawInstanced()
+{
+    const std::vector<SnapshotBody>& bodies = mpSnapshot->bodies;
+    const std::vector<int>& stars = mpSnapshot->ofType[BODY_STAR];
+    //  every star lights the other bodies, whether it has a light source
+    //  of the fixed pipeline or not
+    const int starCount = (int)stars.size() < mSpheres.GetMaxStars() ?
+                          stars.size() : mSpheres.GetMaxStars();
+    mStars.resize(starCount*STAR_FLOATS);
+    for(int i = 0; i < starCount; i++)
+    {
+        const SnapshotBody& star = bodies[stars[i]];
+        float* pStar = &mStars[i*STAR_FLOATS];
+        pStar[0] = ToScale(star.x);
+        pStar[1] = ToScale(star.y);
+        pStar[2] = ToScale(star.z);
+        pStar[3] = 0;
+        //  the light is the colour of the star halfway to white, so that
+        //  a coloured star tints the bodies without hiding the colours it
+        //  lacks
+        pStar[4] = 0.5f + 0.5f*star.red;
+        pStar[5] = 0.5f + 0.5f*star.green;
+        pStar[6] = 0.5f + 0.5f*star.blue;
+        pStar[7] = 0;
+    }
+    mSpheres.SetStars(starCount > 0 ? &mStars[0] : 0, starCount);
+    for(int type = 0; type < BODY_TYPE_COUNT; type++)
+    {
+        const std::vector<int>& visible = mVisible[type];
+        for(unsigned int i = 0; i < visible.size(); i++)
+        {
+            const SnapshotBody& body = bodies[visible[i]];
+            mSpheres.Add(ToScale(body.x), ToScale(body.y), ToScale(body.z),
+                         body.radius, body.red, body.green, body.blue,
+                         type != BODY_STAR);
+        }
+    }
+}
+
+/**
+    Name: CullBodies(int)
+    Function: Sorts out the bodies in the snapshot that are drawn this
+    frame. The window shows one scale unit up and down from the body at the
+    argument index, the aspect to the sides and a hundred in depth, turned
+    by the tilt, so a body further away than that plus its radius is not
+    drawn at all. A visible
+    body less than a pixel wide is handed to the renderer as a point, all
+    others are listed by their type to be drawn as spheres.
+**/
+void Scene::CullBodies(int lookAt)
+{
+    const std::vector<SnapshotBody>& bodies = mpSnapshot->bodies;
+    for(int type = 0; type < BODY_TYPE_COUNT; type++)
+        mVisible[type].clear();
+    if(bodies.empty())
+        return;
+    const SnapshotBody& focus = bodies[lookAt];
+    const double focusX = ToScale(focus.x);
+    const double focusY = ToScale(focus.y);
+    const double focusZ = ToScale(focus.z);
+    const double cosTilt = cos(mTilt/DEGREES_PER_RADIAN);
+    const double sinTilt = sin(mTilt/DEGREES_PER_RADIAN);
+    const double pixelsPerUnit = mSpheres.GetPixelsPerUnit();
+    for(unsigned int i = 0; i < bodies.size(); i++)
+    {
+        const SnapshotBody& body = bodies[i];
+        const double x = ToScale(body.x);
+        const double y = ToScale(body.y);
+        const double z = ToScale(body.z);
+        //  the position in the window, turned around the x-axis like the
+        //  matrix set up in Render()
+        const double viewX = x - focusX;
+        const double viewY = cosTilt*(y - focusY) + sinTilt*(z - focusZ);
+        const double viewZ = cosTilt*(z - focusZ) - sinTilt*(y - focusY);
+        const double radius = body.radius;
+        if(fabs(viewX) > mAspect + radius || fabs(viewY) > 1.0 + radius ||
+           fabs(viewZ) > 100.0 + radius)
+            continue;
+        if(2.0*radius*pixelsPerUnit < 1.0)
+            mSpheres.AddPoint(x, y, z, body.red, body.green, body.blue);
+        else
+            mVisible[body.type].push_back(i);
+    }
+}
+
+/**
+    Name: DrawStars()
+    Function: Draws all the stars in space.
+**/
+void Scene::DrawStars()
+{
+    DrawBodies(BODY_STAR);
+}
+
+/**
+    Name: DrawPlanets()
+    Function: Draws all the planets in space.
+**/
+void Scene::DrawPlanets()
+{
+    DrawBodies(BODY_PLANET);
+}
+
+/**
+    Name: DrawMoons()
+    Function: Draws all the moons in space.
+**/
+void Scene::DrawMoons()
+{
+    DrawBodies(BODY_MOON);
+}
+
+/**
+    Name: ToScale(double)
+    Function: Scales the argument from meters to window percentages.
+**/
+double Scene::ToScale(double meters)
+{
+    //  One Astronomical Unit(roughly the distance between the sun and the earth)
+    //  is equal to 149598e6 meters
+    return (meters/(149598e6*mScaleAu));
+}
+
+/**
+    Name: FromScale(double)
+    Function: Scales the argument from window percentages to meters.
+**/
+double Scene::FromScale(double screenPercentage)
+{
+    return screenPercentage*149598e6*mScaleAu;
+}
+
+/**
+    Name: Untilt(double, double)
+    Function: Returns the vector in space that is drawn as the argument x
+    and y in the window, undoing the turn around the x-axis set up in
+    Render() the same way CullBodies(int) does it. Of all such vectors the
+    one without depth in the window is returned, which lies in the plane
+    facing the viewer.
+**/
+Vec3d Scene::Untilt(double x, double y)
+{
+    const double cosTilt = cos(mTilt/DEGREES_PER_RADIAN);
+    const double sinTilt = sin(mTilt/DEGREES_PER_RADIAN);
+    return Vec3d(x, cosTilt*y, sinTilt*y);
+}
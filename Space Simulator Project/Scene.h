@@ -0,0 +1,98 @@
+/****************************************************************************
+*   FILE: Scene.h
+*
+*   FUNCTION: This class draws a snapshot of a space with OpenGL: the stars,
+*   planets and moons in it as lit spheres, seen from above the followed
+*   body at a scale and tilt. It only needs a current GL context, and does
+*   not know where the context comes from.
+*
+*   PURPOSE: Keeping the drawing of the space apart from GLUT lets the same
+*   scene be drawn into a window, where Draw adds the user input, and into
+*   an offscreen context without any display, where the frames are written
+*   to files.
+*
+****************************************************************************/
+
+#ifndef _Scene_
+#define _Scene_
+
+#include "Simulation.h"
+#include "SphereRenderer.h"
+
+class Scene{
+    public:
+    /** Constructors    **/
+    //  constructs a scene of one astronomical unit up and down, that has
+    //  to be initialized in a GL context before it is rendered
+    Scene();
+
+    /** Member Functions   **/
+    //  sets up the lights, materials and spheres in the current GL
+    //  context, looking GL functions up with the loader
+    void            Init(GlProcLoader);
+    //  draws the snapshot into the current viewport
+    void            Render(const Snapshot&);
+    //  draws a sphere at a coordinate with a double size
+    void            DrawSphere(Vec3d, double);
+    //  scale a meters double to screen percentage
+    double          ToScale(double);
+    //  scale a screen percentage double to meters
+    double          FromScale(double);
+    //  turns a vector of the given x and y in the window back by the tilt
+    //  into the space, lying in the plane facing the viewer
+    Vec3d           Untilt(double, double);
+    //  draw all the bodies of a type in space
+    void            DrawBodies(BodyType);
+    //  draws the visible bodies with the instanced renderer
+    void            DrawInstanced();
+    //  lists the bodies drawn as spheres this frame and hands the ones
+    //  less than a pixel wide to the renderer as points, looking at the
+    //  body at the argument index
+    void            CullBodies(int);
+    // draw all the stars in space
+    void            DrawStars();
+    //  draw all the planets in space
+    void            DrawPlanets();
+    //  draw all the moons in space
+    void            DrawMoons();
+    //  draws lighting on the body at the argument index in the snapshot
+    void            DrawLighting(int);
+    //  turns on the light sources of the stars in the snapshot and turns
+    //  off all others
+    void            EnableLights();
+    //  returns the index in the snapshot of the body the handle stands for,
+    //  -1 if it is not in the snapshot
+    int             FindBody(BodyHandle);
+
+    /** Getters and Setters **/
+    void            SetScale(double scaleAu){mScaleAu = scaleAu;}
+    double          GetScale(){return mScaleAu;}
+    void            SetTilt(double tilt){mTilt = tilt;}
+    double          GetTilt(){return mTilt;}
+    void            SetLookAt(BodyHandle lookAt){mLookAt = lookAt;}
+    BodyHandle      GetLookAt(){return mLookAt;}
+
+    protected:
+    /** Class members   **/
+    //  the snapshot being drawn
+    const Snapshot*                     mpSnapshot;
+    double                              mScaleAu;
+    //  the body that is being followed, which stays followed while other
+    //  bodies are added and removed
+    BodyHandle                          mLookAt;
+    //  the degrees the space is tilted around the x-axis
+    double                              mTilt;
+    //  the width of the viewport over its height in the last frame
+    double                              mAspect;
+
+    private:
+    //  draws the spheres of the bodies
+    SphereRenderer                      mSpheres;
+    //  the bodies of every type in the snapshot drawn as spheres this
+    //  frame, which keep their memory from frame to frame
+    std::vector<int>                    mVisible[BODY_TYPE_COUNT];
+    //  the positions and colours of the stars handed to the renderer
+    std::vector<float>                  mStars;
+};
+
+#endif
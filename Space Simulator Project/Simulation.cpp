@@ -0,0 +1,367 @@
+/****************************************************************************
+*   FILE: Simulation.cpp
+*
+*   FUNCTION: This class steps a space on its own thread, in real time. Every
+*   frame, the wall time passed times the time warp is added to the time
+*   owed, and as many whole steps as are owed are taken, as long as they fit
+*   in the frame's CPU budget. After every frame it publishes a snapshot of
+*   everything needed to draw the space, and changes to the space asked for
+*   by other threads are posted to it and run between two frames.
+*
+*   PURPOSE: When the space is stepped from the drawing loop, heavy physics
+*   makes the window stop responding and a slow frame holds up the physics,
+*   and the simulated speed depends on how fast the machine draws. Pacing
+*   by a monotonic clock keeps the simulated speed steady, and a machine
+*   that cannot keep up takes fewer steps per frame and runs slower instead
+*   of freezing.
+*   With the space on its own thread neither waits for the other. Snapshots
+*   are kept in three buffers: one being written, the newest finished one,
+*   and the one being drawn. Publishing and picking up a snapshot only swap
+*   two indices, so drawing never sees a half-updated space and never holds
+*   up the stepping.
+*
+****************************************************************************/
+
+#include "Simulation.h"
+#include <chrono>
+
+typedef std::chrono::steady_clock Clock;
+
+/**
+    Name: Seconds(Clock::time_point, Clock::time_point)
+    Function: Returns the seconds between the two time points.
+**/
+static double Seconds(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double>(end - start).count();
+}
+
+/****************************************************************************
+ * Constructors
+ *
+ ***************************************************************************/
+
+/**
+    Name: Simulation(Space*)
+    Function: Constructs a stopped simulation of the given space. It runs a
+    million times faster than real time, about eleven days per second, at
+    60 frames per second with half of every frame to spend on stepping.
+**/
+Simulation::Simulation(Space* pSpace)
+{
+    mpSpace         = pSpace;
+    mSteps          = 0;
+    mTime           = 0;
+    mStopping       = false;
+    mTimeWarp       = 1e6;
+    mFramePeriod    = 1.0/60;
+    mFrameBudget    = 0.5/60;
+    mWriteBuffer    = 0;
+    mNewestBuffer   = 1;
+    mReadBuffer     = 2;
+    mFresh          = false;
+    for(int i = 0; i < 3; i++)
+    {
+        mBuffers[i].steps = 0;
+        mBuffers[i].time = 0;
+        mBuffers[i].substeps = 0;
+        mBuffers[i].rate = 0;
+        mBuffers[i].timeWarp = mTimeWarp;
+    }
+}
+
+/**
+    Name: ~Simulation()
+    Function: Stops the simulation thread if it is running.
+**/
+Simulation::~Simulation()
+{
+    Stop();
+}
+
+/****************************************************************************
+* Member Functions
+*
+****************************************************************************/
+
+/**
+    Name: Start()
+    Function: Publishes a snapshot of the space as it is, so that there is
+    something to draw right away, and starts the simulation thread.
+**/
+void Simulation::Start()
+{
+    if(IsRunning())
+        return;
+    RunPosted();
+    Publish(0, 0, mTimeWarp);
+    mStopping = false;
+    mThread = std::thread(&Simulation::Run, this);
+}
+
+/**
+    Name: Stop()
+    Function: Tells the simulation thread to stop after its current frame
+    and waits for it.
+**/
+void Simulation::Stop()
+{
+    if(!IsRunning())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mThread.join();
+}
+
+/**
+    Name: Post(const std::function<void(Space&)>&)
+    Function: Queues a change to the space. The simulation thread runs all
+    queued changes, in the order they were posted, before its next frame.
+    While the simulation is stopped nothing else uses the space, and the
+    change is run right away.
+**/
+void Simulation::Post(const std::function<void(Space&)>& change)
+{
+    if(!IsRunning())
+    {
+        change(*mpSpace);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    mPosted.push_back(change);
+}
+
+/**
+    Name: Acquire()
+    Function: Swaps the newest published snapshot in for drawing if there
+    is one that has not been picked up yet, and returns it. The returned
+    snapshot is not written to until Acquire() is called again.
+**/
+const Snapshot& Simulation::Acquire()
+{
+    std::lock_guard<std::mutex> lock(mBufferMutex);
+    if(mFresh)
+    {
+        int newest = mNewestBuffer;
+        mNewestBuffer = mReadBuffer;
+        mReadBuffer = newest;
+        mFresh = false;
+    }
+    return mBuffers[mReadBuffer];
+}
+
+/**
+    Name: Run()
+    Function: Runs one frame after the other until the simulation is
+    stopped. A frame runs the posted changes, adds the wall time since the
+    last frame times the time warp to the time owed, and takes whole steps
+    while time is owed and the frame's budget is not used up. Time still
+    owed after that is dropped, so a machine that cannot keep up simulates
+    slower instead of falling further behind with every frame. The rate
+    that was really achieved is measured over half a second at a time.
+    Between frames the thread sleeps until the next frame is due.
+**/
+void Simulation::Run()
+{
+    Clock::time_point last = Clock::now();
+    Clock::time_point measureStart = last;
+    double measured = 0;
+    double rate = 0;
+    double owed = 0;
+    for(;;)
+    {
+        double timeWarp, framePeriod, frameBudget;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if(mStopping)
+                break;
+            timeWarp = mTimeWarp;
+            framePeriod = mFramePeriod;
+            frameBudget = mFrameBudget;
+        }
+        RunPosted();
+        Clock::time_point frameStart = Clock::now();
+        owed += Seconds(last, frameStart)*timeWarp;
+        last = frameStart;
+        /*  START: Take the steps owed within the budget    */
+        const double step = mpSpace->GetTime();
+        int substeps = 0;
+        while(step > 0 && owed >= step)
+        {
+            mpSpace->Step();
+            owed -= step;
+            substeps++;
+            if(Seconds(frameStart, Clock::now()) > frameBudget)
+                break;
+        }
+        //  drop the time that could not be made up
+        if(owed >= step)
+            owed = 0;
+        mSteps += substeps;
+        mTime += substeps*step;
+        /*  END: Take the steps owed within the budget  */
+        /*  START: Measure the achieved rate    */
+        measured += substeps*step;
+        Clock::time_point now = Clock::now();
+        if(Seconds(measureStart, now) >= 0.5)
+        {
+            rate = measured/Seconds(measureStart, now);
+            measured = 0;
+            measureStart = now;
+        }
+        /*  END: Measure the achieved rate  */
+        Publish(substeps, rate, timeWarp);
+        std::this_thread::sleep_until(frameStart +
+            std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(framePeriod)));
+    }
+}
+
+/**
+    Name: RunPosted()
+    Function: Takes all posted changes out of the queue and runs them. The
+    queue is only locked while the changes are taken out, so a change that
+    takes long does not hold up other threads posting.
+**/
+void Simulation::RunPosted()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mRunning.swap(mPosted);
+    }
+    for(unsigned int i = 0; i < mRunning.size(); i++)
+        mRunning[i](*mpSpace);
+    mRunning.clear();
+}
+
+/**
+    Name: Publish(int, double, double)
+    Function: Copies the state of every body, the amount of steps taken in
+    the frame, the achieved rate and the time warp into the write buffer
+    and swaps it with the newest buffer. The buffers keep their memory, so
+    publishing does not allocate once the space has stopped growing.
+**/
+void Simulation::Publish(int substeps, double rate, double timeWarp)
+{
+    Snapshot& snapshot = mBuffers[mWriteBuffer];
+    snapshot.steps = mSteps;
+    snapshot.time = mTime;
+    snapshot.substeps = substeps;
+    snapshot.rate = rate;
+    snapshot.timeWarp = timeWarp;
+    TakeSnapshot(*mpSpace, snapshot);
+    std::lock_guard<std::mutex> lock(mBufferMutex);
+    int written = mWriteBuffer;
+    mWriteBuffer = mNewestBuffer;
+    mNewestBuffer = written;
+    mFresh = true;
+}
+
+/**
+    Name: TakeSnapshot(Space&, Snapshot&)
+    Function: Copies the bodies of the space and the lists of their types
+    and slots into the snapshot, reusing the memory it already has. The
+    steps, time and rates of the snapshot are left to the caller.
+**/
+void Simulation::TakeSnapshot(Space& space, Snapshot& snapshot)
+{
+    BodyStore& bodies = space.GetBodies();
+    const int count = bodies.GetCount();
+    snapshot.bodies.resize(count);
+    snapshot.slotIndex.assign(bodies.GetSlotCount(), -1);
+    for(int t = 0; t < BODY_TYPE_COUNT; t++)
+        snapshot.ofType[t].clear();
+    const double* pX = bodies.GetX();
+    const double* pY = bodies.GetY();
+    const double* pZ = bodies.GetZ();
+    for(int i = 0; i < count; i++)
+    {
+        BodyInfo& info = bodies.GetInfo(i);
+        SnapshotBody& body = snapshot.bodies[i];
+        body.x              = pX[i];
+        body.y              = pY[i];
+        body.z              = pZ[i];
+        body.radius         = info.radius;
+        body.red            = info.red;
+        body.green          = info.green;
+        body.blue           = info.blue;
+        body.type           = info.type;
+        body.lightSource    = info.lightSource;
+        body.handle         = bodies.GetHandle(i);
+        snapshot.slotIndex[body.handle.slot] = i;
+        snapshot.ofType[body.type].push_back(i);
+    }
+}
+
+/****************************************************************************
+* Getters and Setters
+*
+****************************************************************************/
+
+/**
+    Name: GetTimeWarp()
+    Function: Returns the simulated seconds per wall second asked for.
+**/
+double Simulation::GetTimeWarp()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mTimeWarp;
+}
+
+/**
+    Name: SetTimeWarp(double)
+    Function: Sets the simulated seconds per wall second, which the
+    simulation thread picks up at its next frame.
+**/
+void Simulation::SetTimeWarp(double timeWarp)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mTimeWarp = timeWarp;
+}
+
+/**
+    Name: GetFramePeriod()
+    Function: Returns the wall seconds from the start of one frame to the
+    start of the next.
+**/
+double Simulation::GetFramePeriod()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mFramePeriod;
+}
+
+/**
+    Name: SetFramePeriod(double)
+    Function: Sets the wall seconds from the start of one frame to the
+    start of the next.
+**/
+void Simulation::SetFramePeriod(double framePeriod)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFramePeriod = framePeriod;
+}
+
+/**
+    Name: GetFrameBudget()
+    Function: Returns the wall seconds per frame that may be spent on
+    stepping.
+**/
+double Simulation::GetFrameBudget()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mFrameBudget;
+}
+
+/**
+    Name: SetFrameBudget(double)
+    Function: Sets the wall seconds per frame that may be spent on stepping.
+    A step that is started always finishes, so a frame can go over its
+    budget by at most one step.
+**/
+void Simulation::SetFrameBudget(double frameBudget)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFrameBudget = frameBudget;
+}
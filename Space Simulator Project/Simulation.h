@@ -0,0 +1,136 @@
+/****************************************************************************
+*   FILE: Simulation.h
+*
+*   FUNCTION: This class steps a space on its own thread, in real time. Every
+*   frame, the wall time passed times the time warp is added to the time
+*   owed, and as many whole steps as are owed are taken, as long as they fit
+*   in the frame's CPU budget. After every frame it publishes a snapshot of
+*   everything needed to draw the space, and changes to the space asked for
+*   by other threads are posted to it and run between two frames.
+*
+*   PURPOSE: When the space is stepped from the drawing loop, heavy physics
+*   makes the window stop responding and a slow frame holds up the physics,
+*   and the simulated speed depends on how fast the machine draws. Pacing
+*   by a monotonic clock keeps the simulated speed steady, and a machine
+*   that cannot keep up takes fewer steps per frame and runs slower instead
+*   of freezing.
+*   With the space on its own thread neither waits for the other. Snapshots
+*   are kept in three buffers: one being written, the newest finished one,
+*   and the one being drawn. Publishing and picking up a snapshot only swap
+*   two indices, so drawing never sees a half-updated space and never holds
+*   up the stepping.
+*
+****************************************************************************/
+
+#ifndef _Simulation_
+#define _Simulation_
+
+#include "Space.h"
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//  the state of a body as it is drawn
+struct SnapshotBody{
+    double              x;
+    double              y;
+    double              z;
+    double              radius;
+    float               red;
+    float               green;
+    float               blue;
+    BodyType            type;
+    unsigned int        lightSource;
+    BodyHandle          handle;
+};
+
+//  the state of a whole space at the end of a frame
+struct Snapshot{
+    //  the amount of steps taken since the simulation started
+    long long           steps;
+    //  the amount of seconds simulated since the simulation started
+    double              time;
+    //  the amount of steps taken during the frame
+    int                 substeps;
+    //  the simulated seconds per wall second measured over the last half
+    //  second, and the amount that was asked for
+    double              rate;
+    double              timeWarp;
+    std::vector<SnapshotBody> bodies;
+    //  the index in the bodies of every body of each type
+    std::vector<int>    ofType[BODY_TYPE_COUNT];
+    //  the index in the bodies of every slot of the handle table, -1 for a
+    //  free slot
+    std::vector<int>    slotIndex;
+};
+
+class Simulation{
+    public:
+    /** Constructors    **/
+    //  constructs a stopped simulation of the given space
+    Simulation(Space*);
+    //  stops the simulation thread
+    ~Simulation();
+    /** Member Functions   **/
+    //  publishes the first snapshot and starts stepping the space
+    void                Start();
+    //  finishes the current batch and stops stepping the space
+    void                Stop();
+    //  runs the given change on the simulation thread before the next
+    //  frame, or right away if the simulation is stopped
+    void                Post(const std::function<void(Space&)>&);
+    //  returns the newest published snapshot, which stays unchanged until
+    //  the next call
+    const Snapshot&     Acquire();
+    //  copies the bodies of the given space into the given snapshot,
+    //  without going through a simulation thread
+    static void         TakeSnapshot(Space&, Snapshot&);
+    /** Getters and Setters **/
+    //  the simulated seconds per wall second asked for
+    double              GetTimeWarp();
+    void                SetTimeWarp(double);
+    //  the wall seconds per frame, and the part of them that may be spent
+    //  on stepping
+    double              GetFramePeriod();
+    void                SetFramePeriod(double);
+    double              GetFrameBudget();
+    void                SetFrameBudget(double);
+    bool                IsRunning()
+                            {return mThread.joinable();}
+
+    private:
+    //  the simulation owns a thread and can therefore not be copied
+    Simulation(const Simulation&);
+    Simulation&         operator=(const Simulation&);
+    //  the loop the simulation thread runs until it is stopped
+    void                Run();
+    //  runs all posted changes
+    void                RunPosted();
+    //  copies the space into the write buffer and makes it the newest
+    void                Publish(int, double, double);
+
+    /** Class Members   **/
+    Space*              mpSpace;
+    std::thread         mThread;
+    long long           mSteps;
+    double              mTime;
+    bool                mStopping;
+    double              mTimeWarp;
+    double              mFramePeriod;
+    double              mFrameBudget;
+    //  guards the stop flag, the pacing settings and the posted changes
+    std::mutex          mMutex;
+    std::vector<std::function<void(Space&)> > mPosted;
+    std::vector<std::function<void(Space&)> > mRunning;
+    //  guards the buffer indices
+    std::mutex          mBufferMutex;
+    Snapshot            mBuffers[3];
+    int                 mWriteBuffer;
+    int                 mNewestBuffer;
+    int                 mReadBuffer;
+    //  true when the newest buffer has not been picked up yet
+    bool                mFresh;
+};
+
+#endif
@@ -12,6 +12,14 @@
 ****************************************************************************/
 
 #include "Space.h"
+#include "EulerIntegrator.h"
+#include "LeapfrogIntegrator.h"
+#include "VelocityVerletIntegrator.h"
+#include "YoshidaIntegrator.h"
+#include "BlockTimestepIntegrator.h"
+#include "WisdomHolmanIntegrator.h"
+#include "TrajectorySink.h"
+#include <math.h>
 
 /****************************************************************************
 * Constructors
@@ -23,8 +31,28 @@
     Function: Constructs a Space with the integer time given as time to pass
     in PassTime().
 **/
-Space::Space(int time){
+Space::Space(int time) : mBarnesHut(0.5){
     mTime = time;
+    mUsedLights = 0;
+    mGravitySolver = GRAVITY_DIRECT;
+    mGravityPrecision = PRECISION_DOUBLE;
+    mMergeCollisions = false;
+    mReportGravityError = false;
+    mGravityError.meanRelative = 0;
+    mGravityError.rmsRelative = 0;
+    mGravityError.maxRelative = 0;
+    mIntegratorType = INTEGRATOR_EULER;
+    mpIntegrator = new EulerIntegrator();
+    mpTrajectorySink = 0;
+}
+
+/**
+    Name: ~Space()
+    Function: Deletes the integrator of the space. The objects in space are
+    owned by whoever created them.
+**/
+Space::~Space(){
+    delete mpIntegrator;
 }
 
 /****************************************************************************
@@ -32,175 +60,656 @@ Space::Space(int time){
 *
 ****************************************************************************/
 
+/**
+    Name: AddBody(SpaceObject*, BodyType)
+    Function: Copies the state of the object into the body store and binds
+    the object to it, so that the object keeps reading its current state.
+**/
+void Space::AddBody(SpaceObject* pObject, BodyType type){
+    BodyInfo info;
+    info.name           = pObject->GetName();
+    info.radius         = pObject->GetRadius();
+    info.red            = pObject->GetRed();
+    info.green          = pObject->GetGreen();
+    info.blue           = pObject->GetBlue();
+    info.type           = type;
+    info.lightSource    = 0;
+    info.pObject        = pObject;
+    int index = mBodies.Add(info, pObject->GetPosition(),
+                            pObject->GetVelocity(), pObject->GetMass());
+    mBodies.SetForce(index, pObject->GetForce());
+    pObject->Bind(&mBodies, index);
+    mpIntegrator->Reset();
+}
+
 /**
     Name: AddObjectToSpace(Planet*)
-    Function: Adds an object to the ObjectsInSpace list and the
-    PlanetsInSpace list.
+    Function: Adds a planet to the body store.
 **/
 void Space::AddObjectToSpace(Planet* pPlanet){
-    mObjectsInSpace.push_back(pPlanet);
-    mPlanetsInSpace.push_back(pPlanet);
+    AddBody(pPlanet, BODY_PLANET);
 }
 
 /**
     Name: AddObjectToSpace(Moon*)
-    Function: Adds an object to the ObjectsInSpace list and the
-    MoonsInSpace list.
+    Function: Adds a moon to the body store.
 **/
 void Space::AddObjectToSpace(Moon* pMoon){
-    mObjectsInSpace.push_back(pMoon);
-    mMoonsInSpace.push_back(pMoon);
+    AddBody(pMoon, BODY_MOON);
 }
 
 /**
     Name: AddObjectToSpace(Star*)
-    Function: Adds an object to the ObjectsInSpace list and the
-    StarsInSpace list.
+    Function: Adds a star to the body store and gives it a light source.
 **/
 void Space::AddObjectToSpace(Star* pStar){
-    mObjectsInSpace.push_back(pStar);
-    //  if there are less than 9 stars
-    //  GLUT can only handle up to 8 light sources
-    if(mStarsInSpace.size() < 9){
-        pStar->SetLightSource(mStarsInSpace.size());
+    AddBody(pStar, BODY_STAR);
+    //  GLUT can only handle up to 8 light sources, the stars after them
+    //  only light the bodies drawn with shaders
+    const int light = TakeLightSource();
+    if(light != -1){
+        pStar->SetLightSource(light);
     }
-    mStarsInSpace.push_back(pStar);
+}
 
+/**
+    Name: AddBodies(BodyStore&)
+    Function: Moves all bodies of the argument store to the end of the body
+    store in one go and gives the stars among them a light source, the same
+    way as AddObjectToSpace(Star*). No object is created for any of them,
+    so adding millions of bodies needs no memory besides the store.
+**/
+void Space::AddBodies(BodyStore& bodies){
+    const int first = mBodies.GetCount();
+    mBodies.Append(bodies);
+    for(int i = first; i < mBodies.GetCount(); i++)
+    {
+        BodyInfo& info = mBodies.GetInfo(i);
+        info.pObject = 0;
+        if(info.type != BODY_STAR)
+            continue;
+        //  16384 is the integer where the glut enumerators for light
+        //  sources start
+        const int light = TakeLightSource();
+        info.lightSource = light != -1 ? 16384 + light : 0;
+    }
+    mpIntegrator->Reset();
 }
 
 /**
-    Name: PopObjectFromSpace()
-    Function: Removes the last object from the ObjectsInSpace and the
-    Star/Planet/Moon list depending on its type and frees the objects
-    allocated memory.
+    Name: AddObjectsToSpace(std::vector<Planet*>&)
+    Function: Adds all the planets in the vector, growing the body store
+    only once.
 **/
-void Space::PopObjectFromSpace(){
-    //  if there are objects in space
-    if(!mObjectsInSpace.empty())
+void Space::AddObjectsToSpace(std::vector<Planet*>& planets){
+    ReserveObjects(mBodies.GetCount() + planets.size());
+    for(unsigned int i = 0; i < planets.size(); i++)
+        AddObjectToSpace(planets[i]);
+}
+
+/**
+    Name: AddObjectsToSpace(std::vector<Star*>&)
+    Function: Adds all the stars in the vector, growing the body store only
+    once.
+**/
+void Space::AddObjectsToSpace(std::vector<Star*>& stars){
+    ReserveObjects(mBodies.GetCount() + stars.size());
+    for(unsigned int i = 0; i < stars.size(); i++)
+        AddObjectToSpace(stars[i]);
+}
+
+/**
+    Name: AddObjectsToSpace(std::vector<Moon*>&)
+    Function: Adds all the moons in the vector, growing the body store only
+    once.
+**/
+void Space::AddObjectsToSpace(std::vector<Moon*>& moons){
+    ReserveObjects(mBodies.GetCount() + moons.size());
+    for(unsigned int i = 0; i < moons.size(); i++)
+        AddObjectToSpace(moons[i]);
+}
+
+/**
+    Name: ReserveObjects(int)
+    Function: Makes room for the given amount of objects in the body store.
+**/
+void Space::ReserveObjects(int count){
+    mBodies.Reserve(count);
+}
+
+/**
+    Name: RemoveBody(int)
+    Function: Removes the body at the given index from the body store in
+    constant time and frees the memory allocated by its object. The last
+    body is moved into its place, so the object of that body is bound to
+    the new index. The light source of a removed star is handed to a star
+    that has none.
+**/
+void Space::RemoveBody(int index){
+    BodyInfo& info = mBodies.GetInfo(index);
+    //  a removed star gives back its light source
+    const bool freesLight = info.type == BODY_STAR && info.lightSource != 0;
+    if(freesLight)
     {
-        //  set a temp pointer to the last object in space
-        SpaceObject* pLastObject = mObjectsInSpace.back();
-        //  if there are stars in space
-        if(!mStarsInSpace.empty())
-        {
-            //  set a temporary pointer to the last star in space
-            Star* star = mStarsInSpace.back();
-            //  if mass of star = mass of spaceobject
-            if(pLastObject->GetMass() == star->GetMass() && star != 0)
-            {
-                //  remove the star from the list of stars
-                mStarsInSpace.pop_back();
-            }
-        }
-        //  if there are planets in space
-        if(!mPlanetsInSpace.empty())
-        {
-            //  set a temporary pointer to the last planet in space
-            Planet* planet = mPlanetsInSpace.back();
-            //  if mass of planet = mass of spaceobject
-            if(pLastObject->GetMass() == planet->GetMass())
-            {
-                //  remove the planet from the list of planets
-                mPlanetsInSpace.pop_back();
-            }
-        }
-        //  if there are moons in space
-        if(!mMoonsInSpace.empty())
+        mUsedLights &= ~(1u << (info.lightSource - 16384));
+    }
+    SpaceObject* pObject = info.pObject;
+    //  the object keeps the state the body had
+    if(pObject != 0)
+        pObject->Unbind();
+    mBodies.RemoveAt(index);
+    if(index < mBodies.GetCount())
+    {
+        SpaceObject* pMoved = mBodies.GetInfo(index).pObject;
+        if(pMoved != 0)
+            pMoved->SetIndex(index);
+    }
+    if(freesLight)
+    {
+        BodySpan stars = mBodies.GetBodiesOfType(BODY_STAR);
+        for(const int* pIndex = stars.begin(); pIndex != stars.end();
+            pIndex++)
         {
-            //  set a temporary pointer to the last moon in space
-            Moon* moon = mMoonsInSpace.back();
-            //  if mass of moon = mass of spaceobject
-            if(pLastObject->GetMass() == moon->GetMass())
+            BodyInfo& star = mBodies.GetInfo(*pIndex);
+            if(star.lightSource == 0)
             {
-                //  remove the moon from the list of moons
-                mMoonsInSpace.pop_back();
+                star.lightSource = 16384 + TakeLightSource();
+                break;
             }
         }
-        //  remove the last object from the list of objects
-        mObjectsInSpace.pop_back();
-        //  free the memory allocated by the object
-        delete pLastObject;
-    //  if the list is empty
+    }
+    mpIntegrator->Reset();
+    //  free the memory allocated by the object
+    delete pObject;
+}
+
+/**
+    Name: PopObjectFromSpace()
+    Function: Removes the last object from the body store and frees the
+    object's allocated memory.
+**/
+void Space::PopObjectFromSpace(){
+    //  if there are objects in space
+    if(mBodies.GetCount() > 0)
+    {
+        RemoveBody(mBodies.GetCount() - 1);
+    //  if the store is empty
     }else
     {
         //handle error
     }
 }
 
+/**
+    Name: RemoveObjectFromSpace(BodyHandle)
+    Function: Removes the body the handle stands for, wherever it is in the
+    body store, and frees the object's allocated memory. Returns false if
+    the body was already removed.
+**/
+bool Space::RemoveObjectFromSpace(BodyHandle handle){
+    const int index = mBodies.Find(handle);
+    if(index == -1)
+        return false;
+    RemoveBody(index);
+    return true;
+}
+
+/**
+    Name: ClearObjects()
+    Function: Removes all objects from the body store, from the last to the
+    first, freeing every object's allocated memory.
+**/
+void Space::ClearObjects(){
+    while(mBodies.GetCount() > 0)
+        PopObjectFromSpace();
+}
+
+/**
+    Name: BodiesChanged()
+    Function: Hands out the light sources again and resets the integrator.
+    Called after bodies were put into the body store without going through
+    the space, such as when loading a checkpoint. The stars keep the light
+    sources they came with, unless another star already has the same one,
+    and the stars without one get the lowest ones left.
+**/
+void Space::BodiesChanged(){
+    mUsedLights = 0;
+    BodySpan stars = mBodies.GetBodiesOfType(BODY_STAR);
+    for(const int* pIndex = stars.begin(); pIndex != stars.end(); pIndex++)
+    {
+        BodyInfo& star = mBodies.GetInfo(*pIndex);
+        const unsigned int light = star.lightSource - 16384;
+        if(light < (unsigned int)LIGHT_SOURCE_COUNT &&
+           (mUsedLights & (1u << light)) == 0)
+            mUsedLights |= 1u << light;
+        else
+            star.lightSource = 0;
+    }
+    for(const int* pIndex = stars.begin(); pIndex != stars.end(); pIndex++)
+    {
+        BodyInfo& star = mBodies.GetInfo(*pIndex);
+        const int light = star.lightSource == 0 ? TakeLightSource() : -1;
+        if(light != -1)
+            star.lightSource = 16384 + light;
+    }
+    mpIntegrator->Reset();
+}
+
+/**
+    Name: TakeLightSource()
+    Function: Marks the lowest light source no star is using as used and
+    returns its number from 0, or -1 if every light source is used.
+**/
+int Space::TakeLightSource(){
+    for(int light = 0; light < LIGHT_SOURCE_COUNT; light++)
+    {
+        if((mUsedLights & (1u << light)) == 0)
+        {
+            mUsedLights |= 1u << light;
+            return light;
+        }
+    }
+    return -1;
+}
+
 /**
     Name: CalculateGravity()
-    Function: Calculates gravity between all elements in ObjectsInSpace.
+    Function: Calculates gravity between all bodies in the body store using
+    the chosen solver. If error reporting is on and the solver approximates
+    or runs in mixed precision, the error against the double precision
+    direct sum is saved as well.
 **/
 void Space::CalculateGravity(){
-    std::list<SpaceObject*>::iterator it;
-    std::list<SpaceObject*>::iterator it2;
-    SpaceObject * Object1;
-    SpaceObject * Object2;
-    //  iterate through the list
-    for( it = mObjectsInSpace.begin(); it != mObjectsInSpace.end(); it++)
-    {
-        it2 = it;
-        //  iterate one step ahead of the previous for
-        for(it2++; it2 != mObjectsInSpace.end(); it2++)
+    if(mReportGravityError && (mGravitySolver != GRAVITY_DIRECT ||
+                               mGravityPrecision != PRECISION_DOUBLE))
+    {
+        mGravityError = CompareGravitySolvers();
+        //  the solver forces are already in the compare arrays
+        double* pFx = mBodies.GetFx();
+        double* pFy = mBodies.GetFy();
+        double* pFz = mBodies.GetFz();
+        for(int i = 0; i < mBodies.GetCount(); i++)
         {
-            Object1 = *it;
-            Object2 = *it2;
-            //  the universal gravitational constant
-            const double g = 6.67428e-11;
-            //  calculate the distance between the two objects
-            Coordinate distance =
-                Object2->GetPosition() - Object1->GetPosition();
-            //  calculate the lentgh of the distance
-            double length = distance.CalculateLength();
-            //  calculate the gravitational pull between the objects:
-            //  F = (G*m1*m2)/r*r where r is the length of the distance.
-            double force =
-                ((g*Object1->GetMass()*Object2->GetMass())/(length*length));
-            distance = distance*(1/length);
-            distance = distance*force;
-            //  set the gravitational force to object1
-            Object1->SetForce(Object1->GetForce()+distance);
-            //  set the gravitational force to object2
-            Object2->SetForce(Object2->GetForce()-distance);
+            pFx[i] += mCompareFx[i];
+            pFy[i] += mCompareFy[i];
+            pFz[i] += mCompareFz[i];
         }
+        return;
     }
+    CalculateSolverGravity(mBodies.GetFx(), mBodies.GetFy(),
+                           mBodies.GetFz());
+}
 
+/**
+    Name: CompareGravitySolvers()
+    Function: Calculates the forces on all bodies with both the chosen solver
+    and the double precision direct sum and returns the mean, root mean
+    square and largest relative difference between them. The forces in the
+    body store are not changed, the solver forces are left in the compare
+    arrays.
+**/
+GravityError Space::CompareGravitySolvers(){
+    const int count = mBodies.GetCount();
+    mCompareFx.assign(count, 0);
+    mCompareFy.assign(count, 0);
+    mCompareFz.assign(count, 0);
+    mDirectFx.assign(count, 0);
+    mDirectFy.assign(count, 0);
+    mDirectFz.assign(count, 0);
+    GravityError error;
+    error.meanRelative = 0;
+    error.rmsRelative = 0;
+    error.maxRelative = 0;
+    if(count == 0)
+        return error;
+    CalculateSolverGravity(&mCompareFx[0], &mCompareFy[0], &mCompareFz[0]);
+    CalculateDirectGravity(&mDirectFx[0], &mDirectFy[0], &mDirectFz[0]);
+    int compared = 0;
+    for(int i = 0; i < count; i++)
+    {
+        double direct = sqrt(mDirectFx[i]*mDirectFx[i] +
+                             mDirectFy[i]*mDirectFy[i] +
+                             mDirectFz[i]*mDirectFz[i]);
+        //  a body without any pull has no relative error
+        if(direct == 0)
+            continue;
+        double dx = mCompareFx[i] - mDirectFx[i];
+        double dy = mCompareFy[i] - mDirectFy[i];
+        double dz = mCompareFz[i] - mDirectFz[i];
+        double relative = sqrt(dx*dx + dy*dy + dz*dz)/direct;
+        error.meanRelative += relative;
+        error.rmsRelative += relative*relative;
+        if(relative > error.maxRelative)
+            error.maxRelative = relative;
+        compared++;
+    }
+    if(compared > 0)
+    {
+        error.meanRelative /= compared;
+        error.rmsRelative = sqrt(error.rmsRelative/compared);
+    }
+    return error;
+}
+
+/**
+    Name: CalculateSolverGravity(double*, double*, double*)
+    Function: Adds the force on every body from the chosen solver to the
+    argument x, y and z force arrays, with the direct sum in the chosen
+    precision.
+**/
+void Space::CalculateSolverGravity(double* pFx, double* pFy, double* pFz){
+    switch(mGravitySolver)
+    {
+        case GRAVITY_BARNES_HUT:
+            mBarnesHut.CalculateGravity(mBodies, pFx, pFy, pFz);
+            break;
+        case GRAVITY_DIRECT:
+        default:
+            if(mGravityPrecision == PRECISION_MIXED)
+                mMixedGravity.CalculateGravity(mBodies, pFx, pFy, pFz);
+            else
+                CalculateDirectGravity(pFx, pFy, pFz);
+            break;
+    }
+}
+
+/**
+    Name: CalculateDirectGravity(double*, double*, double*)
+    Function: Calculates gravity between every pair of bodies in the body
+    store in double precision and adds the forces to the argument x, y and z
+    force arrays.
+**/
+void Space::CalculateDirectGravity(double* pFx, double* pFy, double* pFz){
+    mDirectGravity.CalculateGravity(mBodies, pFx, pFy, pFz);
 }
 
 /**
     Name: PassTime()
-    Function: Calculates the new positions for all objects in space after a
+    Function: Calculates the new positions for all bodies in space after a
     certain amount of time has passed.
 **/
 void Space::PassTime(){
-    std::list<SpaceObject*>::iterator it;
-    //  iterate through the list of objects in space
-    for( it = mObjectsInSpace.begin(); it != mObjectsInSpace.end(); it++)
+    PassTime(mTime);
+}
+
+/**
+    Name: PassTime(double)
+    Function: Calculates the new positions for all bodies in space after the
+    given amount of seconds has passed, using the current forces.
+**/
+void Space::PassTime(double time){
+    const int count = mBodies.GetCount();
+    double* pX = mBodies.GetX();
+    double* pY = mBodies.GetY();
+    double* pZ = mBodies.GetZ();
+    double* pVx = mBodies.GetVx();
+    double* pVy = mBodies.GetVy();
+    double* pVz = mBodies.GetVz();
+    double* pFx = mBodies.GetFx();
+    double* pFy = mBodies.GetFy();
+    double* pFz = mBodies.GetFz();
+    const double* pMass = mBodies.GetMass();
+    //  iterate through the bodies in space
+    for(int i = 0; i < count; i++)
     {
-        //  point to the current object
-        SpaceObject * pObject = *it;
         //  if mass isnt zero. Reason: There is a division by mass later on.
-        if(pObject->GetMass() != 0)
+        if(pMass[i] != 0)
         {
-            //  update position with current velocity
-            pObject->SetPosition(pObject->GetPosition() +
-                                 (pObject->GetVelocity() * mTime));
             //  calculate acceleration using the current force
-            Coordinate acceleration = Coordinate(pObject->GetForce() *
-                                                 (1/pObject->GetMass()));
-            //  set new position using the acceleration
-            pObject->SetPosition(pObject->GetPosition() +
-                                 ((acceleration)*(mTime*mTime)*0.5));
+            double ax = pFx[i]/pMass[i];
+            double ay = pFy[i]/pMass[i];
+            double az = pFz[i]/pMass[i];
+            //  update position with current velocity and the acceleration
+            pX[i] += pVx[i]*time + ax*(time*time)*0.5;
+            pY[i] += pVy[i]*time + ay*(time*time)*0.5;
+            pZ[i] += pVz[i]*time + az*(time*time)*0.5;
             //  set the new velocity using the acceleration
-            pObject->SetVelocity(pObject->GetVelocity() +
-                                 acceleration*mTime);
-            //  the calculation is finished so force is set to 0
-            pObject->SetForce(Coordinate(0, 0));
+            pVx[i] += ax*time;
+            pVy[i] += ay*time;
+            pVz[i] += az*time;
         }
         else
         {
             //handle error
         }
+        //  the calculation is finished so force is set to 0
+        pFx[i] = 0;
+        pFy[i] = 0;
+        pFz[i] = 0;
+    }
+}
+
+/**
+    Name: Step()
+    Function: Moves all bodies forward by the time of the space with the
+    chosen integrator, which calculates gravity as often as it needs, merges
+    the bodies that touch if collisions are on, and hands the bodies to the
+    trajectory sink if there is one.
+**/
+void Space::Step(){
+    mpIntegrator->Step(*this, mTime);
+    if(mMergeCollisions)
+        MergeCollisions();
+    if(mpTrajectorySink != 0)
+        mpTrajectorySink->Step(mBodies, mTime);
+}
+
+/**
+    Name: MergeCollisions()
+    Function: Merges every group of touching bodies into its heaviest body,
+    which keeps the mass and momentum of the group, and removes the others
+    from the body store like RemoveObjectFromSpace(BodyHandle). They are
+    removed from the last to the first, so that the body moved into the
+    place of a removed one is never one still to be removed.
+**/
+int Space::MergeCollisions(){
+    const int merged = mCollisions.Merge(mBodies);
+    const std::vector<int>& absorbed = mCollisions.GetAbsorbed();
+    for(int k = merged - 1; k >= 0; k--)
+        RemoveBody(absorbed[k]);
+    return merged;
+}
+
+/**
+    Name: ClearForces()
+    Function: Sets the force on every body in the body store to zero.
+**/
+void Space::ClearForces(){
+    double* pFx = mBodies.GetFx();
+    double* pFy = mBodies.GetFy();
+    double* pFz = mBodies.GetFz();
+    for(int i = 0; i < mBodies.GetCount(); i++)
+    {
+        pFx[i] = 0;
+        pFy[i] = 0;
+        pFz[i] = 0;
+    }
+}
+
+/**
+    Name: CalculateEnergy()
+    Function: Returns the kinetic energy of all bodies plus the potential
+    energy of every pair of bodies, softened like the forces. A symplectic
+    integrator keeps this close to its starting value, so its drift shows
+    how accurate a run is. Merging bodies loses energy.
+**/
+double Space::CalculateEnergy(){
+    const double g = 6.67428e-11;
+    const int count = mBodies.GetCount();
+    const double* pX = mBodies.GetX();
+    const double* pY = mBodies.GetY();
+    const double* pZ = mBodies.GetZ();
+    const double* pVx = mBodies.GetVx();
+    const double* pVy = mBodies.GetVy();
+    const double* pVz = mBodies.GetVz();
+    const double* pMass = mBodies.GetMass();
+    const double softening2 = GetSoftening()*GetSoftening();
+    double kinetic = 0;
+    double potential = 0;
+    for(int i = 0; i < count; i++)
+    {
+        kinetic += 0.5*pMass[i]*(pVx[i]*pVx[i] + pVy[i]*pVy[i] +
+                                 pVz[i]*pVz[i]);
+        for(int j = i + 1; j < count; j++)
+        {
+            double dx = pX[j] - pX[i];
+            double dy = pY[j] - pY[i];
+            double dz = pZ[j] - pZ[i];
+            double distance2 = dx*dx + dy*dy + dz*dz;
+            if(distance2 != 0)
+                potential -= g*pMass[i]*pMass[j]/
+                             sqrt(distance2 + softening2);
+        }
+    }
+    return kinetic + potential;
+}
 
+/****************************************************************************
+* Getters and Setters
+*
+****************************************************************************/
+
+/**
+    Name: GetInteractionCount()
+    Function: Returns the amount of pulls between a body and another body or
+    a cell that the chosen solver sums up for one calculation. The vector
+    kernels and the mixed precision direct sum calculate every pair twice,
+    once per body.
+**/
+long long Space::GetInteractionCount(){
+    long long count = mBodies.GetCount();
+    if(mGravitySolver == GRAVITY_BARNES_HUT)
+        return mBarnesHut.GetInteractionCount();
+    if(mGravityPrecision == PRECISION_DOUBLE &&
+       mDirectGravity.GetKernel() == KERNEL_SCALAR)
+        return count*(count - 1)/2;
+    return count*(count - 1);
+}
+
+/**
+    Name: SetSoftening(double)
+    Function: Sets the Plummer softening length of every solver. The pull
+    between two bodies becomes G*m1*m2*r/(r*r + e*e)^1.5, which stays
+    finite when they meet.
+**/
+void Space::SetSoftening(double softening){
+    mDirectGravity.SetSoftening(softening);
+    mMixedGravity.SetSoftening(softening);
+    mBarnesHut.SetSoftening(softening);
+}
+
+/**
+    Name: SetIntegrator(IntegratorType)
+    Function: Replaces the integrator of the space. The forces are cleared,
+    since integrators leave different forces behind after a step.
+**/
+void Space::SetIntegrator(IntegratorType type){
+    Integrator* pIntegrator;
+    switch(type)
+    {
+        case INTEGRATOR_LEAPFROG:
+            pIntegrator = new LeapfrogIntegrator();
+            break;
+        case INTEGRATOR_VELOCITY_VERLET:
+            pIntegrator = new VelocityVerletIntegrator();
+            break;
+        case INTEGRATOR_YOSHIDA:
+            pIntegrator = new YoshidaIntegrator();
+            break;
+        case INTEGRATOR_BLOCK_TIMESTEP:
+            pIntegrator = new BlockTimestepIntegrator();
+            break;
+        case INTEGRATOR_WISDOM_HOLMAN:
+            pIntegrator = new WisdomHolmanIntegrator();
+            break;
+        case INTEGRATOR_EULER:
+        default:
+            type = INTEGRATOR_EULER;
+            pIntegrator = new EulerIntegrator();
+            break;
+    }
+    delete mpIntegrator;
+    mpIntegrator = pIntegrator;
+    mIntegratorType = type;
+    ClearForces();
+}
+
+/**
+    Name: SetTrajectorySink(TrajectorySink*)
+    Function: Sets the sink the bodies are recorded to after every step and
+    records them as they are now, so that the first frame holds the start.
+**/
+void Space::SetTrajectorySink(TrajectorySink* pSink){
+    mpTrajectorySink = pSink;
+    if(mpTrajectorySink != 0)
+        mpTrajectorySink->Record(mBodies);
+}
+
+/**
+    Name: GetObjectsInSpace()
+    Function: Returns a list of the objects that all bodies in space were
+    added from.
+**/
+std::list<SpaceObject *> Space::GetObjectsInSpace(){
+    std::list<SpaceObject *> objects;
+    for(int i = 0; i < mBodies.GetCount(); i++)
+    {
+        if(mBodies.GetInfo(i).pObject != 0)
+            objects.push_back(mBodies.GetInfo(i).pObject);
+    }
+    return objects;
+}
+
+/**
+    Name: GetStarsInSpace()
+    Function: Returns a list of all stars in space, walking only the stars
+    in the body store. The list is a copy, GetBodiesOfType(BodyType) reads
+    them in place.
+**/
+std::list<Star *> Space::GetStarsInSpace(){
+    std::list<Star *> stars;
+    BodySpan bodies = mBodies.GetBodiesOfType(BODY_STAR);
+    for(const int* pIndex = bodies.begin(); pIndex != bodies.end(); pIndex++)
+    {
+        SpaceObject* pObject = mBodies.GetInfo(*pIndex).pObject;
+        if(pObject != 0)
+            stars.push_back(static_cast<Star*>(pObject));
+    }
+    return stars;
+}
+
+/**
+    Name: GetPlanetsInSpace()
+    Function: Returns a list of all planets in space, walking only the planets
+    in the body store. The list is a copy, GetBodiesOfType(BodyType) reads
+    them in place.
+**/
+std::list<Planet *> Space::GetPlanetsInSpace(){
+    std::list<Planet *> planets;
+    BodySpan bodies = mBodies.GetBodiesOfType(BODY_PLANET);
+    for(const int* pIndex = bodies.begin(); pIndex != bodies.end(); pIndex++)
+    {
+        SpaceObject* pObject = mBodies.GetInfo(*pIndex).pObject;
+        if(pObject != 0)
+            planets.push_back(static_cast<Planet*>(pObject));
+    }
+    return planets;
+}
+
+/**
+    Name: GetMoonsInSpace()
+    Function: Returns a list of all moons in space, walking only the moons
+    in the body store. The list is a copy, GetBodiesOfType(BodyType) reads
+    them in place.
+**/
+std::list<Moon *> Space::GetMoonsInSpace(){
+    std::list<Moon *> moons;
+    BodySpan bodies = mBodies.GetBodiesOfType(BODY_MOON);
+    for(const int* pIndex = bodies.begin(); pIndex != bodies.end(); pIndex++)
+    {
+        SpaceObject* pObject = mBodies.GetInfo(*pIndex).pObject;
+        if(pObject != 0)
+            moons.push_back(static_cast<Moon*>(pObject));
     }
+    return moons;
 }
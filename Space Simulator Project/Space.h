@@ -18,7 +18,44 @@
 #include "Star.h"
 #include "Planet.h"
 #include "Moon.h"
+#include "BodyStore.h"
+#include "BarnesHut.h"
+#include "DirectGravity.h"
+#include "MixedGravity.h"
+#include "Collisions.h"
+#include "Integrator.h"
 #include <list>
+#include <vector>
+
+class TrajectorySink;
+
+//  the light sources of the fixed OpenGL pipeline handed out to the first
+//  stars
+const int LIGHT_SOURCE_COUNT = 8;
+
+//  the ways gravity can be calculated
+enum GravitySolver{
+    //  sum up the pull between every pair of bodies
+    GRAVITY_DIRECT,
+    //  approximate far away groups of bodies with a Barnes-Hut tree
+    GRAVITY_BARNES_HUT
+};
+
+//  the precision the pull of every pair is calculated in by the direct sum
+enum GravityPrecision{
+    //  everything in double precision
+    PRECISION_DOUBLE,
+    //  double precision positions with the pairs in single precision
+    PRECISION_MIXED
+};
+
+//  how far the forces of the chosen solver are from the double precision
+//  direct sum
+struct GravityError{
+    double              meanRelative;
+    double              rmsRelative;
+    double              maxRelative;
+};
 
 class Space{
     public:
@@ -26,6 +63,8 @@ class Space{
     //  constructs a space with the given integer as the amount of seconds to
     //  update when updating
     Space(int);
+    //  deletes the integrator of the space
+    ~Space();
     /** Member Functions   **/
     //  adds a planet to the objects and planets lists
     void                        AddObjectToSpace(Planet*);
@@ -33,34 +72,174 @@ class Space{
     void                        AddObjectToSpace(Star*);
     //  adds a moon to the objects and moons lists
     void                        AddObjectToSpace(Moon*);
+    //  adds a batch of planets, reserving room for all of them at once
+    void                        AddObjectsToSpace(std::vector<Planet*>&);
+    //  adds a batch of stars, reserving room for all of them at once
+    void                        AddObjectsToSpace(std::vector<Star*>&);
+    //  adds a batch of moons, reserving room for all of them at once
+    void                        AddObjectsToSpace(std::vector<Moon*>&);
+    //  makes room for the given amount of objects in total
+    void                        ReserveObjects(int);
     //  removes the last element created
     void                        PopObjectFromSpace();
-    //  calculates gravity between all elements in the objects list
+    //  removes the body the handle stands for and frees its object, false
+    //  if it was already removed
+    bool                        RemoveObjectFromSpace(BodyHandle);
+    //  removes all elements and frees them
+    void                        ClearObjects();
+    //  moves all bodies of the argument store into the space, without
+    //  any object of their own
+    void                        AddBodies(BodyStore&);
+    //  tells the space its body store was changed directly
+    void                        BodiesChanged();
+    //  calculates gravity between all elements in the objects list using
+    //  the chosen solver
     void                        CalculateGravity();
+    //  calculates the forces with both the chosen solver and the double
+    //  precision direct sum and returns how far apart they are, without
+    //  changing any force
+    GravityError                CompareGravitySolvers();
     //  calculates new positions for all elements in the objects list after a
     //  certain amount of time has passed
     void                        PassTime();
+    //  the same as PassTime() for the given amount of seconds
+    void                        PassTime(double);
+    //  moves all objects forward by one step with the chosen integrator,
+    //  merging the bodies that touch afterwards if collisions are on
+    void                        Step();
+    //  merges every group of touching bodies into its heaviest body and
+    //  returns the amount of bodies removed
+    int                         MergeCollisions();
+    //  sets the force on every body to zero
+    void                        ClearForces();
+    //  returns the kinetic plus potential energy of all bodies in joules
+    double                      CalculateEnergy();
     /** Getters and Setters **/
-    std::list<SpaceObject *>    GetObjectsInSpace()
-                                    {return mObjectsInSpace;}
-    std::list<Star *>           GetStarsInSpace()
-                                    {return mStarsInSpace;}
-    std::list<Planet *>         GetPlanetsInSpace()
-                                    {return mPlanetsInSpace;}
-    std::list<Moon *>           GetMoonsInSpace()
-                                    {return mMoonsInSpace;}
+    //  the indices of the bodies of the type in the body store, read in
+    //  place, valid until a body is added or removed
+    BodySpan                    GetBodiesOfType(BodyType type)
+                                    {return mBodies.GetBodiesOfType(type);}
+    //  copies of the objects of the bodies, leaving out bodies without one
+    std::list<SpaceObject *>    GetObjectsInSpace();
+    std::list<Star *>           GetStarsInSpace();
+    std::list<Planet *>         GetPlanetsInSpace();
+    std::list<Moon *>           GetMoonsInSpace();
+    BodyStore&                  GetBodies()
+                                    {return mBodies;}
+    GravitySolver               GetGravitySolver()
+                                    {return mGravitySolver;}
+    void                        SetGravitySolver(GravitySolver solver)
+                                    {mGravitySolver = solver;}
+    //  the precision of the direct sum, Barnes-Hut always uses doubles
+    GravityPrecision            GetGravityPrecision()
+                                    {return mGravityPrecision;}
+    void                        SetGravityPrecision(GravityPrecision
+                                                    precision)
+                                    {mGravityPrecision = precision;}
+    double                      GetOpeningAngle()
+                                    {return mBarnesHut.GetTheta();}
+    void                        SetOpeningAngle(double theta)
+                                    {mBarnesHut.SetTheta(theta);}
+    //  the amount of pulls summed up by the last gravity calculation
+    long long                   GetInteractionCount();
+    //  the amount of threads the direct sum is split over
+    int                         GetThreadCount()
+                                    {return mDirectGravity.GetThreadCount();}
+    void                        SetThreadCount(int threadCount)
+                                    {mDirectGravity.SetThreadCount(
+                                        threadCount);
+                                     mMixedGravity.SetThreadCount(
+                                        threadCount);}
+    //  the instruction set used by the direct sum
+    KernelLevel                 GetGravityKernel()
+                                    {return mDirectGravity.GetKernel();}
+    void                        SetGravityKernel(KernelLevel level)
+                                    {mDirectGravity.SetKernel(level);
+                                     mMixedGravity.SetKernel(level);}
+    //  the Plummer softening length in meters every solver adds to the
+    //  distance between two bodies, 0 for none
+    double                      GetSoftening()
+                                    {return mDirectGravity.GetSoftening();}
+    void                        SetSoftening(double);
+    //  whether touching bodies are merged after every step, off by default
+    bool                        GetMergeCollisions()
+                                    {return mMergeCollisions;}
+    void                        SetMergeCollisions(bool merge)
+                                    {mMergeCollisions = merge;}
+    //  the meters a radius of one stands for when finding collisions
+    double                      GetRadiusScale()
+                                    {return mCollisions.GetRadiusScale();}
+    void                        SetRadiusScale(double scale)
+                                    {mCollisions.SetRadiusScale(scale);}
+    //  when reporting, every calculation with an approximating solver or in
+    //  mixed precision also compares its forces with the double precision
+    //  direct sum
+    bool                        GetReportGravityError()
+                                    {return mReportGravityError;}
+    void                        SetReportGravityError(bool report)
+                                    {mReportGravityError = report;}
+    GravityError                GetGravityError()
+                                    {return mGravityError;}
+    IntegratorType              GetIntegratorType()
+                                    {return mIntegratorType;}
+    void                        SetIntegrator(IntegratorType);
+    Integrator*                 GetIntegrator()
+                                    {return mpIntegrator;}
     int                         GetTime()
                                     {return mTime;};
     void                        SetTime(int time)
                                     {mTime = time;}
+    TrajectorySink*             GetTrajectorySink()
+                                    {return mpTrajectorySink;}
+    //  records the bodies to the sink after every step from now on, 0
+    //  stops recording
+    void                        SetTrajectorySink(TrajectorySink*);
 
     private:
+    //  adds an object of the given type to the body store and binds it
+    void                        AddBody(SpaceObject*, BodyType);
+    //  removes the body at the given index and frees its object
+    void                        RemoveBody(int);
+    //  returns the lowest light source no star uses and marks it used, -1
+    //  if there is none
+    int                         TakeLightSource();
+    //  adds the force from every pair of bodies in double precision to the
+    //  argument arrays
+    void                        CalculateDirectGravity(double*, double*,
+                                                       double*);
+    //  adds the force from the chosen solver to the argument arrays
+    void                        CalculateSolverGravity(double*, double*,
+                                                       double*);
+
+    //  the space owns its integrator and can therefore not be copied
+    Space(const Space&);
+    Space&                      operator=(const Space&);
+
     /** Class Members   **/
-    std::list<SpaceObject *>    mObjectsInSpace;
-    std::list<Planet *>         mPlanetsInSpace;
-    std::list<Star *>           mStarsInSpace;
-    std::list<Moon *>           mMoonsInSpace;
+    BodyStore                   mBodies;
+    //  a bit for every light source a star is using, the lowest first
+    unsigned int                mUsedLights;
     int                         mTime;
+    GravitySolver               mGravitySolver;
+    BarnesHut                   mBarnesHut;
+    GravityPrecision            mGravityPrecision;
+    DirectGravity               mDirectGravity;
+    MixedGravity                mMixedGravity;
+    bool                        mMergeCollisions;
+    Collisions                  mCollisions;
+    IntegratorType              mIntegratorType;
+    Integrator*                 mpIntegrator;
+    bool                        mReportGravityError;
+    GravityError                mGravityError;
+    //  the sink the bodies are recorded to, owned by whoever set it
+    TrajectorySink*             mpTrajectorySink;
+    //  force arrays used when comparing solvers
+    std::vector<double>         mCompareFx;
+    std::vector<double>         mCompareFy;
+    std::vector<double>         mCompareFz;
+    std::vector<double>         mDirectFx;
+    std::vector<double>         mDirectFy;
+    std::vector<double>         mDirectFz;
 
 };
 
@@ -11,9 +11,50 @@
 *   create different types of objects by just inheriting this class
 *   and then adding the additional fucntionality in the new class.
 *
+*   NOTES: Objects of every type are taken from pools, one for every size
+*   in steps of 16 bytes, so that spawning and deleting objects reuses the
+*   same memory instead of calling the allocator every time and objects
+*   created together lie together. Objects larger than any pool are
+*   allocated as usual.
+*
 ****************************************************************************/
 
 #include "SpaceObject.h"
+#include "ObjectPool.h"
+#include <new>
+
+//  the pools hold objects up to POOL_COUNT*POOL_STEP bytes, one pool for
+//  every step
+const size_t POOL_STEP = 16;
+const int POOL_COUNT = 32;
+
+/**
+    Name: CreatePools()
+    Function: Creates a pool for every size step.
+**/
+static ObjectPool** CreatePools()
+{
+    ObjectPool** pPools = new ObjectPool*[POOL_COUNT];
+    for(int i = 0; i < POOL_COUNT; i++)
+        pPools[i] = new ObjectPool((i + 1)*POOL_STEP);
+    return pPools;
+}
+
+/**
+    Name: GetPool(size_t)
+    Function: Returns the pool for objects of the given size, or 0 if they
+    are too large for any pool. The pools are created on first use and
+    never destroyed, since objects may still be deleted while the program
+    ends.
+**/
+static ObjectPool* GetPool(size_t size)
+{
+    static ObjectPool** spPools = CreatePools();
+    const size_t step = (size + POOL_STEP - 1)/POOL_STEP;
+    if(step == 0 || step > (size_t)POOL_COUNT)
+        return 0;
+    return spPools[step - 1];
+}
 
 /****************************************************************************
  * Constructors
@@ -21,13 +62,13 @@
  ***************************************************************************/
 /**
     Name: SpaceObject(std::string, double, double,
-                      Coordinate, Coordinate,
+                      Vec3d, Vec3d,
                       float, float, float)
     Function: Creates a SpaceObject with a name string, mass and radius
     doubles, position and velocit coordinates and RGB floats.
 **/
 SpaceObject::SpaceObject(std::string name, double mass, double radius,
-                         Coordinate position, Coordinate velocity,
+                         Vec3d position, Vec3d velocity,
                          float red, float green, float blue)
 {
     mName = name;
@@ -36,8 +77,118 @@ SpaceObject::SpaceObject(std::string name, double mass, double radius,
     mPosition = position;
     mVelocity = velocity;
     //  force starts at neutral
-    mForce = Coordinate(0, 0);
+    mForce = Vec3d(0, 0);
     mRed = red;
     mGreen = green;
     mBlue = blue;
+    mpStore = 0;
+    mIndex = -1;
+}
+
+/****************************************************************************
+* Member Functions
+*
+****************************************************************************/
+
+/**
+    Name: Bind(BodyStore*, int)
+    Function: Binds the object to the body at the given index in the store.
+    From then on all getters and setters read and write the store, so that
+    the object and the store never disagree about the state of the body.
+**/
+void SpaceObject::Bind(BodyStore* pStore, int index)
+{
+    mpStore = pStore;
+    mIndex = index;
+}
+
+/**
+    Name: Unbind()
+    Function: Copies the state of the body back from the store to the
+    object's own members and releases the binding. Used when the body is
+    removed from the store but the object lives on.
+**/
+void SpaceObject::Unbind()
+{
+    if(mpStore == 0)
+        return;
+    BodyInfo& info = Info();
+    mName       = info.name;
+    mRadius     = info.radius;
+    mRed        = info.red;
+    mGreen      = info.green;
+    mBlue       = info.blue;
+    mMass       = mpStore->GetMass()[mIndex];
+    mPosition   = mpStore->GetPosition(mIndex);
+    mVelocity   = mpStore->GetVelocity(mIndex);
+    mForce      = mpStore->GetForce(mIndex);
+    mpStore     = 0;
+    mIndex      = -1;
+}
+
+/****************************************************************************
+* Memory
+*
+****************************************************************************/
+
+/**
+    Name: operator new(size_t)
+    Function: Takes the memory of an object of any type from the pool for
+    its size.
+**/
+void* SpaceObject::operator new(size_t size)
+{
+    ObjectPool* pPool = GetPool(size);
+    if(pPool == 0)
+        return ::operator new(size);
+    return pPool->Allocate();
+}
+
+/**
+    Name: operator delete(void*, size_t)
+    Function: Gives the memory of an object back to the pool for its size.
+    The destructor is virtual, so the size is that of the object's own
+    type even when deleted through a pointer to this class.
+**/
+void SpaceObject::operator delete(void* pObject, size_t size)
+{
+    ObjectPool* pPool = GetPool(size);
+    if(pPool == 0)
+        ::operator delete(pObject);
+    else
+        pPool->Free(pObject);
+}
+
+/**
+    Name: ReserveBlocks(size_t, int)
+    Function: Makes room in the pool for the given size for the given
+    amount of objects.
+**/
+void SpaceObject::ReserveBlocks(size_t size, int count)
+{
+    ObjectPool* pPool = GetPool(size);
+    if(pPool != 0)
+        pPool->Reserve(count);
+}
+
+/**
+    Name: GetPooledCount(size_t)
+    Function: Returns the amount of objects of the given size alive, 0 for
+    a size too large for the pools.
+**/
+int SpaceObject::GetPooledCount(size_t size)
+{
+    ObjectPool* pPool = GetPool(size);
+    return pPool != 0 ? pPool->GetUsedCount() : 0;
+}
+
+/**
+    Name: GetPoolCapacity(size_t)
+    Function: Returns the amount of objects of the given size that fit in
+    the memory taken by its pool so far.
+**/
+int SpaceObject::GetPoolCapacity(size_t size)
+{
+    ObjectPool* pPool = GetPool(size);
+    return pPool != 0 ? pPool->GetBlockCount() : 0;
 }
@@ -16,63 +16,127 @@
 #ifndef _SpaceObject_
 #define _SpaceObject_
 
-#include "Coordinate.h"
+#include "Vec.h"
+#include "BodyStore.h"
+#include <stddef.h>
 #include <string>
 
 class SpaceObject{
     public:
     /** Constructors    **/
     //  default constructor
-    SpaceObject(){};
+    SpaceObject(){mpStore = 0; mIndex = -1;};
     //  creates a SpaceObject with a name string, mass and radius
     //  doubles, position and velocit coordinates and RGB floats.
-    SpaceObject(std::string, double, double, Coordinate, Coordinate, float,
+    SpaceObject(std::string, double, double, Vec3d, Vec3d, float,
                 float, float);
+    //  objects of every type are deleted through a pointer to this class
+    virtual ~SpaceObject(){};
+    /** Memory  **/
+    //  takes the memory of an object from the pool for its size
+    static void*        operator new(size_t);
+    //  gives the memory of an object back to the pool for its size
+    static void         operator delete(void*, size_t);
+    //  makes room for the given amount of objects of the type, so that
+    //  creating a batch of them takes their memory from one piece
+    template<class T>
+    static void         Reserve(int count)
+                            {ReserveBlocks(sizeof(T), count);}
+    //  the amount of objects of the given size alive, and that fit in the
+    //  memory the pool for the size has taken so far
+    static int          GetPooledCount(size_t);
+    static int          GetPoolCapacity(size_t);
+    /** Member Functions    **/
+    //  lets the object read and write its state in the body store at the
+    //  given index instead of in its own members
+    void                Bind(BodyStore*, int);
+    //  copies the state back from the body store to the object's own members
+    void                Unbind();
     /** Getters and Setters **/
+    BodyStore*          GetStore()
+                            {return mpStore;}
+    int                 GetIndex()
+                            {return mIndex;}
+    void                SetIndex(int index)
+                            {mIndex = index;}
+    //  the handle of the body in the store, NO_BODY if not in one
+    BodyHandle          GetHandle()
+                            {return mpStore ? mpStore->GetHandle(mIndex)
+                                            : NO_BODY;}
     std::string         GetName()
-                            {return mName;}
+                            {return mpStore ? Info().name : mName;}
     void                SetName(std::string name)
-                            {mName = name;}
+                            {if(mpStore)
+                                mpStore->SetName(mIndex, name);
+                             else
+                                mName = name;}
     double              GetRadius()
-                            {return mRadius;}
+                            {return mpStore ? Info().radius : mRadius;}
     void                SetRadius(double radius)
-                            {mRadius = radius;}
+                            {(mpStore ? Info().radius : mRadius) = radius;}
     double              GetMass()
-                            {return mMass;}
+                            {return mpStore ? mpStore->GetMass()[mIndex]
+                                            : mMass;}
     void                SetMass(double mass)
-                            {mMass = mass;}
-    Coordinate          GetPosition()
-                            {return mPosition;}
-    void                SetPosition(Coordinate position)
-                            {mPosition = position;}
-    Coordinate          GetVelocity()
-                            {return mVelocity;}
-    void                SetVelocity(Coordinate velocity)
-                            {mVelocity = velocity;}
-    Coordinate          GetForce()
-                            {return mForce;}
-    void                SetForce(Coordinate force)
-                            {mForce = force;}
+                            {(mpStore ? mpStore->GetMass()[mIndex]
+                                      : mMass) = mass;}
+    Vec3d               GetPosition()
+                            {return mpStore ? mpStore->GetPosition(mIndex)
+                                            : mPosition;}
+    void                SetPosition(Vec3d position)
+                            {if(mpStore)
+                                mpStore->SetPosition(mIndex, position);
+                             else
+                                mPosition = position;}
+    Vec3d               GetVelocity()
+                            {return mpStore ? mpStore->GetVelocity(mIndex)
+                                            : mVelocity;}
+    void                SetVelocity(Vec3d velocity)
+                            {if(mpStore)
+                                mpStore->SetVelocity(mIndex, velocity);
+                             else
+                                mVelocity = velocity;}
+    Vec3d               GetForce()
+                            {return mpStore ? mpStore->GetForce(mIndex)
+                                            : mForce;}
+    void                SetForce(Vec3d force)
+                            {if(mpStore)
+                                mpStore->SetForce(mIndex, force);
+                             else
+                                mForce = force;}
     float               GetRed()
-                            {return mRed;}
+                            {return mpStore ? Info().red : mRed;}
     float               GetGreen()
-                            {return mGreen;}
+                            {return mpStore ? Info().green : mGreen;}
     float               GetBlue()
-                            {return mBlue;}
+                            {return mpStore ? Info().blue : mBlue;}
     void                SetColour(float red, float green, float blue)
-                            {mRed = red; mGreen = green; mBlue = blue;}
+                            {if(mpStore){
+                                Info().red = red; Info().green = green;
+                                Info().blue = blue;}
+                             else{
+                                mRed = red; mGreen = green; mBlue = blue;}}
 
     protected:
+    //  makes room for the given amount of objects of the given size
+    static void         ReserveBlocks(size_t, int);
+    //  the cold data of the body in the store
+    BodyInfo&           Info()
+                            {return mpStore->GetInfo(mIndex);}
+
     /** Class Members   **/
     std::string         mName;
     double              mRadius;
     double              mMass;
-    Coordinate          mPosition;
-    Coordinate          mVelocity;
-    Coordinate          mForce;
+    Vec3d               mPosition;
+    Vec3d               mVelocity;
+    Vec3d               mForce;
     float               mRed;
     float               mGreen;
     float               mBlue;
+    //  the store holding the state of the object once added to a space
+    BodyStore*          mpStore;
+    int                 mIndex;
 };
 
 #endif
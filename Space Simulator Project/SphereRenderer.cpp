@@ -0,0 +1,618 @@
+/****************************************************************************
+*   FILE: SphereRenderer.cpp
+*
+*   FUNCTION: This class draws spheres of any position, radius and colour.
+*   It keeps a few meshes of a unit sphere at different levels of detail on
+*   the graphics card and picks one for every sphere by how many pixels wide
+*   it is drawn. Where the GL supports shaders and instanced drawing, the
+*   spheres of a frame are collected, uploaded to a single vertex buffer
+*   once per frame and drawn with one call per level of detail, lit by the
+*   stars in a shader. Otherwise every mesh is kept in a display list that
+*   the caller draws one sphere at a time. Spheres smaller than a pixel
+*   are collected as points and drawn together in a single call.
+*
+*   PURPOSE: Tessellating a sphere of 80 by 80 segments for every body
+*   every frame keeps the processor busy with triangles nobody can tell
+*   apart, and caps the amount of bodies that can be drawn at a few hundred.
+*   A far away body needs only a handful of triangles, and one call drawing
+*   thousands of copies of a mesh costs about as much as drawing one.
+*
+*   NOTES: The instanced path only needs OpenGL 2.0 with the
+*   ARB_instanced_arrays, ARB_draw_instanced and ARB_uniform_buffer_object
+*   extensions, which Mesa's software renderer has, so it also runs on
+*   machines without a graphics card. The functions beyond OpenGL 1.1 are
+*   looked up through the function given to Init(), since on Windows they
+*   cannot be linked to.
+*
+*   The shader lights a sphere like the fixed pipeline lit the bodies
+*   before: a fifth of its colour as ambient light plus the diffuse light
+*   of every star, and a star from the front, as if lit by the viewer.
+*   The stars are read from a single uniform buffer, which holds as many
+*   as the GL allows in a uniform block, up to 1024, instead of the 8
+*   light sources of the fixed pipeline. The GL guarantees 16 kilobytes,
+*   which is 512 stars.
+*
+****************************************************************************/
+
+#include "SphereRenderer.h"
+#include <GL/glext.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//  the segments around every level of detail, the segments from pole to
+//  pole are half as many
+const int LEVEL_SLICES[SPHERE_LEVEL_COUNT] = {8, 16, 32, 64};
+//  the largest radius in pixels drawn with every level but the finest
+const double LEVEL_PIXELS[SPHERE_LEVEL_COUNT - 1] = {4, 16, 48};
+//  the attribute locations of the shader
+const GLuint VERTEX_ATTRIBUTE = 0;
+const GLuint BODY_ATTRIBUTE = 1;
+const GLuint COLOUR_ATTRIBUTE = 2;
+//  the uniform buffer binding the stars are read from
+const GLuint STARS_BINDING = 0;
+//  the most stars the shader is made for, however large a uniform block
+//  the GL allows
+const int MAX_STARS = 1024;
+
+//  the functions beyond OpenGL 1.1, looked up by Init()
+static PFNGLCREATESHADERPROC            pglCreateShader;
+static PFNGLSHADERSOURCEPROC            pglShaderSource;
+static PFNGLCOMPILESHADERPROC           pglCompileShader;
+static PFNGLGETSHADERIVPROC             pglGetShaderiv;
+static PFNGLDELETESHADERPROC            pglDeleteShader;
+static PFNGLCREATEPROGRAMPROC           pglCreateProgram;
+static PFNGLATTACHSHADERPROC            pglAttachShader;
+static PFNGLBINDATTRIBLOCATIONPROC      pglBindAttribLocation;
+static PFNGLLINKPROGRAMPROC             pglLinkProgram;
+static PFNGLGETPROGRAMIVPROC            pglGetProgramiv;
+static PFNGLUSEPROGRAMPROC              pglUseProgram;
+static PFNGLGETUNIFORMLOCATIONPROC      pglGetUniformLocation;
+static PFNGLUNIFORM1IPROC               pglUniform1i;
+static PFNGLGETUNIFORMBLOCKINDEXPROC   pglGetUniformBlockIndex;
+static PFNGLUNIFORMBLOCKBINDINGPROC     pglUniformBlockBinding;
+static PFNGLBINDBUFFERBASEPROC          pglBindBufferBase;
+static PFNGLGENBUFFERSPROC              pglGenBuffers;
+static PFNGLBINDBUFFERPROC              pglBindBuffer;
+static PFNGLBUFFERDATAPROC              pglBufferData;
+static PFNGLBUFFERSUBDATAPROC           pglBufferSubData;
+static PFNGLENABLEVERTEXATTRIBARRAYPROC pglEnableVertexAttribArray;
+static PFNGLDISABLEVERTEXATTRIBARRAYPROC pglDisableVertexAttribArray;
+static PFNGLVERTEXATTRIBPOINTERPROC     pglVertexAttribPointer;
+static PFNGLVERTEXATTRIBDIVISORARBPROC  pglVertexAttribDivisor;
+static PFNGLDRAWELEMENTSINSTANCEDARBPROC pglDrawElementsInstanced;
+
+//  moves the unit sphere to the body and passes on what the lighting needs
+static const char* VERTEX_SHADER =
+    "#version 120\n"
+    "attribute vec3 vertex;\n"
+    "attribute vec4 body;\n"
+    "attribute vec4 colour;\n"
+    "varying vec3 normal;\n"
+    "varying vec3 eyeNormal;\n"
+    "varying vec3 position;\n"
+    "varying vec4 tint;\n"
+    "void main()\n"
+    "{\n"
+    "    normal = vertex;\n"
+    "    eyeNormal = gl_NormalMatrix*vertex;\n"
+    "    position = body.xyz + vertex*body.w;\n"
+    "    tint = colour;\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix*\n"
+    "                  vec4(position, 1.0);\n"
+    "}\n";
+
+//  the start of the fragment shader, which is given the amount of stars
+//  the buffer holds
+static const char* FRAGMENT_SHADER_HEADER =
+    "#version 120\n"
+    "#extension GL_ARB_uniform_buffer_object : require\n"
+    "#define MAX_STARS %d\n";
+
+//  lights a body by every star in its colour, or a star by the viewer
+static const char* FRAGMENT_SHADER =
+    "layout(std140) uniform Stars\n"
+    "{\n"
+    "    vec4 stars[2*MAX_STARS];\n"
+    "};\n"
+    "uniform int starCount;\n"
+    "varying vec3 normal;\n"
+    "varying vec3 eyeNormal;\n"
+    "varying vec3 position;\n"
+    "varying vec4 tint;\n"
+    "void main()\n"
+    "{\n"
+    "    vec3 light = vec3(0.0);\n"
+    "    if(tint.a < 0.5)\n"
+    "        light = vec3(max(normalize(eyeNormal).z, 0.0));\n"
+    "    else\n"
+    "    {\n"
+    "        vec3 n = normalize(normal);\n"
+    "        for(int i = 0; i < MAX_STARS; i++)\n"
+    "        {\n"
+    "            if(i >= starCount)\n"
+    "                break;\n"
+    "            vec3 towards = normalize(stars[2*i].xyz - position);\n"
+    "            light += stars[2*i + 1].rgb*max(dot(n, towards), 0.0);\n"
+    "        }\n"
+    "    }\n"
+    "    vec3 lit = clamp(tint.rgb*(0.2 + light), 0.0, 1.0);\n"
+    "    gl_FragColor = vec4(lit, 1.0);\n"
+    "}\n";
+
+/**
+    Name: HasExtension(const char*)
+    Function: Returns true if the current GL names the extension among its
+    extensions. The name has to match a whole word of the list.
+**/
+static bool HasExtension(const char* pName)
+{
+    const char* pList = (const char*)glGetString(GL_EXTENSIONS);
+    if(pList == 0)
+        return false;
+    const size_t length = strlen(pName);
+    for(const char* p = strstr(pList, pName); p != 0;
+        p = strstr(p + length, pName))
+    {
+        if((p == pList || p[-1] == ' ') &&
+           (p[length] == ' ' || p[length] == 0))
+            return true;
+    }
+    return false;
+}
+
+/**
+    Name: LoadFunctions(GlProcLoader)
+    Function: Looks up every function of the instanced path with the loader
+    and returns false if any is missing. The instancing functions are tried
+    with and without their extension suffix.
+**/
+static bool LoadFunctions(GlProcLoader load)
+{
+    #define LOAD(pointer, name) \
+        pointer = (decltype(pointer))load(name); \
+        if(pointer == 0) \
+            return false;
+    LOAD(pglCreateShader,               "glCreateShader");
+    LOAD(pglShaderSource,               "glShaderSource");
+    LOAD(pglCompileShader,              "glCompileShader");
+    LOAD(pglGetShaderiv,                "glGetShaderiv");
+    LOAD(pglDeleteShader,               "glDeleteShader");
+    LOAD(pglCreateProgram,              "glCreateProgram");
+    LOAD(pglAttachShader,               "glAttachShader");
+    LOAD(pglBindAttribLocation,         "glBindAttribLocation");
+    LOAD(pglLinkProgram,                "glLinkProgram");
+    LOAD(pglGetProgramiv,               "glGetProgramiv");
+    LOAD(pglUseProgram,                 "glUseProgram");
+    LOAD(pglGetUniformLocation,         "glGetUniformLocation");
+    LOAD(pglUniform1i,                  "glUniform1i");
+    LOAD(pglGetUniformBlockIndex,       "glGetUniformBlockIndex");
+    LOAD(pglUniformBlockBinding,        "glUniformBlockBinding");
+    LOAD(pglBindBufferBase,             "glBindBufferBase");
+    LOAD(pglGenBuffers,                 "glGenBuffers");
+    LOAD(pglBindBuffer,                 "glBindBuffer");
+    LOAD(pglBufferData,                 "glBufferData");
+    LOAD(pglBufferSubData,              "glBufferSubData");
+    LOAD(pglEnableVertexAttribArray,    "glEnableVertexAttribArray");
+    LOAD(pglDisableVertexAttribArray,   "glDisableVertexAttribArray");
+    LOAD(pglVertexAttribPointer,        "glVertexAttribPointer");
+    #undef LOAD
+    pglVertexAttribDivisor = (PFNGLVERTEXATTRIBDIVISORARBPROC)
+        load("glVertexAttribDivisorARB");
+    if(pglVertexAttribDivisor == 0)
+        pglVertexAttribDivisor = (PFNGLVERTEXATTRIBDIVISORARBPROC)
+            load("glVertexAttribDivisor");
+    pglDrawElementsInstanced = (PFNGLDRAWELEMENTSINSTANCEDARBPROC)
+        load("glDrawElementsInstancedARB");
+    if(pglDrawElementsInstanced == 0)
+        pglDrawElementsInstanced = (PFNGLDRAWELEMENTSINSTANCEDARBPROC)
+            load("glDrawElementsInstanced");
+    return pglVertexAttribDivisor != 0 && pglDrawElementsInstanced != 0;
+}
+
+/****************************************************************************
+* Constructors
+*
+****************************************************************************/
+
+/**
+    Name: SphereRenderer()
+    Function: Constructs a renderer without any meshes. No GL function is
+    called, so it can be constructed before there is a GL context.
+**/
+SphereRenderer::SphereRenderer()
+{
+    mInstanced = false;
+    mPixelsPerUnit = 0;
+    for(int i = 0; i < SPHERE_LEVEL_COUNT; i++)
+    {
+        mFirstIndex[i] = 0;
+        mIndexCount[i] = 0;
+    }
+    mDisplayLists = 0;
+    mProgram = 0;
+    mStarCountUniform = -1;
+    mVertexBuffer = 0;
+    mIndexBuffer = 0;
+    mInstanceBuffer = 0;
+    mInstanceCapacity = 0;
+    mStarBuffer = 0;
+    mStarCount = 0;
+    mMaxStars = 0;
+}
+
+/****************************************************************************
+* Member Functions
+*
+****************************************************************************/
+
+/**
+    Name: Init(GlProcLoader)
+    Function: Makes the meshes of every level and a display list for each of
+    them. If the current GL is at least version 2.0 with instanced arrays,
+    instanced drawing and uniform buffers, and the shader compiles, the
+    meshes are put into vertex buffers as well and the spheres are drawn
+    instanced from then on.
+**/
+void SphereRenderer::Init(GlProcLoader load)
+{
+    std::vector<float> vertices;
+    std::vector<unsigned short> indices;
+    MakeMeshes(vertices, indices);
+    MakeDisplayLists(vertices, indices);
+    //  the version starts with the major number, also in OpenGL ES
+    const char* pVersion = (const char*)glGetString(GL_VERSION);
+    mInstanced = load != 0 && pVersion != 0 && atoi(pVersion) >= 2 &&
+                 HasExtension("GL_ARB_instanced_arrays") &&
+                 HasExtension("GL_ARB_draw_instanced") &&
+                 HasExtension("GL_ARB_uniform_buffer_object") &&
+                 LoadFunctions(load) && MakeProgram();
+    if(!mInstanced)
+        return;
+    /*  START: Upload the meshes    */
+    pglGenBuffers(1, &mVertexBuffer);
+    pglBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
+    pglBufferData(GL_ARRAY_BUFFER, vertices.size()*sizeof(float),
+                  &vertices[0], GL_STATIC_DRAW);
+    pglGenBuffers(1, &mIndexBuffer);
+    pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBuffer);
+    pglBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                  indices.size()*sizeof(unsigned short), &indices[0],
+                  GL_STATIC_DRAW);
+    pglGenBuffers(1, &mInstanceBuffer);
+    pglGenBuffers(1, &mStarBuffer);
+    pglBindBuffer(GL_ARRAY_BUFFER, 0);
+    pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    /*  END: Upload the meshes  */
+}
+
+/**
+    Name: MakeMeshes(std::vector<float>&, std::vector<unsigned short>&)
+    Function: Appends a unit sphere for every level to the vertex array, as
+    x, y and z, which are its normal as well, and its triangles to the index
+    array, remembering where the triangles of every level start. The
+    indices count through the vertices of all levels, which together have
+    to fit in an unsigned short.
+**/
+void SphereRenderer::MakeMeshes(std::vector<float>& vertices,
+                                std::vector<unsigned short>& indices)
+{
+    const double pi = 3.14159265358979323846;
+    for(int level = 0; level < SPHERE_LEVEL_COUNT; level++)
+    {
+        const int slices = LEVEL_SLICES[level];
+        const int stacks = slices/2;
+        const int base = vertices.size()/3;
+        for(int i = 0; i <= stacks; i++)
+        {
+            const double polar = pi*i/stacks;
+            for(int j = 0; j <= slices; j++)
+            {
+                const double around = 2*pi*j/slices;
+                vertices.push_back(sin(polar)*cos(around));
+                vertices.push_back(sin(polar)*sin(around));
+                vertices.push_back(cos(polar));
+            }
+        }
+        mFirstIndex[level] = indices.size();
+        for(int i = 0; i < stacks; i++)
+        {
+            for(int j = 0; j < slices; j++)
+            {
+                const int a = base + i*(slices + 1) + j;
+                const int b = a + slices + 1;
+                indices.push_back(a);
+                indices.push_back(b);
+                indices.push_back(a + 1);
+                indices.push_back(a + 1);
+                indices.push_back(b);
+                indices.push_back(b + 1);
+            }
+        }
+        mIndexCount[level] = indices.size() - mFirstIndex[level];
+    }
+}
+
+/**
+    Name: MakeDisplayLists(const std::vector<float>&,
+                           const std::vector<unsigned short>&)
+    Function: Compiles the triangles of every level into a display list
+    with the vertex as its own normal.
+**/
+void SphereRenderer::MakeDisplayLists(
+    const std::vector<float>& vertices,
+    const std::vector<unsigned short>& indices)
+{
+    mDisplayLists = glGenLists(SPHERE_LEVEL_COUNT);
+    for(int level = 0; level < SPHERE_LEVEL_COUNT; level++)
+    {
+        glNewList(mDisplayLists + level, GL_COMPILE);
+        glBegin(GL_TRIANGLES);
+        for(int i = 0; i < mIndexCount[level]; i++)
+        {
+            const float* pVertex =
+                &vertices[3*indices[mFirstIndex[level] + i]];
+            glNormal3fv(pVertex);
+            glVertex3fv(pVertex);
+        }
+        glEnd();
+        glEndList();
+    }
+}
+
+/**
+    Name: MakeProgram()
+    Function: Compiles the vertex and fragment shader, links them with the
+    attribute locations the buffers are bound to and finds the uniforms.
+    Returns false if any step fails.
+**/
+bool SphereRenderer::MakeProgram()
+{
+    //  every star takes two vectors of four floats in the uniform block
+    GLint blockSize = 0;
+    glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &blockSize);
+    mMaxStars = blockSize/(int)(STAR_FLOATS*sizeof(float));
+    if(mMaxStars > MAX_STARS)
+        mMaxStars = MAX_STARS;
+    if(mMaxStars < 1)
+        return false;
+    char header[128];
+    snprintf(header, sizeof(header), FRAGMENT_SHADER_HEADER, mMaxStars);
+    const char* pSources[2][2] = {{VERTEX_SHADER, ""},
+                                  {header, FRAGMENT_SHADER}};
+    const GLenum types[] = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER};
+    mProgram = pglCreateProgram();
+    for(int i = 0; i < 2; i++)
+    {
+        GLuint shader = pglCreateShader(types[i]);
+        pglShaderSource(shader, 2, pSources[i], 0);
+        pglCompileShader(shader);
+        GLint compiled = GL_FALSE;
+        pglGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+        if(compiled != GL_TRUE)
+        {
+            pglDeleteShader(shader);
+            return false;
+        }
+        pglAttachShader(mProgram, shader);
+        //  the shader is only deleted once the program is
+        pglDeleteShader(shader);
+    }
+    pglBindAttribLocation(mProgram, VERTEX_ATTRIBUTE, "vertex");
+    pglBindAttribLocation(mProgram, BODY_ATTRIBUTE, "body");
+    pglBindAttribLocation(mProgram, COLOUR_ATTRIBUTE, "colour");
+    pglLinkProgram(mProgram);
+    GLint linked = GL_FALSE;
+    pglGetProgramiv(mProgram, GL_LINK_STATUS, &linked);
+    if(linked != GL_TRUE)
+        return false;
+    const GLuint block = pglGetUniformBlockIndex(mProgram, "Stars");
+    if(block == GL_INVALID_INDEX)
+        return false;
+    pglUniformBlockBinding(mProgram, block, STARS_BINDING);
+    mStarCountUniform = pglGetUniformLocation(mProgram, "starCount");
+    return true;
+}
+
+/**
+    Name: Begin()
+    Function: Starts a frame. The viewport shows two window units from the
+    bottom to the top edge, so its height gives the pixels per unit. The
+    spheres of the last frame and their points are forgotten, but their
+    memory is kept.
+**/
+void SphereRenderer::Begin()
+{
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    mPixelsPerUnit = viewport[3]/2.0;
+    for(int i = 0; i < SPHERE_LEVEL_COUNT; i++)
+        mInstances[i].clear();
+    mPoints.clear();
+}
+
+/**
+    Name: ChooseLevel(double)
+    Function: Returns the coarsest level that still looks round for a
+    sphere of the given radius in window units, by the amount of pixels
+    its radius covers this frame.
+**/
+int SphereRenderer::ChooseLevel(double radius)
+{
+    const double pixels = radius*mPixelsPerUnit;
+    int level = 0;
+    while(level < SPHERE_LEVEL_COUNT - 1 && pixels > LEVEL_PIXELS[level])
+        level++;
+    return level;
+}
+
+/**
+    Name: DrawMesh(int)
+    Function: Draws the display list of the given level.
+**/
+void SphereRenderer::DrawMesh(int level)
+{
+    glCallList(mDisplayLists + level);
+}
+
+/**
+    Name: SetStars(const float*, int)
+    Function: Uploads the given stars to the star buffer, or as many of
+    them as the shader holds. The buffer is given new storage every frame,
+    like the instance buffer, so that the GL does not have to wait for the
+    last frame to be drawn.
+**/
+void SphereRenderer::SetStars(const float* pStars, int count)
+{
+    if(!mInstanced)
+        return;
+    mStarCount = count < mMaxStars ? count : mMaxStars;
+    pglBindBuffer(GL_UNIFORM_BUFFER, mStarBuffer);
+    pglBufferData(GL_UNIFORM_BUFFER, mMaxStars*STAR_FLOATS*sizeof(float),
+                  0, GL_STREAM_DRAW);
+    if(mStarCount > 0)
+        pglBufferSubData(GL_UNIFORM_BUFFER, 0,
+                         mStarCount*STAR_FLOATS*sizeof(float), pStars);
+    pglBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+/**
+    Name: Add(double, double, double, double, float, float, float, bool)
+    Function: Adds a sphere to the spheres of its level this frame. The
+    flag tells whether it is lit by the stars, a star is lit from the front.
+**/
+void SphereRenderer::Add(double x, double y, double z, double radius,
+                         float red, float green, float blue, bool lit)
+{
+    std::vector<float>& spheres = mInstances[ChooseLevel(radius)];
+    const float sphere[FLOATS_PER_SPHERE] = {(float)x, (float)y, (float)z,
+                                             (float)radius, red, green,
+                                             blue, lit ? 1.0f : 0.0f};
+    spheres.insert(spheres.end(), sphere, sphere + FLOATS_PER_SPHERE);
+}
+
+/**
+    Name: AddPoint(double, double, double, float, float, float)
+    Function: Adds a point of the given colour to the points drawn this
+    frame.
+**/
+void SphereRenderer::AddPoint(double x, double y, double z, float red,
+                              float green, float blue)
+{
+    const float point[FLOATS_PER_POINT] = {(float)x, (float)y, (float)z,
+                                           red, green, blue};
+    mPoints.insert(mPoints.end(), point, point + FLOATS_PER_POINT);
+}
+
+/**
+    Name: End()
+    Function: Draws the spheres added this frame if they are drawn
+    instanced, and then all points added this frame.
+**/
+void SphereRenderer::End()
+{
+    if(mInstanced)
+        DrawInstances();
+    DrawPoints();
+}
+
+/**
+    Name: DrawInstances()
+    Function: Uploads the spheres of all levels to the instance buffer and
+    draws every level with one instanced call. The buffer is given new
+    storage every frame, so that the GL does not have to wait until the
+    last frame is drawn before overwriting it, and only grows when the
+    spheres no longer fit.
+**/
+void SphereRenderer::DrawInstances()
+{
+    long total = 0;
+    for(int i = 0; i < SPHERE_LEVEL_COUNT; i++)
+        total += mInstances[i].size()*sizeof(float);
+    if(total == 0)
+        return;
+    /*  START: Upload the spheres   */
+    pglBindBuffer(GL_ARRAY_BUFFER, mInstanceBuffer);
+    if(total > mInstanceCapacity)
+        mInstanceCapacity = total > 2*mInstanceCapacity ? total
+                                                        : 2*mInstanceCapacity;
+    pglBufferData(GL_ARRAY_BUFFER, mInstanceCapacity, 0, GL_STREAM_DRAW);
+    long offset = 0;
+    for(int i = 0; i < SPHERE_LEVEL_COUNT; i++)
+    {
+        const long size = mInstances[i].size()*sizeof(float);
+        if(size > 0)
+            pglBufferSubData(GL_ARRAY_BUFFER, offset, size,
+                             &mInstances[i][0]);
+        offset += size;
+    }
+    /*  END: Upload the spheres */
+    /*  START: Draw every level */
+    pglUseProgram(mProgram);
+    pglBindBufferBase(GL_UNIFORM_BUFFER, STARS_BINDING, mStarBuffer);
+    pglUniform1i(mStarCountUniform, mStarCount);
+    pglBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
+    pglEnableVertexAttribArray(VERTEX_ATTRIBUTE);
+    pglVertexAttribPointer(VERTEX_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBuffer);
+    pglBindBuffer(GL_ARRAY_BUFFER, mInstanceBuffer);
+    pglEnableVertexAttribArray(BODY_ATTRIBUTE);
+    pglEnableVertexAttribArray(COLOUR_ATTRIBUTE);
+    pglVertexAttribDivisor(BODY_ATTRIBUTE, 1);
+    pglVertexAttribDivisor(COLOUR_ATTRIBUTE, 1);
+    const GLsizei stride = FLOATS_PER_SPHERE*sizeof(float);
+    offset = 0;
+    for(int i = 0; i < SPHERE_LEVEL_COUNT; i++)
+    {
+        const int count = mInstances[i].size()/FLOATS_PER_SPHERE;
+        if(count > 0)
+        {
+            pglVertexAttribPointer(BODY_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE,
+                                   stride, (const char*)0 + offset);
+            pglVertexAttribPointer(COLOUR_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE,
+                                   stride, (const char*)0 + offset +
+                                   4*sizeof(float));
+            pglDrawElementsInstanced(GL_TRIANGLES, mIndexCount[i],
+                                     GL_UNSIGNED_SHORT,
+                                     (const char*)0 + mFirstIndex[i]*
+                                     sizeof(unsigned short), count);
+        }
+        offset += count*stride;
+    }
+    //  the divisors are kept by the GL, other drawing must not inherit them
+    pglVertexAttribDivisor(BODY_ATTRIBUTE, 0);
+    pglVertexAttribDivisor(COLOUR_ATTRIBUTE, 0);
+    pglDisableVertexAttribArray(VERTEX_ATTRIBUTE);
+    pglDisableVertexAttribArray(BODY_ATTRIBUTE);
+    pglDisableVertexAttribArray(COLOUR_ATTRIBUTE);
+    pglBindBuffer(GL_ARRAY_BUFFER, 0);
+    pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    pglUseProgram(0);
+    /*  END: Draw every level   */
+}
+
+/**
+    Name: DrawPoints()
+    Function: Draws all points of this frame with a single call, straight
+    from memory and without lighting, since a point has no side facing
+    away from the stars.
+**/
+void SphereRenderer::DrawPoints()
+{
+    if(mPoints.empty())
+        return;
+    const GLboolean lighting = glIsEnabled(GL_LIGHTING);
+    glDisable(GL_LIGHTING);
+    glPointSize(1.0f);
+    const GLsizei stride = FLOATS_PER_POINT*sizeof(float);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, stride, &mPoints[0]);
+    glColorPointer(3, GL_FLOAT, stride, &mPoints[3]);
+    glDrawArrays(GL_POINTS, 0, mPoints.size()/FLOATS_PER_POINT);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_COLOR_ARRAY);
+    if(lighting)
+        glEnable(GL_LIGHTING);
+}
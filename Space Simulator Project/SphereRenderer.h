@@ -0,0 +1,148 @@
+/****************************************************************************
+*   FILE: SphereRenderer.h
+*
+*   FUNCTION: This class draws spheres of any position, radius and colour.
+*   It keeps a few meshes of a unit sphere at different levels of detail on
+*   the graphics card and picks one for every sphere by how many pixels wide
+*   it is drawn. Where the GL supports shaders and instanced drawing, the
+*   spheres of a frame are collected, uploaded to a single vertex buffer
+*   once per frame and drawn with one call per level of detail, lit by the
+*   stars in a shader. Otherwise every mesh is kept in a display list that
+*   the caller draws one sphere at a time. Spheres smaller than a pixel
+*   are collected as points and drawn together in a single call.
+*
+*   PURPOSE: Tessellating a sphere of 80 by 80 segments for every body
+*   every frame keeps the processor busy with triangles nobody can tell
+*   apart, and caps the amount of bodies that can be drawn at a few hundred.
+*   A far away body needs only a handful of triangles, and one call drawing
+*   thousands of copies of a mesh costs about as much as drawing one.
+*
+*   NOTES: The instanced path only needs OpenGL 2.0 with the
+*   ARB_instanced_arrays, ARB_draw_instanced and ARB_uniform_buffer_object
+*   extensions, which Mesa's software renderer has, so it also runs on
+*   machines without a graphics card. The functions beyond OpenGL 1.1 are
+*   looked up through the function given to Init(), since on Windows they
+*   cannot be linked to.
+*
+****************************************************************************/
+
+#ifndef _SphereRenderer_
+#define _SphereRenderer_
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/gl.h>
+#include <vector>
+
+//  the amount of levels of detail, from coarse to fine
+const int SPHERE_LEVEL_COUNT = 4;
+
+//  the floats of every star handed to SetStars()
+const int STAR_FLOATS = 8;
+
+//  returns the address of the GL function with the given name, 0 if there
+//  is none
+typedef void* (*GlProcLoader)(const char*);
+
+class SphereRenderer{
+    public:
+    /** Constructors    **/
+    //  constructs a renderer without any meshes, Init() makes them
+    SphereRenderer();
+    /** Member Functions   **/
+    //  makes the meshes and, if the current GL supports it, the shader and
+    //  buffers for instanced drawing, looking functions up with the loader
+    void                Init(GlProcLoader);
+    //  starts a frame, reading the size of the viewport and forgetting the
+    //  spheres of the last frame
+    void                Begin();
+    //  returns the level of detail for a sphere of the given radius in
+    //  window units this frame
+    int                 ChooseLevel(double);
+    //  draws the unit sphere of the given level at the current matrix,
+    //  with the current colour and lighting
+    void                DrawMesh(int);
+    //  sets the given amount of stars lighting the instanced spheres, as
+    //  STAR_FLOATS floats each: x, y and z in window units, one unused,
+    //  then the red, green and blue of its light and one unused
+    void                SetStars(const float*, int);
+    //  adds a sphere at the given position with the given radius in window
+    //  units and the given colour, lit by the stars or, if the flag is not
+    //  set, by itself, to be drawn instanced by End()
+    void                Add(double, double, double, double, float, float,
+                            float, bool);
+    //  adds a point of the given colour at the given position in window
+    //  units, for a sphere smaller than a pixel
+    void                AddPoint(double, double, double, float, float,
+                                 float);
+    //  draws all spheres added since Begin() if they are drawn instanced,
+    //  and all points added since Begin()
+    void                End();
+    /** Getters and Setters **/
+    //  true if the spheres are drawn instanced with Add() and End(),
+    //  otherwise they have to be drawn one by one with DrawMesh()
+    bool                IsInstanced()
+                            {return mInstanced;}
+    //  the most stars SetStars() passes on to the shader
+    int                 GetMaxStars()
+                            {return mMaxStars;}
+    //  the window pixels per window unit in the current frame
+    double              GetPixelsPerUnit()
+                            {return mPixelsPerUnit;}
+    //  the amount of spheres of the given level drawn by the last End()
+    int                 GetInstanceCount(int level)
+                            {return mInstances[level].size()/
+                                    FLOATS_PER_SPHERE;}
+    //  the amount of points drawn by the last End()
+    int                 GetPointCount()
+                            {return mPoints.size()/FLOATS_PER_POINT;}
+
+    private:
+    //  the floats kept for every sphere: position and radius, colour and
+    //  whether it is lit by the stars
+    static const int    FLOATS_PER_SPHERE = 8;
+    //  the floats kept for every point: position and colour
+    static const int    FLOATS_PER_POINT = 6;
+
+    //  fills the vertex and index arrays with unit spheres of every level
+    void                MakeMeshes(std::vector<float>&,
+                                   std::vector<unsigned short>&);
+    //  makes a display list drawing every mesh
+    void                MakeDisplayLists(const std::vector<float>&,
+                                         const std::vector<unsigned short>&);
+    //  compiles and links the shader, returns false if it fails
+    bool                MakeProgram();
+    //  uploads the spheres of this frame and draws them instanced
+    void                DrawInstances();
+    //  draws the points of this frame in one call
+    void                DrawPoints();
+
+    /** Class Members   **/
+    bool                mInstanced;
+    //  the window pixels per window unit in the current frame
+    double              mPixelsPerUnit;
+    //  the first index and the amount of indices of every level in the
+    //  index buffer
+    int                 mFirstIndex[SPHERE_LEVEL_COUNT];
+    int                 mIndexCount[SPHERE_LEVEL_COUNT];
+    GLuint              mDisplayLists;
+    //  the shader, its uniforms and the buffers of the instanced path
+    GLuint              mProgram;
+    GLint               mStarCountUniform;
+    GLuint              mVertexBuffer;
+    GLuint              mIndexBuffer;
+    GLuint              mInstanceBuffer;
+    //  the bytes the instance buffer holds
+    long                mInstanceCapacity;
+    //  the spheres added this frame, sorted by level
+    std::vector<float>  mInstances[SPHERE_LEVEL_COUNT];
+    //  the points added this frame
+    std::vector<float>  mPoints;
+    //  the buffer of the stars, the stars in it and the most it can hold
+    GLuint              mStarBuffer;
+    int                 mStarCount;
+    int                 mMaxStars;
+};
+
+#endif
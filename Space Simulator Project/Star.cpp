@@ -17,14 +17,14 @@
  ***************************************************************************/
 
 /**
-    Name: Star(std::string, double, double, Coordinate, Coordinate,
+    Name: Star(std::string, double, double, Vec3d, Vec3d,
                  float, float, float)
     Function: Creates a star with a name string, mass and radius doubles,
     position and velocity coordinates and RGB floats.
 **/
 Star::Star(
          std::string name, double mass, double radius,
-         Coordinate position, Coordinate velocity,
+         Vec3d position, Vec3d velocity,
          float red, float green, float blue)
 {
     mName           = name;
@@ -32,8 +32,10 @@ Star::Star(
     mRadius         = radius;
     mPosition       = position;
     mVelocity       = velocity;
-    mForce          = Coordinate(0, 0); //force starts at neutral
+    mForce          = Vec3d(0, 0); //force starts at neutral
     mRed            = red;
     mGreen          = green;
     mBlue           = blue;
+    //  no light is emitted until the star is given a light source
+    mLightSource    = 0;
 }
@@ -20,15 +20,16 @@ class Star : public SpaceObject{
     //  constructs a star with a name string, mass double, radius double,
     //  position coordinate, velocity coordinate and RGB floats
     Star(std::string, double, double,
-         Coordinate, Coordinate,
+         Vec3d, Vec3d,
          float, float, float);
     /** Getters and Setters **/
     unsigned int GetLightSource()
-                    {return mLightSource;}
+                    {return mpStore ? Info().lightSource : mLightSource;}
     void SetLightSource(unsigned int sourceId)
                     //  16384 is the integer where the glut enumerators for light
                     //  sources start
-                    {mLightSource = 16384+sourceId;}
+                    {(mpStore ? Info().lightSource : mLightSource) =
+                        16384+sourceId;}
     private:
     /** Class Members   **/
     unsigned int mLightSource;
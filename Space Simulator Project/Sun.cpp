@@ -2,7 +2,7 @@
 
 Sun::Sun(
          std::string rName, double rMass, double rRadius,
-         Coordinate rPosition, Coordinate rVelocity,
+         Vec3d rPosition, Vec3d rVelocity,
          float rRed, float rGreen, float rBlue, float rLight)
 {
     mName           = rName;
@@ -10,7 +10,7 @@ Sun::Sun(
     mRadius         = rRadius;
     mPosition       = rPosition;
     mVelocity       = rVelocity;
-    mForce          = Coordinate(0, 0); //force starts at neutral
+    mForce          = Vec3d(0, 0); //force starts at neutral
     mRed            = rRed;
     mGreen          = rGreen;
     mBlue           = rBlue;
@@ -8,7 +8,7 @@ class Sun : public SpaceObject{
     float mLight;
     public:
     Sun(){};
-    Sun(std::string, double, double, Coordinate, Coordinate, float, float, float, float);
+    Sun(std::string, double, double, Vec3d, Vec3d, float, float, float, float);
 
 };
 
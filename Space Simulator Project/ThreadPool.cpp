@@ -0,0 +1,159 @@
+/****************************************************************************
+*   FILE: ThreadPool.cpp
+*
+*   FUNCTION: This class keeps a fixed set of worker threads alive and lets
+*   them all run the same task at once, each with its own thread index. The
+*   calling thread takes part as the thread with index 0 and the call returns
+*   when every thread has finished.
+*
+*   PURPOSE: Starting new threads every step costs more than the work of a
+*   step in small spaces. Keeping the threads waiting between steps makes it
+*   worthwhile to split even short calculations over several cores.
+*
+****************************************************************************/
+
+#include "ThreadPool.h"
+
+/****************************************************************************
+ * Constructors
+ *
+ ***************************************************************************/
+
+/**
+    Name: ThreadPool(int)
+    Function: Constructs a pool running tasks on the given amount of threads.
+    The calling thread counts as one of them, so a pool of one thread starts
+    no workers at all and simply runs tasks directly.
+**/
+ThreadPool::ThreadPool(int threadCount)
+{
+    mThreadCount    = 1;
+    mpTask          = 0;
+    mGeneration     = 0;
+    mPending        = 0;
+    mStopping       = false;
+    Start(threadCount);
+}
+
+/**
+    Name: ~ThreadPool()
+    Function: Stops and joins all worker threads.
+**/
+ThreadPool::~ThreadPool()
+{
+    Stop();
+}
+
+/****************************************************************************
+* Member Functions
+*
+****************************************************************************/
+
+/**
+    Name: Run(const std::function<void(int)>&)
+    Function: Runs the task once on every thread of the pool, with indices
+    from 0 to the thread count minus one, and returns when all are done.
+**/
+void ThreadPool::Run(const std::function<void(int)>& task)
+{
+    if(mWorkers.empty())
+    {
+        task(0);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mpTask = &task;
+        mPending = mWorkers.size();
+        mGeneration++;
+    }
+    mWake.notify_all();
+    //  the calling thread does its share of the work as thread 0
+    task(0);
+    std::unique_lock<std::mutex> lock(mMutex);
+    while(mPending > 0)
+        mDone.wait(lock);
+    mpTask = 0;
+}
+
+/**
+    Name: Work(int)
+    Function: Waits for new tasks and runs them with the given thread index
+    until the pool is stopped.
+**/
+void ThreadPool::Work(int index)
+{
+    unsigned int generation = 0;
+    while(true)
+    {
+        const std::function<void(int)>* pTask;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            while(!mStopping && mGeneration == generation)
+                mWake.wait(lock);
+            if(mStopping)
+                return;
+            generation = mGeneration;
+            pTask = mpTask;
+        }
+        (*pTask)(index);
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mPending--;
+            if(mPending == 0)
+                mDone.notify_one();
+        }
+    }
+}
+
+/**
+    Name: Start(int)
+    Function: Starts one worker thread less than the given thread count,
+    since the calling thread is the first thread of the pool.
+**/
+void ThreadPool::Start(int threadCount)
+{
+    if(threadCount < 1)
+        threadCount = 1;
+    mStopping = false;
+    mGeneration = 0;
+    mThreadCount = threadCount;
+    for(int i = 1; i < threadCount; i++)
+        mWorkers.push_back(std::thread(&ThreadPool::Work, this, i));
+}
+
+/**
+    Name: Stop()
+    Function: Wakes all worker threads up to make them return and waits for
+    them to finish.
+**/
+void ThreadPool::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mWake.notify_all();
+    for(unsigned int i = 0; i < mWorkers.size(); i++)
+        mWorkers[i].join();
+    mWorkers.clear();
+    mThreadCount = 1;
+}
+
+/****************************************************************************
+* Getters and Setters
+*
+****************************************************************************/
+
+/**
+    Name: SetThreadCount(int)
+    Function: Replaces the worker threads so that tasks run on the given
+    amount of threads.
+**/
+void ThreadPool::SetThreadCount(int threadCount)
+{
+    if(threadCount == mThreadCount)
+        return;
+    Stop();
+    Start(threadCount);
+}
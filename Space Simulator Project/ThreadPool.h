@@ -0,0 +1,67 @@
+/****************************************************************************
+*   FILE: ThreadPool.h
+*
+*   FUNCTION: This class keeps a fixed set of worker threads alive and lets
+*   them all run the same task at once, each with its own thread index. The
+*   calling thread takes part as the thread with index 0 and the call returns
+*   when every thread has finished.
+*
+*   PURPOSE: Starting new threads every step costs more than the work of a
+*   step in small spaces. Keeping the threads waiting between steps makes it
+*   worthwhile to split even short calculations over several cores.
+*
+****************************************************************************/
+
+#ifndef _ThreadPool_
+#define _ThreadPool_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool{
+    public:
+    /** Constructors    **/
+    //  constructs a pool with the given amount of threads, including the
+    //  calling thread
+    ThreadPool(int);
+    //  stops and joins all worker threads
+    ~ThreadPool();
+    /** Member Functions   **/
+    //  runs the task on every thread with the thread index as argument and
+    //  waits until all of them are done
+    void                Run(const std::function<void(int)>&);
+    /** Getters and Setters **/
+    int                 GetThreadCount()
+                            {return mThreadCount;}
+    //  replaces the worker threads with the given amount
+    void                SetThreadCount(int);
+
+    private:
+    //  the pool owns threads and can therefore not be copied
+    ThreadPool(const ThreadPool&);
+    ThreadPool&         operator=(const ThreadPool&);
+    //  the loop every worker thread runs until the pool is stopped
+    void                Work(int);
+    //  starts the worker threads
+    void                Start(int);
+    //  stops and joins the worker threads
+    void                Stop();
+
+    /** Class Members   **/
+    int                         mThreadCount;
+    std::vector<std::thread>    mWorkers;
+    std::mutex                  mMutex;
+    std::condition_variable     mWake;
+    std::condition_variable     mDone;
+    const std::function<void(int)>* mpTask;
+    //  increased every time a new task is handed out
+    unsigned int                mGeneration;
+    //  the amount of worker threads still running the current task
+    int                         mPending;
+    bool                        mStopping;
+};
+
+#endif
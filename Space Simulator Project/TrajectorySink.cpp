@@ -0,0 +1,508 @@
+/****************************************************************************
+*   FILE: TrajectorySink.cpp
+*
+*   FUNCTION: This class writes the trajectories of the bodies in a space to
+*   a file while it is being stepped. Every given amount of steps a frame
+*   with the position and velocity of every given body is recorded. Frames
+*   are gathered into chunks, which are handed over to a writer thread
+*   through a queue of a fixed length, and the writer stores every chunk
+*   column by column, optionally compressed.
+*
+*   PURPOSE: Without it the only way to see the orbits is to watch the
+*   window, and they cannot be studied afterwards. Writing a file from the
+*   step loop would make every step wait for the disk, so the step loop
+*   only copies the numbers and the writer does the rest. A full queue
+*   makes the step loop wait instead of using ever more memory. Recording
+*   only every so many steps and bodies keeps the files of long runs small.
+*
+*   FORMAT: All numbers are in the byte order of the machine that wrote the
+*   file. A 64 byte header holds "SPACETRJ", the version, the number
+*   0x01020304, the flags (1 when compressed), the steps between frames and
+*   the bodies between recorded bodies. Every chunk that follows starts
+*   with an 80 byte header holding the amount of frames and bodies, the
+*   size of the names and the stored size of each of the eight columns:
+*   the step and the simulated seconds of every frame, then x, y, z, vx,
+*   vy and vz, all as doubles. The columns follow in that order, then the
+*   names of the bodies, each ended by a newline. A body column holds all
+*   frames of the first body, then of the second and so on. Compressed
+*   columns are encoded in three stages: the bits of every value minus
+*   those of the value before it of the same body, as 64 bit integers,
+*   then the lowest byte of all these, the next byte of all of them and so
+*   on, and last runs of zero bytes: a varint count of literal bytes, the
+*   literals and a varint count of zero bytes, repeated until the end of
+*   the column.
+*
+****************************************************************************/
+
+#include "TrajectorySink.h"
+#include <stdint.h>
+#include <string.h>
+
+//  the first bytes of every trajectory file
+const char MAGIC[8] = {'S', 'P', 'A', 'C', 'E', 'T', 'R', 'J'};
+//  the version of the format, increased whenever the layout changes
+const uint32_t VERSION = 2;
+//  written as a number, read back in another byte order it differs
+const uint32_t ORDER_MARK = 0x01020304;
+//  the flag set in the header when the columns are compressed
+const uint32_t FLAG_COMPRESSED = 1;
+//  the amount of body columns
+const int BODY_COLUMNS = 6;
+//  zero bytes in a shorter run are kept among the literals
+const size_t MIN_ZERO_RUN = 4;
+//  a chunk holds fewer frames when they would take more memory than this,
+//  since the queue can hold several of them
+const size_t MAX_CHUNK_BYTES = 64 << 20;
+
+//  the start of every trajectory file
+struct TrajectoryHeader{
+    char                magic[8];
+    uint32_t            version;
+    uint32_t            orderMark;
+    uint32_t            flags;
+    uint32_t            interval;
+    uint32_t            stride;
+    uint32_t            reserved;
+    char                padding[32];
+};
+
+//  the start of every chunk
+struct TrajectoryChunkHeader{
+    uint32_t            frameCount;
+    uint32_t            bodyCount;
+    uint64_t            namesSize;
+    //  the stored size of the step, time, x, y, z, vx, vy and vz columns
+    uint64_t            columnSizes[8];
+};
+
+/**
+    Name: PutVarint(std::vector<unsigned char>&, size_t)
+    Function: Appends the number to the vector seven bits at a time, lowest
+    first, with the high bit set on every byte but the last.
+**/
+static void PutVarint(std::vector<unsigned char>& out, size_t value)
+{
+    while(value >= 0x80)
+    {
+        out.push_back((unsigned char)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((unsigned char)value);
+}
+
+/****************************************************************************
+ * Constructors
+ *
+ ***************************************************************************/
+
+/**
+    Name: TrajectorySink()
+    Function: Constructs a sink that records every body after every step,
+    in chunks of 64 frames with up to 4 chunks waiting to be written,
+    uncompressed. Nothing is recorded until a file is opened.
+**/
+TrajectorySink::TrajectorySink()
+{
+    mpFile          = 0;
+    mInterval       = 1;
+    mStride         = 1;
+    mChunkFrames    = 64;
+    mQueueLength    = 4;
+    mCompress       = false;
+    mSteps          = 0;
+    mElapsed        = 0;
+    mFrames         = 0;
+    mStalls         = 0;
+    mpChunk         = 0;
+    mClosing        = false;
+    mFailed         = false;
+    mRawBytes       = 0;
+    mWrittenBytes   = 0;
+}
+
+/**
+    Name: ~TrajectorySink()
+    Function: Writes what is left and closes the file.
+**/
+TrajectorySink::~TrajectorySink()
+{
+    Close();
+}
+
+/****************************************************************************
+* Member Functions
+*
+****************************************************************************/
+
+/**
+    Name: Open(const std::string&)
+    Function: Closes the file that is open, opens the named file, writes
+    its header and starts the writer thread. The steps and seconds are
+    counted from zero again. Returns false if the file could not be opened.
+**/
+bool TrajectorySink::Open(const std::string& path)
+{
+    Close();
+    mpFile = fopen(path.c_str(), "wb");
+    if(mpFile == 0)
+        return false;
+    TrajectoryHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version      = VERSION;
+    header.orderMark    = ORDER_MARK;
+    header.flags        = mCompress ? FLAG_COMPRESSED : 0;
+    header.interval     = mInterval;
+    header.stride       = mStride;
+    if(fwrite(&header, sizeof(header), 1, mpFile) != 1)
+    {
+        fclose(mpFile);
+        mpFile = 0;
+        return false;
+    }
+    mSteps          = 0;
+    mElapsed        = 0;
+    mFrames         = 0;
+    mStalls         = 0;
+    mClosing        = false;
+    mFailed         = false;
+    mRawBytes       = 0;
+    mWrittenBytes   = sizeof(header);
+    mThread = std::thread(&TrajectorySink::Write, this);
+    return true;
+}
+
+/**
+    Name: Close()
+    Function: Hands the frames gathered so far over to the writer, waits for
+    it to write everything and closes the file. The memory of the chunks is
+    freed. Returns false if anything could not be written.
+**/
+bool TrajectorySink::Close()
+{
+    if(mpFile == 0)
+        return !mFailed;
+    if(mpChunk != 0 && mpChunk->frameCount > 0)
+        Submit();
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mClosing = true;
+    }
+    mChanged.notify_all();
+    mThread.join();
+    if(fclose(mpFile) != 0)
+        mFailed = true;
+    mpFile = 0;
+    for(size_t i = 0; i < mChunks.size(); i++)
+        delete mChunks[i];
+    mChunks.clear();
+    mFull.clear();
+    mFree.clear();
+    mpChunk = 0;
+    return !mFailed;
+}
+
+/**
+    Name: Step(BodyStore&, double)
+    Function: Counts a step of the given amount of seconds and records a
+    frame when the amount of steps is a multiple of the interval.
+**/
+void TrajectorySink::Step(BodyStore& bodies, double time)
+{
+    mSteps++;
+    mElapsed += time;
+    if(mpFile != 0 && mSteps % mInterval == 0)
+        Record(bodies);
+}
+
+/**
+    Name: Record(BodyStore&)
+    Function: Copies the position and velocity of every recorded body into
+    the chunk being filled. A new chunk is started when the amount of
+    bodies changed, since all frames of a chunk hold the same bodies, and a
+    full chunk is handed over to the writer. Chunks of many bodies hold
+    fewer frames, to keep the memory of the queue in bounds. This is all
+    the step loop ever does, unless the queue is full.
+**/
+void TrajectorySink::Record(BodyStore& bodies)
+{
+    if(mpFile == 0)
+        return;
+    const int count = bodies.GetCount();
+    const int recorded = (count + mStride - 1)/mStride;
+    if(mpChunk != 0 && mpChunk->bodyCount != recorded)
+        Submit();
+    /*  START: Start a chunk   */
+    if(mpChunk == 0)
+    {
+        mpChunk = TakeChunk();
+        mpChunk->bodyCount = recorded;
+        mpChunk->frameCount = 0;
+        const size_t frameBytes = (size_t)BODY_COLUMNS*recorded*
+                                  sizeof(double);
+        mpChunk->frameLimit = mChunkFrames;
+        if(frameBytes*mpChunk->frameLimit > MAX_CHUNK_BYTES)
+        {
+            mpChunk->frameLimit = MAX_CHUNK_BYTES/frameBytes;
+            if(mpChunk->frameLimit < 1)
+                mpChunk->frameLimit = 1;
+        }
+        mpChunk->steps.clear();
+        mpChunk->times.clear();
+        mpChunk->values.clear();
+        mpChunk->values.reserve((size_t)BODY_COLUMNS*recorded*
+                                mpChunk->frameLimit);
+        mpChunk->names.clear();
+        for(int i = 0; i < count; i += mStride)
+        {
+            mpChunk->names += bodies.GetInfo(i).name;
+            mpChunk->names += '\n';
+        }
+    }
+    /*  END: Start a chunk */
+    /*  START: Add the frame  */
+    mpChunk->steps.push_back((double)mSteps);
+    mpChunk->times.push_back(mElapsed);
+    const double* pColumns[BODY_COLUMNS] = {bodies.GetX(), bodies.GetY(),
+                                            bodies.GetZ(), bodies.GetVx(),
+                                            bodies.GetVy(), bodies.GetVz()};
+    std::vector<double>& values = mpChunk->values;
+    for(int c = 0; c < BODY_COLUMNS; c++)
+    {
+        if(mStride == 1)
+        {
+            values.insert(values.end(), pColumns[c], pColumns[c] + count);
+        }
+        else
+        {
+            for(int i = 0; i < count; i += mStride)
+                values.push_back(pColumns[c][i]);
+        }
+    }
+    mpChunk->frameCount++;
+    mFrames++;
+    /*  END: Add the frame    */
+    if(mpChunk->frameCount >= mpChunk->frameLimit)
+        Submit();
+}
+
+/**
+    Name: TakeChunk()
+    Function: Returns a chunk that is not in use. New chunks are made until
+    there are enough for the queue, the one being filled and the one being
+    written, after which the step loop waits for the writer to free one.
+**/
+TrajectorySink::Chunk* TrajectorySink::TakeChunk()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    if(mFree.empty() && (int)mChunks.size() < mQueueLength + 2)
+    {
+        mChunks.push_back(new Chunk());
+        return mChunks.back();
+    }
+    if(mFree.empty())
+    {
+        mStalls++;
+        mChanged.wait(lock, [this](){return !mFree.empty();});
+    }
+    Chunk* pChunk = mFree.back();
+    mFree.pop_back();
+    return pChunk;
+}
+
+/**
+    Name: Submit()
+    Function: Puts the chunk being filled at the end of the queue.
+**/
+void TrajectorySink::Submit()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mFull.push_back(mpChunk);
+    }
+    mpChunk = 0;
+    mChanged.notify_all();
+}
+
+/**
+    Name: Write()
+    Function: The loop of the writer thread. Writes the chunks in the order
+    they were queued and gives them back, until the sink is closed and the
+    queue is empty. After a failed write the chunks are only given back, so
+    that the step loop never waits for a writer that stopped.
+**/
+void TrajectorySink::Write()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while(true)
+    {
+        mChanged.wait(lock, [this](){return mClosing || !mFull.empty();});
+        if(mFull.empty())
+            break;
+        Chunk* pChunk = mFull.front();
+        mFull.pop_front();
+        bool failed = mFailed;
+        long long raw = 0;
+        long long written = 0;
+        lock.unlock();
+        if(!failed)
+            failed = !WriteChunk(*pChunk, raw, written);
+        lock.lock();
+        mFailed = failed;
+        mRawBytes += raw;
+        mWrittenBytes += written;
+        mFree.push_back(pChunk);
+        mChanged.notify_all();
+    }
+}
+
+/**
+    Name: WriteChunk(Chunk&, long long&, long long&)
+    Function: Turns the frames of the chunk into columns, encodes them and
+    writes the chunk header, the columns and the names. The bodies of a
+    frame are next to each other in the chunk, while in the file the frames
+    of a body are, so the body columns are transposed first.
+**/
+bool TrajectorySink::WriteChunk(Chunk& chunk, long long& raw,
+                                long long& written)
+{
+    const int frames = chunk.frameCount;
+    const int bodies = chunk.bodyCount;
+    TrajectoryChunkHeader header;
+    memset(&header, 0, sizeof(header));
+    header.frameCount   = frames;
+    header.bodyCount    = bodies;
+    header.namesSize    = chunk.names.size();
+    mEncoded.clear();
+    /*  START: Encode the columns  */
+    size_t size = mEncoded.size();
+    Encode(&chunk.steps[0], 1, frames, mEncoded);
+    header.columnSizes[0] = mEncoded.size() - size;
+    size = mEncoded.size();
+    Encode(&chunk.times[0], 1, frames, mEncoded);
+    header.columnSizes[1] = mEncoded.size() - size;
+    mColumn.resize((size_t)bodies*frames);
+    for(int c = 0; c < BODY_COLUMNS; c++)
+    {
+        size = mEncoded.size();
+        //  a chunk without bodies has no values, and empty body columns
+        if(bodies > 0)
+        {
+            for(int f = 0; f < frames; f++)
+            {
+                const double* pFrame =
+                    &chunk.values[((size_t)f*BODY_COLUMNS + c)*bodies];
+                for(int i = 0; i < bodies; i++)
+                    mColumn[(size_t)i*frames + f] = pFrame[i];
+            }
+            Encode(&mColumn[0], bodies, frames, mEncoded);
+        }
+        header.columnSizes[2 + c] = mEncoded.size() - size;
+    }
+    /*  END: Encode the columns    */
+    raw = (long long)BODY_COLUMNS*bodies*frames*sizeof(double);
+    written = sizeof(header) + mEncoded.size() + chunk.names.size();
+    bool succeeded = fwrite(&header, sizeof(header), 1, mpFile) == 1;
+    if(!mEncoded.empty())
+        succeeded = succeeded && fwrite(&mEncoded[0], 1, mEncoded.size(),
+                                        mpFile) == mEncoded.size();
+    if(!chunk.names.empty())
+        succeeded = succeeded && fwrite(chunk.names.data(), 1,
+                                        chunk.names.size(), mpFile) ==
+                                 chunk.names.size();
+    return succeeded;
+}
+
+/**
+    Name: Encode(const double*, int, int, std::vector<unsigned char>&)
+    Function: Appends the given amount of series of the given length to the
+    vector, as they are or compressed. Positions and velocities change
+    little from one frame to the next, so the difference of their bits has
+    mostly zeros in its upper bytes. Putting the same byte of all values
+    together turns these into long runs of zeros, which are then stored as
+    a count.
+**/
+void TrajectorySink::Encode(const double* pValues, int seriesCount,
+                            int length, std::vector<unsigned char>& out)
+{
+    const size_t count = (size_t)seriesCount*length;
+    if(!mCompress)
+    {
+        const unsigned char* pBytes = (const unsigned char*)pValues;
+        out.insert(out.end(), pBytes, pBytes + count*sizeof(double));
+        return;
+    }
+    /*  START: Take the differences and shuffle the bytes    */
+    mShuffled.resize(count*sizeof(uint64_t));
+    unsigned char* pShuffled = &mShuffled[0];
+    for(int s = 0; s < seriesCount; s++)
+    {
+        uint64_t previous = 0;
+        for(int f = 0; f < length; f++)
+        {
+            const size_t i = (size_t)s*length + f;
+            uint64_t bits;
+            memcpy(&bits, &pValues[i], sizeof(bits));
+            uint64_t delta = bits - previous;
+            previous = bits;
+            for(size_t b = 0; b < sizeof(uint64_t); b++)
+                pShuffled[b*count + i] = (unsigned char)(delta >> (8*b));
+        }
+    }
+    /*  END: Take the differences and shuffle the bytes  */
+    /*  START: Store the runs of zeros as counts    */
+    const size_t size = mShuffled.size();
+    size_t i = 0;
+    while(i < size)
+    {
+        //  find the next run of zeros that is long enough
+        size_t start = i;
+        while(i < size)
+        {
+            if(pShuffled[i] != 0)
+            {
+                i++;
+                continue;
+            }
+            size_t end = i;
+            while(end < size && pShuffled[end] == 0)
+                end++;
+            if(end - i >= MIN_ZERO_RUN || end == size)
+                break;
+            i = end;
+        }
+        PutVarint(out, i - start);
+        out.insert(out.end(), pShuffled + start, pShuffled + i);
+        start = i;
+        while(i < size && pShuffled[i] == 0)
+            i++;
+        PutVarint(out, i - start);
+    }
+    /*  END: Store the runs of zeros as counts  */
+}
+
+/****************************************************************************
+* Getters and Setters
+*
+****************************************************************************/
+
+/**
+    Name: GetRawBytes()
+    Function: Returns the bytes of body positions and velocities written so
+    far, before compression.
+**/
+long long TrajectorySink::GetRawBytes()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mRawBytes;
+}
+
+/**
+    Name: GetWrittenBytes()
+    Function: Returns the bytes written to the file so far.
+**/
+long long TrajectorySink::GetWrittenBytes()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mWrittenBytes;
+}
@@ -0,0 +1,163 @@
+/****************************************************************************
+*   FILE: TrajectorySink.h
+*
+*   FUNCTION: This class writes the trajectories of the bodies in a space to
+*   a file while it is being stepped. Every given amount of steps a frame
+*   with the position and velocity of every given body is recorded. Frames
+*   are gathered into chunks, which are handed over to a writer thread
+*   through a queue of a fixed length, and the writer stores every chunk
+*   column by column, optionally compressed.
+*
+*   PURPOSE: Without it the only way to see the orbits is to watch the
+*   window, and they cannot be studied afterwards. Writing a file from the
+*   step loop would make every step wait for the disk, so the step loop
+*   only copies the numbers and the writer does the rest. A full queue
+*   makes the step loop wait instead of using ever more memory. Recording
+*   only every so many steps and bodies keeps the files of long runs small.
+*
+*   FORMAT: All numbers are in the byte order of the machine that wrote the
+*   file. A 64 byte header holds "SPACETRJ", the version, the number
+*   0x01020304, the flags (1 when compressed), the steps between frames and
+*   the bodies between recorded bodies. Every chunk that follows starts
+*   with an 80 byte header holding the amount of frames and bodies, the
+*   size of the names and the stored size of each of the eight columns:
+*   the step and the simulated seconds of every frame, then x, y, z, vx,
+*   vy and vz, all as doubles. The columns follow in that order, then the
+*   names of the bodies, each ended by a newline. A body column holds all
+*   frames of the first body, then of the second and so on. Compressed
+*   columns are encoded in three stages: the bits of every value minus
+*   those of the value before it of the same body, as 64 bit integers,
+*   then the lowest byte of all these, the next byte of all of them and so
+*   on, and last runs of zero bytes: a varint count of literal bytes, the
+*   literals and a varint count of zero bytes, repeated until the end of
+*   the column.
+*
+****************************************************************************/
+
+#ifndef _TrajectorySink_
+#define _TrajectorySink_
+
+#include "BodyStore.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+class TrajectorySink{
+    public:
+    /** Constructors    **/
+    //  constructs a sink that records every step and every body,
+    //  uncompressed, once a file is opened
+    TrajectorySink();
+    //  closes the file
+    ~TrajectorySink();
+    /** Member Functions   **/
+    //  opens the file named by the string and starts the writer, returns
+    //  false if it could not be opened
+    bool                Open(const std::string&);
+    //  writes what is left and closes the file, returns false if any of it
+    //  could not be written
+    bool                Close();
+    //  counts a step of the given amount of seconds and records a frame of
+    //  the store when it is the turn of one
+    void                Step(BodyStore&, double);
+    //  records a frame of the store right away
+    void                Record(BodyStore&);
+    /** Getters and Setters **/
+    bool                IsOpen()
+                            {return mpFile != 0;}
+    //  the settings below may only be changed while no file is open
+    int                 GetInterval()
+                            {return mInterval;}
+    void                SetInterval(int interval)
+                            {mInterval = interval > 0 ? interval : 1;}
+    int                 GetStride()
+                            {return mStride;}
+    void                SetStride(int stride)
+                            {mStride = stride > 0 ? stride : 1;}
+    int                 GetChunkFrames()
+                            {return mChunkFrames;}
+    void                SetChunkFrames(int frames)
+                            {mChunkFrames = frames > 0 ? frames : 1;}
+    int                 GetQueueLength()
+                            {return mQueueLength;}
+    void                SetQueueLength(int length)
+                            {mQueueLength = length > 0 ? length : 1;}
+    bool                GetCompress()
+                            {return mCompress;}
+    void                SetCompress(bool compress)
+                            {mCompress = compress;}
+    long long           GetFrames()
+                            {return mFrames;}
+    //  the bytes of body state recorded and the bytes written for them
+    long long           GetRawBytes();
+    long long           GetWrittenBytes();
+    //  the amount of times the step loop had to wait for the writer
+    long long           GetStalls()
+                            {return mStalls;}
+
+    private:
+    //  frames waiting to be written, with the bodies of every frame one
+    //  after the other, x first, then y, z, vx, vy and vz
+    struct Chunk{
+        int                 bodyCount;
+        int                 frameCount;
+        int                 frameLimit;
+        std::vector<double> steps;
+        std::vector<double> times;
+        std::vector<double> values;
+        std::string         names;
+    };
+
+    //  the sink owns a thread and can therefore not be copied
+    TrajectorySink(const TrajectorySink&);
+    TrajectorySink&     operator=(const TrajectorySink&);
+    //  takes a chunk that is not in use, waiting for the writer if needed
+    Chunk*              TakeChunk();
+    //  hands the chunk being filled over to the writer
+    void                Submit();
+    //  writes chunks until the sink is closed
+    void                Write();
+    //  writes one chunk to the file and adds the bytes of body state in it
+    //  and the bytes written to the integers
+    bool                WriteChunk(Chunk&, long long&, long long&);
+    //  appends the column of the given amount of series of the given
+    //  length to the vector, encoded if compressing
+    void                Encode(const double*, int, int,
+                               std::vector<unsigned char>&);
+
+    /** Class Members   **/
+    FILE*               mpFile;
+    int                 mInterval;
+    int                 mStride;
+    int                 mChunkFrames;
+    int                 mQueueLength;
+    bool                mCompress;
+    //  the steps counted and the seconds they simulated
+    long long           mSteps;
+    double              mElapsed;
+    long long           mFrames;
+    long long           mStalls;
+    //  the chunk being filled by the step loop
+    Chunk*              mpChunk;
+    //  all chunks, and the ones waiting to be written or to be filled
+    std::vector<Chunk*> mChunks;
+    std::deque<Chunk*>  mFull;
+    std::vector<Chunk*> mFree;
+    std::mutex          mMutex;
+    std::condition_variable mChanged;
+    bool                mClosing;
+    bool                mFailed;
+    long long           mRawBytes;
+    long long           mWrittenBytes;
+    std::thread         mThread;
+    //  buffers of the writer
+    std::vector<double> mColumn;
+    std::vector<unsigned char> mShuffled;
+    std::vector<unsigned char> mEncoded;
+};
+
+#endif
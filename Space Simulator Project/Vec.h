@@ -0,0 +1,169 @@
+/****************************************************************************
+*   FILE: Vec.h
+*
+*   FUNCTION: This template handles vectors of two or three components of
+*   any arithmetic type and performs the usual vector arithmetic on them.
+*   Every function is defined in the header and can be evaluated at compile
+*   time.
+*
+*   PURPOSE: The arithmetic on positions, velocities and forces is done in
+*   the innermost loops of the simulation. With the functions defined in the
+*   header, the compiler can inline them and keep the components in
+*   registers instead of calling out of line for every addition.
+*
+*   NOTES: Vec3d replaces the old two-dimensional Coordinate class. Its z
+*   component defaults to zero, so a vector built out of an x and a y lies
+*   in the plane like a coordinate used to.
+*
+****************************************************************************/
+
+#ifndef _Vec_
+#define _Vec_
+
+#include <math.h>
+
+template<int N, typename T>
+class Vec;
+
+//  a vector in the plane
+template<typename T>
+class Vec<2, T>{
+    public:
+    /** Constructors    **/
+    //  constructs the zero vector
+    constexpr Vec() : mX(0), mY(0) {}
+    //  constructs a vector out of x and y components
+    constexpr Vec(T x, T y) : mX(x), mY(y) {}
+    /** Member Functions   **/
+    //  the dot product with another vector
+    constexpr T         Dot(const Vec& other) const
+                            {return mX*other.mX + mY*other.mY;}
+    //  the squared length, which needs no square root
+    constexpr T         LengthSquared() const
+                            {return Dot(*this);}
+    //  the length of the vector as a straight line from origin
+    T                   Length() const
+                            {return sqrt(LengthSquared());}
+    /** Getters and Setters **/
+    constexpr T         GetX() const
+                            {return mX;}
+    constexpr T         GetY() const
+                            {return mY;}
+    void                SetX(T x)
+                            {mX = x;}
+    void                SetY(T y)
+                            {mY = y;}
+    /** Operator Overloads **/
+    constexpr Vec       operator+(const Vec& v) const
+                            {return Vec(mX + v.mX, mY + v.mY);}
+    constexpr Vec       operator-(const Vec& v) const
+                            {return Vec(mX - v.mX, mY - v.mY);}
+    constexpr Vec       operator-() const
+                            {return Vec(-mX, -mY);}
+    constexpr Vec       operator*(T s) const
+                            {return Vec(mX*s, mY*s);}
+    constexpr Vec       operator/(T s) const
+                            {return Vec(mX/s, mY/s);}
+    Vec&                operator+=(const Vec& v)
+                            {mX += v.mX; mY += v.mY; return *this;}
+    Vec&                operator-=(const Vec& v)
+                            {mX -= v.mX; mY -= v.mY; return *this;}
+    Vec&                operator*=(T s)
+                            {mX *= s; mY *= s; return *this;}
+    Vec&                operator/=(T s)
+                            {mX /= s; mY /= s; return *this;}
+    constexpr bool      operator==(const Vec& v) const
+                            {return mX == v.mX && mY == v.mY;}
+    constexpr bool      operator!=(const Vec& v) const
+                            {return !(*this == v);}
+
+    private:
+    /** Class Members   **/
+    T                   mX;
+    T                   mY;
+};
+
+//  a vector in space
+template<typename T>
+class Vec<3, T>{
+    public:
+    /** Constructors    **/
+    //  constructs the zero vector
+    constexpr Vec() : mX(0), mY(0), mZ(0) {}
+    //  constructs a vector out of x, y and z components, a vector built
+    //  out of x and y only lies in the plane
+    constexpr Vec(T x, T y, T z = 0) : mX(x), mY(y), mZ(z) {}
+    /** Member Functions   **/
+    //  the dot product with another vector
+    constexpr T         Dot(const Vec& other) const
+                            {return mX*other.mX + mY*other.mY + mZ*other.mZ;}
+    //  the cross product with another vector
+    constexpr Vec       Cross(const Vec& other) const
+                            {return Vec(mY*other.mZ - mZ*other.mY,
+                                        mZ*other.mX - mX*other.mZ,
+                                        mX*other.mY - mY*other.mX);}
+    //  the squared length, which needs no square root
+    constexpr T         LengthSquared() const
+                            {return Dot(*this);}
+    //  the length of the vector as a straight line from origin
+    T                   Length() const
+                            {return sqrt(LengthSquared());}
+    /** Getters and Setters **/
+    constexpr T         GetX() const
+                            {return mX;}
+    constexpr T         GetY() const
+                            {return mY;}
+    constexpr T         GetZ() const
+                            {return mZ;}
+    void                SetX(T x)
+                            {mX = x;}
+    void                SetY(T y)
+                            {mY = y;}
+    void                SetZ(T z)
+                            {mZ = z;}
+    /** Operator Overloads **/
+    constexpr Vec       operator+(const Vec& v) const
+                            {return Vec(mX + v.mX, mY + v.mY, mZ + v.mZ);}
+    constexpr Vec       operator-(const Vec& v) const
+                            {return Vec(mX - v.mX, mY - v.mY, mZ - v.mZ);}
+    constexpr Vec       operator-() const
+                            {return Vec(-mX, -mY, -mZ);}
+    constexpr Vec       operator*(T s) const
+                            {return Vec(mX*s, mY*s, mZ*s);}
+    constexpr Vec       operator/(T s) const
+                            {return Vec(mX/s, mY/s, mZ/s);}
+    Vec&                operator+=(const Vec& v)
+                            {mX += v.mX; mY += v.mY; mZ += v.mZ;
+                             return *this;}
+    Vec&                operator-=(const Vec& v)
+                            {mX -= v.mX; mY -= v.mY; mZ -= v.mZ;
+                             return *this;}
+    Vec&                operator*=(T s)
+                            {mX *= s; mY *= s; mZ *= s; return *this;}
+    Vec&                operator/=(T s)
+                            {mX /= s; mY /= s; mZ /= s; return *this;}
+    constexpr bool      operator==(const Vec& v) const
+                            {return mX == v.mX && mY == v.mY && mZ == v.mZ;}
+    constexpr bool      operator!=(const Vec& v) const
+                            {return !(*this == v);}
+
+    private:
+    /** Class Members   **/
+    T                   mX;
+    T                   mY;
+    T                   mZ;
+};
+
+//  multiplies a scalar with a vector from the left
+template<int N, typename T>
+constexpr Vec<N, T> operator*(T s, const Vec<N, T>& v)
+{
+    return v*s;
+}
+
+typedef Vec<2, float>   Vec2f;
+typedef Vec<2, double>  Vec2d;
+typedef Vec<3, float>   Vec3f;
+typedef Vec<3, double>  Vec3d;
+
+#endif
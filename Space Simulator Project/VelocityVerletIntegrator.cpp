@@ -0,0 +1,91 @@
+/****************************************************************************
+*   FILE: VelocityVerletIntegrator.cpp
+*
+*   FUNCTION: This class inherits Integrator and moves the bodies with the
+*   velocity Verlet method: every body is moved by its velocity and current
+*   acceleration, the forces are calculated at the new positions, and the
+*   velocity is changed by the average of the old and new accelerations.
+*
+*   PURPOSE: Velocity Verlet gives the same positions as leapfrog but keeps
+*   positions and velocities at the same moment in time, which is easier
+*   when the state is written out every step. It is symplectic and needs a
+*   single gravity calculation per step.
+*
+****************************************************************************/
+
+#include "VelocityVerletIntegrator.h"
+#include "Space.h"
+
+/****************************************************************************
+ * Constructors
+ *
+ ***************************************************************************/
+
+/**
+    Name: VelocityVerletIntegrator()
+    Function: Constructs an integrator that calculates the forces at the
+    start of its first step.
+**/
+VelocityVerletIntegrator::VelocityVerletIntegrator()
+{
+    mForcesValid = false;
+}
+
+/****************************************************************************
+* Member Functions
+*
+****************************************************************************/
+
+/**
+    Name: Step(Space&, double)
+    Function: Moves every body by x += v*t + a*t*t/2, keeps the old forces,
+    calculates the forces at the new positions and changes every velocity by
+    v += (a_old + a_new)*t/2. Bodies without mass only move by velocity.
+**/
+void VelocityVerletIntegrator::Step(Space& space, double time)
+{
+    BodyStore& bodies = space.GetBodies();
+    const int count = bodies.GetCount();
+    if(!mForcesValid)
+    {
+        space.ClearForces();
+        space.CalculateGravity();
+    }
+    double* pX = bodies.GetX();
+    double* pY = bodies.GetY();
+    double* pZ = bodies.GetZ();
+    double* pVx = bodies.GetVx();
+    double* pVy = bodies.GetVy();
+    double* pVz = bodies.GetVz();
+    double* pFx = bodies.GetFx();
+    double* pFy = bodies.GetFy();
+    double* pFz = bodies.GetFz();
+    const double* pMass = bodies.GetMass();
+    /*  START: Move the bodies  */
+    for(int i = 0; i < count; i++)
+    {
+        double scale = pMass[i] != 0 ? 0.5*time*time/pMass[i] : 0;
+        pX[i] += pVx[i]*time + pFx[i]*scale;
+        pY[i] += pVy[i]*time + pFy[i]*scale;
+        pZ[i] += pVz[i]*time + pFz[i]*scale;
+    }
+    mOldFx.assign(pFx, pFx + count);
+    mOldFy.assign(pFy, pFy + count);
+    mOldFz.assign(pFz, pFz + count);
+    /*  END: Move the bodies    */
+    space.ClearForces();
+    space.CalculateGravity();
+    /*  START: Change the velocities    */
+    for(int i = 0; i < count; i++)
+    {
+        if(pMass[i] != 0)
+        {
+            double scale = 0.5*time/pMass[i];
+            pVx[i] += (mOldFx[i] + pFx[i])*scale;
+            pVy[i] += (mOldFy[i] + pFy[i])*scale;
+            pVz[i] += (mOldFz[i] + pFz[i])*scale;
+        }
+    }
+    /*  END: Change the velocities  */
+    mForcesValid = true;
+}
@@ -0,0 +1,47 @@
+/****************************************************************************
+*   FILE: VelocityVerletIntegrator.h
+*
+*   FUNCTION: This class inherits Integrator and moves the bodies with the
+*   velocity Verlet method: every body is moved by its velocity and current
+*   acceleration, the forces are calculated at the new positions, and the
+*   velocity is changed by the average of the old and new accelerations.
+*
+*   PURPOSE: Velocity Verlet gives the same positions as leapfrog but keeps
+*   positions and velocities at the same moment in time, which is easier
+*   when the state is written out every step. It is symplectic and needs a
+*   single gravity calculation per step.
+*
+****************************************************************************/
+
+#ifndef _VelocityVerletIntegrator_
+#define _VelocityVerletIntegrator_
+
+#include "Integrator.h"
+#include <vector>
+
+class VelocityVerletIntegrator : public Integrator{
+    public:
+    /** Constructors    **/
+    //  constructs an integrator without any forces kept
+    VelocityVerletIntegrator();
+    /** Member Functions   **/
+    //  moves all bodies in the space forward by the given amount of seconds
+    void                Step(Space&, double);
+    //  forgets the forces kept from the previous step
+    void                Reset()
+                            {mForcesValid = false;}
+    /** Getters and Setters **/
+    const char*         GetName()
+                            {return "verlet";}
+
+    private:
+    /** Class Members   **/
+    //  true when the forces in the store belong to the current positions
+    bool                mForcesValid;
+    //  the forces at the start of the step
+    std::vector<double> mOldFx;
+    std::vector<double> mOldFy;
+    std::vector<double> mOldFz;
+};
+
+#endif
@@ -0,0 +1,457 @@
+/****************************************************************************
+*   FILE: WisdomHolmanIntegrator.cpp
+*
+*   FUNCTION: This class inherits Integrator and moves the bodies with the
+*   Wisdom-Holman map in democratic heliocentric coordinates. The heaviest
+*   star is the central body. Every other body moves along its exact Kepler
+*   orbit around the central body, and the pulls between the other bodies
+*   are added as kicks at the start and end of every step.
+*
+*   PURPOSE: In a space ruled by one star, almost all of the motion of a
+*   planet is its orbit around the star, which can be solved exactly. Only
+*   the small pulls of the other planets are left to the step, which lets
+*   the step be days long instead of minutes for the same accuracy, with a
+*   single gravity calculation per step.
+*
+****************************************************************************/
+
+#include "WisdomHolmanIntegrator.h"
+#include "Space.h"
+#include <math.h>
+
+/**
+    Name: Stumpff(double, double&, double&)
+    Function: Calculates the Stumpff functions c2 and c3 of the argument.
+    Close to zero the series is used, since the closed forms lose most of
+    their digits there.
+**/
+static void Stumpff(double x, double& c2, double& c3)
+{
+    if(x > 1)
+    {
+        double root = sqrt(x);
+        c2 = (1 - cos(root))/x;
+        c3 = (root - sin(root))/(x*root);
+    }
+    else if(x < -1)
+    {
+        double root = sqrt(-x);
+        c2 = (cosh(root) - 1)/(-x);
+        c3 = (sinh(root) - root)/(-x*root);
+    }
+    else
+    {
+        //  c2 = 1/2! - x/4! + x^2/6! ..., c3 = 1/3! - x/5! + x^2/7! ...
+        double term2 = 1.0/2.0;
+        double term3 = 1.0/6.0;
+        c2 = 0;
+        c3 = 0;
+        for(int k = 0; k < 12; k++)
+        {
+            c2 += term2;
+            c3 += term3;
+            term2 *= -x/((2*k + 3)*(2*k + 4));
+            term3 *= -x/((2*k + 4)*(2*k + 5));
+        }
+    }
+}
+
+/**
+    Name: KeplerTime(double, double, double, double, double, double&)
+    Function: Returns the time of flight along a two-body orbit to the
+    universal variable s, from the starting distance r0, the product of the
+    starting position and velocity eta, G*M and beta = 2*G*M/r0 - v^2. The
+    distance at that point is returned through the last argument.
+**/
+static double KeplerTime(double s, double r0, double eta, double mu,
+                         double beta, double& r)
+{
+    double c2, c3;
+    Stumpff(beta*s*s, c2, c3);
+    double c1 = 1 - beta*s*s*c3;
+    double c0 = 1 - beta*s*s*c2;
+    r = r0*c0 + eta*s*c1 + mu*s*s*c2;
+    return r0*s*c1 + eta*s*s*c2 + mu*s*s*s*c3;
+}
+
+/****************************************************************************
+ * Constructors
+ *
+ ***************************************************************************/
+
+/**
+    Name: WisdomHolmanIntegrator()
+    Function: Constructs an integrator that calculates the pulls at the
+    start of its first step.
+**/
+WisdomHolmanIntegrator::WisdomHolmanIntegrator()
+{
+    mAccelerationsValid = false;
+    mCentral = -1;
+}
+
+/****************************************************************************
+* Member Functions
+*
+****************************************************************************/
+
+/**
+    Name: Step(Space&, double)
+    Function: Moves all bodies forward by the given amount of seconds with
+    kick, jump, Kepler drift, jump and kick, each kick and jump for half the
+    time. The center of mass moves in a straight line. The pulls at the end
+    of a step are kept for the first kick of the next one. Without a central
+    body with mass, a plain leapfrog step is taken instead.
+**/
+void WisdomHolmanIntegrator::Step(Space& space, double time)
+{
+    const double g = 6.67428e-11;
+    BodyStore& bodies = space.GetBodies();
+    const int count = bodies.GetCount();
+    double* pX = bodies.GetX();
+    double* pY = bodies.GetY();
+    double* pZ = bodies.GetZ();
+    double* pVx = bodies.GetVx();
+    double* pVy = bodies.GetVy();
+    double* pVz = bodies.GetVz();
+    const double* pMass = bodies.GetMass();
+    int central = FindCentral(bodies);
+    if(central != mCentral)
+        mAccelerationsValid = false;
+    mCentral = central;
+    if(central < 0 || pMass[central] <= 0)
+    {
+        space.ClearForces();
+        space.CalculateGravity();
+        Integrator::Kick(bodies, time*0.5);
+        Drift(bodies, time);
+        space.ClearForces();
+        space.CalculateGravity();
+        Integrator::Kick(bodies, time*0.5);
+        mAccelerationsValid = false;
+        return;
+    }
+    if(!mAccelerationsValid)
+        CalculateInteractions(space);
+    /*  START: Change to heliocentric coordinates  */
+    double totalMass = 0;
+    double centerX = 0;
+    double centerY = 0;
+    double centerZ = 0;
+    double centerVx = 0;
+    double centerVy = 0;
+    double centerVz = 0;
+    for(int i = 0; i < count; i++)
+    {
+        totalMass += pMass[i];
+        centerX += pMass[i]*pX[i];
+        centerY += pMass[i]*pY[i];
+        centerZ += pMass[i]*pZ[i];
+        centerVx += pMass[i]*pVx[i];
+        centerVy += pMass[i]*pVy[i];
+        centerVz += pMass[i]*pVz[i];
+    }
+    centerX /= totalMass;
+    centerY /= totalMass;
+    centerZ /= totalMass;
+    centerVx /= totalMass;
+    centerVy /= totalMass;
+    centerVz /= totalMass;
+    mQx.resize(count);
+    mQy.resize(count);
+    mQz.resize(count);
+    mVx.resize(count);
+    mVy.resize(count);
+    mVz.resize(count);
+    for(int i = 0; i < count; i++)
+    {
+        mQx[i] = pX[i] - pX[central];
+        mQy[i] = pY[i] - pY[central];
+        mQz[i] = pZ[i] - pZ[central];
+        mVx[i] = pVx[i] - centerVx;
+        mVy[i] = pVy[i] - centerVy;
+        mVz[i] = pVz[i] - centerVz;
+    }
+    /*  END: Change to heliocentric coordinates    */
+    Kick(count, time*0.5);
+    Jump(pMass, count, time*0.5);
+    const double mu = g*pMass[central];
+    for(int i = 0; i < count; i++)
+    {
+        if(i == central)
+            continue;
+        Vec3d position(mQx[i], mQy[i], mQz[i]);
+        Vec3d velocity(mVx[i], mVy[i], mVz[i]);
+        KeplerDrift(mu, position, velocity, time);
+        mQx[i] = position.GetX();
+        mQy[i] = position.GetY();
+        mQz[i] = position.GetZ();
+        mVx[i] = velocity.GetX();
+        mVy[i] = velocity.GetY();
+        mVz[i] = velocity.GetZ();
+    }
+    Jump(pMass, count, time*0.5);
+    /*  START: Change back to the center of mass    */
+    centerX += centerVx*time;
+    centerY += centerVy*time;
+    centerZ += centerVz*time;
+    double shiftX = 0;
+    double shiftY = 0;
+    double shiftZ = 0;
+    for(int i = 0; i < count; i++)
+    {
+        if(i != central)
+        {
+            shiftX += pMass[i]*mQx[i];
+            shiftY += pMass[i]*mQy[i];
+            shiftZ += pMass[i]*mQz[i];
+        }
+    }
+    pX[central] = centerX - shiftX/totalMass;
+    pY[central] = centerY - shiftY/totalMass;
+    pZ[central] = centerZ - shiftZ/totalMass;
+    for(int i = 0; i < count; i++)
+    {
+        if(i != central)
+        {
+            pX[i] = pX[central] + mQx[i];
+            pY[i] = pY[central] + mQy[i];
+            pZ[i] = pZ[central] + mQz[i];
+        }
+    }
+    /*  END: Change back to the center of mass  */
+    CalculateInteractions(space);
+    Kick(count, time*0.5);
+    /*  START: Set the velocities   */
+    double momentumX = 0;
+    double momentumY = 0;
+    double momentumZ = 0;
+    for(int i = 0; i < count; i++)
+    {
+        if(i != central)
+        {
+            pVx[i] = mVx[i] + centerVx;
+            pVy[i] = mVy[i] + centerVy;
+            pVz[i] = mVz[i] + centerVz;
+            momentumX += pMass[i]*mVx[i];
+            momentumY += pMass[i]*mVy[i];
+            momentumZ += pMass[i]*mVz[i];
+        }
+    }
+    pVx[central] = centerVx - momentumX/pMass[central];
+    pVy[central] = centerVy - momentumY/pMass[central];
+    pVz[central] = centerVz - momentumZ/pMass[central];
+    /*  END: Set the velocities */
+    mAccelerationsValid = true;
+}
+
+/**
+    Name: KeplerDrift(double, Vec3d&, Vec3d&, double)
+    Function: Moves a body along the two-body orbit around a central body
+    with the given G*M, for the given time. The position and velocity are
+    relative to the central body and are changed in place. The orbit is
+    solved with universal variables, so that circles, ellipses and
+    hyperbolas are all handled the same way. The time of flight grows with
+    the universal variable s, so s is first bracketed by doubling and then
+    found with Newton's method, falling back to halving the bracket
+    whenever a Newton step leaves it or does not halve the error.
+    Ellipses are only followed for the part of the time that is left after
+    whole orbits.
+**/
+void WisdomHolmanIntegrator::KeplerDrift(double mu, Vec3d& position,
+                                         Vec3d& velocity, double time)
+{
+    double r0 = position.Length();
+    if(r0 == 0 || time == 0)
+    {
+        position += velocity*time;
+        return;
+    }
+    double eta = position.Dot(velocity);
+    double beta = 2*mu/r0 - velocity.LengthSquared();
+    //  whole orbits of an ellipse end where they started
+    double flight = time;
+    if(beta > 0)
+        flight = fmod(time, 2*3.14159265358979323846*mu/(beta*sqrt(beta)));
+    double r;
+    /*  START: Bracket the universal variable   */
+    double low = 0;
+    double high = 0;
+    double guess = fabs(flight)/r0;
+    //  far out on a hyperbola the time of flight grows exponentially
+    if(beta < 0)
+    {
+        double root = sqrt(-beta);
+        double far = log(2*(-beta)*root*fabs(flight)/mu)/root;
+        if(far > 0 && far < guess)
+            guess = far;
+    }
+    if(flight > 0)
+    {
+        high = guess;
+        while(KeplerTime(high, r0, eta, mu, beta, r) < flight)
+        {
+            low = high;
+            high *= 2;
+        }
+    }
+    else
+    {
+        low = -guess;
+        while(KeplerTime(low, r0, eta, mu, beta, r) > flight)
+        {
+            high = low;
+            low *= 2;
+        }
+    }
+    /*  END: Bracket the universal variable */
+    /*  START: Solve Kepler's equation   */
+    double s = 0.5*(low + high);
+    double lastValue = HUGE_VAL;
+    for(int iteration = 0; iteration < 200; iteration++)
+    {
+        double value = KeplerTime(s, r0, eta, mu, beta, r) - flight;
+        if(value < 0)
+            low = s;
+        else
+            high = s;
+        //  the slope of the time of flight is the distance r, Newton is
+        //  only trusted while it keeps at least halving the error
+        double next = s - value/r;
+        if(!(next > low && next < high) || fabs(value) > 0.5*lastValue)
+            next = 0.5*(low + high);
+        lastValue = fabs(value);
+        bool done = fabs(next - s) <= 1e-15*fabs(next);
+        s = next;
+        if(done)
+            break;
+    }
+    /*  END: Solve Kepler's equation */
+    double c2, c3;
+    Stumpff(beta*s*s, c2, c3);
+    double c1 = 1 - beta*s*s*c3;
+    //  only the distance at s is needed here
+    KeplerTime(s, r0, eta, mu, beta, r);
+    double f = 1 - mu*s*s*c2/r0;
+    double gt = flight - mu*s*s*s*c3;
+    double fDot = -mu*s*c1/(r*r0);
+    double gDot = 1 - mu*s*s*c2/r;
+    Vec3d newPosition = position*f + velocity*gt;
+    velocity = position*fDot + velocity*gDot;
+    position = newPosition;
+}
+
+/**
+    Name: FindCentral(BodyStore&)
+    Function: Returns the index of the heaviest star in the store. A space
+    without stars uses its heaviest body, and an empty space returns -1.
+**/
+int WisdomHolmanIntegrator::FindCentral(BodyStore& bodies)
+{
+    const double* pMass = bodies.GetMass();
+    int central = -1;
+    int heaviest = -1;
+    for(int i = 0; i < bodies.GetCount(); i++)
+    {
+        if(bodies.GetInfo(i).type == BODY_STAR &&
+           (central < 0 || pMass[i] > pMass[central]))
+            central = i;
+        if(heaviest < 0 || pMass[i] > pMass[heaviest])
+            heaviest = i;
+    }
+    return central >= 0 ? central : heaviest;
+}
+
+/**
+    Name: CalculateInteractions(Space&)
+    Function: Calculates gravity with the chosen solver of the space and
+    takes the pull of the central body back out, softened the same way,
+    which leaves the pull of all other bodies. The forces are left in the
+    store. Bodies without mass get no pull from the other bodies, like with
+    every other integrator, but still follow their orbit around the central
+    body.
+**/
+void WisdomHolmanIntegrator::CalculateInteractions(Space& space)
+{
+    const double g = 6.67428e-11;
+    BodyStore& bodies = space.GetBodies();
+    const int count = bodies.GetCount();
+    const double* pX = bodies.GetX();
+    const double* pY = bodies.GetY();
+    const double* pZ = bodies.GetZ();
+    const double* pFx = bodies.GetFx();
+    const double* pFy = bodies.GetFy();
+    const double* pFz = bodies.GetFz();
+    const double* pMass = bodies.GetMass();
+    space.ClearForces();
+    space.CalculateGravity();
+    mAx.assign(count, 0);
+    mAy.assign(count, 0);
+    mAz.assign(count, 0);
+    const double pull = g*pMass[mCentral];
+    const double softening2 = space.GetSoftening()*space.GetSoftening();
+    for(int i = 0; i < count; i++)
+    {
+        if(i == mCentral || pMass[i] == 0)
+            continue;
+        double dx = pX[mCentral] - pX[i];
+        double dy = pY[mCentral] - pY[i];
+        double dz = pZ[mCentral] - pZ[i];
+        double distance2 = dx*dx + dy*dy + dz*dz;
+        if(distance2 > 0)
+            distance2 += softening2;
+        double scale = distance2 > 0 ? pull/(distance2*sqrt(distance2)) : 0;
+        mAx[i] = pFx[i]/pMass[i] - dx*scale;
+        mAy[i] = pFy[i]/pMass[i] - dy*scale;
+        mAz[i] = pFz[i]/pMass[i] - dz*scale;
+    }
+}
+
+/**
+    Name: Kick(int, double)
+    Function: Changes the heliocentric velocity of every body except the
+    central one by its kept pull for the given time.
+**/
+void WisdomHolmanIntegrator::Kick(int count, double time)
+{
+    for(int i = 0; i < count; i++)
+    {
+        mVx[i] += mAx[i]*time;
+        mVy[i] += mAy[i]*time;
+        mVz[i] += mAz[i]*time;
+    }
+}
+
+/**
+    Name: Jump(const double*, int, double)
+    Function: Moves every body except the central one by the total momentum
+    of the other bodies divided by the mass of the central body, for the
+    given time. This is the part of the central body's own movement that
+    democratic heliocentric coordinates leave out of the Kepler orbits.
+**/
+void WisdomHolmanIntegrator::Jump(const double* pMass, int count,
+                                  double time)
+{
+    double momentumX = 0;
+    double momentumY = 0;
+    double momentumZ = 0;
+    for(int i = 0; i < count; i++)
+    {
+        if(i != mCentral)
+        {
+            momentumX += pMass[i]*mVx[i];
+            momentumY += pMass[i]*mVy[i];
+            momentumZ += pMass[i]*mVz[i];
+        }
+    }
+    double scale = time/pMass[mCentral];
+    for(int i = 0; i < count; i++)
+    {
+        if(i != mCentral)
+        {
+            mQx[i] += momentumX*scale;
+            mQy[i] += momentumY*scale;
+            mQz[i] += momentumZ*scale;
+        }
+    }
+}
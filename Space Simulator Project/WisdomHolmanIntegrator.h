@@ -0,0 +1,76 @@
+/****************************************************************************
+*   FILE: WisdomHolmanIntegrator.h
+*
+*   FUNCTION: This class inherits Integrator and moves the bodies with the
+*   Wisdom-Holman map in democratic heliocentric coordinates. The heaviest
+*   star is the central body. Every other body moves along its exact Kepler
+*   orbit around the central body, and the pulls between the other bodies
+*   are added as kicks at the start and end of every step.
+*
+*   PURPOSE: In a space ruled by one star, almost all of the motion of a
+*   planet is its orbit around the star, which can be solved exactly. Only
+*   the small pulls of the other planets are left to the step, which lets
+*   the step be days long instead of minutes for the same accuracy, with a
+*   single gravity calculation per step.
+*
+****************************************************************************/
+
+#ifndef _WisdomHolmanIntegrator_
+#define _WisdomHolmanIntegrator_
+
+#include "Integrator.h"
+#include <vector>
+
+class WisdomHolmanIntegrator : public Integrator{
+    public:
+    /** Constructors    **/
+    //  constructs an integrator without any pulls kept
+    WisdomHolmanIntegrator();
+    /** Member Functions   **/
+    //  moves all bodies in the space forward by the given amount of seconds
+    void                Step(Space&, double);
+    //  forgets the pulls kept from the previous step
+    void                Reset()
+                            {mAccelerationsValid = false;}
+    //  moves a body along its Kepler orbit around a central body with the
+    //  given G*M, relative position and velocity, for the given time
+    static void         KeplerDrift(double, Vec3d&, Vec3d&, double);
+    /** Getters and Setters **/
+    const char*         GetName()
+                            {return "wisdomholman";}
+    //  the index of the central body during the last step, -1 if there
+    //  was none
+    int                 GetCentralIndex()
+                            {return mCentral;}
+
+    private:
+    //  returns the index of the heaviest star, or of the heaviest body if
+    //  there are no stars
+    static int          FindCentral(BodyStore&);
+    //  calculates the pull on every body from all bodies except the
+    //  central body
+    void                CalculateInteractions(Space&);
+    //  changes the heliocentric velocities by the kept pulls
+    void                Kick(int, double);
+    //  moves the heliocentric positions by the momentum of all bodies
+    //  around the central body
+    void                Jump(const double*, int, double);
+
+    /** Class Members   **/
+    bool                mAccelerationsValid;
+    int                 mCentral;
+    //  the pull from the other bodies on every body, per unit of mass
+    std::vector<double> mAx;
+    std::vector<double> mAy;
+    std::vector<double> mAz;
+    //  positions relative to the central body and velocities relative to
+    //  the center of mass
+    std::vector<double> mQx;
+    std::vector<double> mQy;
+    std::vector<double> mQz;
+    std::vector<double> mVx;
+    std::vector<double> mVy;
+    std::vector<double> mVz;
+};
+
+#endif
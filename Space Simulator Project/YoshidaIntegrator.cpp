@@ -0,0 +1,47 @@
+/****************************************************************************
+*   FILE: YoshidaIntegrator.cpp
+*
+*   FUNCTION: This class inherits Integrator and moves the bodies with
+*   Yoshida's fourth order method. A step is made out of three leapfrog
+*   steps of carefully chosen lengths, one of them backwards in time, so
+*   that the errors of the three cancel out to fourth order.
+*
+*   PURPOSE: The method costs three gravity calculations per step but its
+*   error shrinks with the fourth power of the step length instead of the
+*   second. For smooth orbits that allows steps many times longer than
+*   leapfrog for the same accuracy, which means fewer gravity calculations
+*   in total.
+*
+****************************************************************************/
+
+#include "YoshidaIntegrator.h"
+#include "Space.h"
+#include <math.h>
+
+/****************************************************************************
+* Member Functions
+*
+****************************************************************************/
+
+/**
+    Name: Step(Space&, double)
+    Function: Drifts and kicks the bodies in turn with Yoshida's weights:
+    w1 = 1/(2 - 2^(1/3)) and w0 = 1 - 2*w1. The drifts are w1/2, (w0+w1)/2,
+    (w0+w1)/2 and w1/2 of the step and the kicks w1, w0 and w1 of the step.
+**/
+void YoshidaIntegrator::Step(Space& space, double time)
+{
+    const double w1 = 1/(2 - cbrt(2.0));
+    const double w0 = 1 - 2*w1;
+    const double drift[4] = {w1*0.5, (w0 + w1)*0.5, (w0 + w1)*0.5, w1*0.5};
+    const double kick[3] = {w1, w0, w1};
+    BodyStore& bodies = space.GetBodies();
+    for(int i = 0; i < 3; i++)
+    {
+        Drift(bodies, drift[i]*time);
+        space.ClearForces();
+        space.CalculateGravity();
+        Kick(bodies, kick[i]*time);
+    }
+    Drift(bodies, drift[3]*time);
+}
@@ -0,0 +1,32 @@
+/****************************************************************************
+*   FILE: YoshidaIntegrator.h
+*
+*   FUNCTION: This class inherits Integrator and moves the bodies with
+*   Yoshida's fourth order method. A step is made out of three leapfrog
+*   steps of carefully chosen lengths, one of them backwards in time, so
+*   that the errors of the three cancel out to fourth order.
+*
+*   PURPOSE: The method costs three gravity calculations per step but its
+*   error shrinks with the fourth power of the step length instead of the
+*   second. For smooth orbits that allows steps many times longer than
+*   leapfrog for the same accuracy, which means fewer gravity calculations
+*   in total.
+*
+****************************************************************************/
+
+#ifndef _YoshidaIntegrator_
+#define _YoshidaIntegrator_
+
+#include "Integrator.h"
+
+class YoshidaIntegrator : public Integrator{
+    public:
+    /** Member Functions   **/
+    //  moves all bodies in the space forward by the given amount of seconds
+    void                Step(Space&, double);
+    /** Getters and Setters **/
+    const char*         GetName()
+                            {return "yoshida";}
+};
+
+#endif
@@ -54,6 +54,9 @@
 
 #include "Draw.h"
 #include "Space.h"
+#include "Simulation.h"
+#include "Scenario.h"
+#include <stdio.h>
 
 /**
     Name: main(int, char*)
@@ -69,75 +72,26 @@ int main(int argc, char* argv[]){
     //  the argument given is how many seconds should pass per update,
     //  less seconds per update yields more accurate simulation
     Space space(150);
-    /*  START: Declare objects  */
-    Star* sun =         new Star("Sun", //name
-                                 1.9891e30, //mass
-                                 0.025,   //radius
-                                 Coordinate(0, 0), //position
-                                 Coordinate(0, 0), //velocity
-                                 1.00, 1.00, 0.00); //rgb colour
-    Planet* mercury =   new Planet("Mercury", //name
-                                   6.083e10, //mass
-                                   0.0125, //radius
-                                   Coordinate(5790906e4, 0), //position
-                                   Coordinate(0, 47870), //velocity
-                                   0.6, 0.6, 0.6); //rgb colour
-    Planet* venus =     new Planet("Venus", 4.8685e24, 0.0125,
-                                   Coordinate(1082089e5, 0),
-                                   Coordinate(0, 35020),
-                                   1.0, 0.5, 0.5);
-    Planet* earth =     new Planet("Earth", 5.9736e24, 0.0125,
-                                   Coordinate(149598261e3,  0),
-                                   Coordinate(0, 29783),
-                                   0, 1.0, 0);
-    Planet* mars =      new Planet("Mars", 4.185e23, 0.0125 ,
-                                   Coordinate(227939100e3, 0),
-                                   Coordinate(0, 24077),
-                                   1.0, 0, 0);
-    Planet* jupiter =   new Planet("Jupiter",1.8986e27, 0.0125,
-                                   Coordinate(778547200e3, 0),
-                                   Coordinate(0, 13.07e3),
-                                   0.8 ,0.4 ,0);
-    Planet* saturn =    new Planet("Saturn",8.2713e14, 0.0125,
-                                   Coordinate(1433449370e3, 0),
-                                   Coordinate(0, 9.69e3),
-                                   0.7, 0.5, 0);
-    Planet* uranus =    new Planet("Uranus",8.6810e25, 0.0125,
-                                   Coordinate(2876679082e3, 0),
-                                   Coordinate(0, 6.81e3),
-                                   0, 0, 0.8);
-    Planet* neptune =   new Planet("Neptune", 1.0243e26, 0.0125,
-                                   Coordinate(4452940833e3, 0),
-                                   Coordinate(0, 5.43e3),
-                                   0, 0, 1.0);
-    Moon* moon =        new Moon(earth, //"owner" planet
-                                 "Moon", //name
-                                 7.3477e22,  //mass
-                                 0.00625,   //radius
-                                 384399e3, //distance from owner
-                                 0.8, 0.8, 0.8); //rgb colour
-    Moon* mJupiter =    new Moon(jupiter, "Moon", 7.3477e22,
-                                 0.00625, 184399e4, 0.8, 0.8, 0.8);
-
-    /*  END: Declaration of objects */
     /*  START: Add objects to space */
-    space.AddObjectToSpace(sun);
-    space.AddObjectToSpace(mercury);
-    space.AddObjectToSpace(venus);
-    space.AddObjectToSpace(earth);
-    space.AddObjectToSpace(moon);
-    space.AddObjectToSpace(mars);
-    space.AddObjectToSpace(jupiter);
-    space.AddObjectToSpace(mJupiter);
-    space.AddObjectToSpace(saturn);
-    space.AddObjectToSpace(uranus);
-    space.AddObjectToSpace(neptune);
+    //  a scenario file can be given as the first argument, which also sets
+    //  the seconds per update
+    std::string error;
+    if(argc > 1 && !Scenario::Load(space, argv[1], error))
+    {
+        printf("%s\n", error.c_str());
+        return 1;
+    }
+    if(argc <= 1)
+        Scenario::CreateSolarSystem(space);
     /*  END: Add objects to space   */
     /*  END: Create the universe */
+    //  step the space on its own thread
+    Simulation simulation(&space);
+    simulation.Start();
     /*  START: Construct the draw object    */
     //  give the draw class object pointers to
-    //  the window to draw in and the space to draw
-    Draw * draw = new Draw(&window, &space, 10);
+    //  the window to draw in and the simulation to draw
+    Draw * draw = new Draw(&window, &simulation, 10);
     //  sets the instance to this draw
     draw->SetInstance(draw);
     /*  END: Construct the draw object  */